@@ -0,0 +1,274 @@
+/* bench-line-modes.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark for the line modes of UberGraph.  The widget is built into
+ * this program so that its private render functions can be driven directly
+ * on an offscreen UberGraph filled with a full stride of data points.  Each
+ * line mode is timed for both paths the widget takes:
+ *
+ *   full:  uber_graph_render_fg_task(), a complete foreground render as
+ *          done after a resize or a change of scale.
+ *   shift: uber_graph_render_fg_shifted_task(), the render done for every
+ *          new data point.
+ *
+ * The X-server is synchronized after each run so that work done on
+ * server-side pixmaps is included in the timings.
+ *
+ * Usage: bench-line-modes [N_LINES [WIDTH [HEIGHT [FRAMES]]]]
+ */
+
+#include "uber-graph.c"
+
+#include <stdlib.h>
+
+typedef struct
+{
+	const gchar       *name;
+	UberGraphLineMode  mode;
+	UberGraphQuality   quality;
+} Case;
+
+static const Case cases[] = {
+	{ "bezier, round caps, AA",   UBER_GRAPH_LINE_BEZIER,  UBER_GRAPH_QUALITY_FULL },
+	{ "linear, butt caps, AA",    UBER_GRAPH_LINE_LINEAR,  UBER_GRAPH_QUALITY_FULL },
+	{ "linear, butt caps, no AA", UBER_GRAPH_LINE_LINEAR,  UBER_GRAPH_QUALITY_NO_ANTIALIAS },
+	{ "step, butt caps, AA",      UBER_GRAPH_LINE_STEP,    UBER_GRAPH_QUALITY_FULL },
+	{ "step, butt caps, no AA",   UBER_GRAPH_LINE_STEP,    UBER_GRAPH_QUALITY_NO_ANTIALIAS },
+	{ "area, AA",                 UBER_GRAPH_LINE_AREA,    UBER_GRAPH_QUALITY_FULL },
+	{ "stacked, AA",              UBER_GRAPH_LINE_STACKED, UBER_GRAPH_QUALITY_FULL },
+};
+
+/**
+ * next_values:
+ * @grand: A #GRand.
+ * @values: The values of the previous data point, updated in place.
+ * @n_values: The number of elements in @values.
+ *
+ * Advances the random walk of every line by one data point.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+next_values (GRand   *grand,    /* IN */
+             gdouble *values,   /* IN/OUT */
+             gint     n_values) /* IN */
+{
+	gint i;
+
+	for (i = 0; i < n_values; i++) {
+		values[i] = CLAMP(values[i] + g_rand_double_range(grand, -10., 10.),
+		                  0., 100.);
+	}
+}
+
+/**
+ * prepare_graph:
+ * @graph: A realized #UberGraph.
+ * @c: The Case to render.
+ * @n_lines: The number of lines of @graph.
+ *
+ * Switches @graph to the line mode and quality of @c and refills every
+ * line with the same seeded random walk, so that runs can be compared.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+prepare_graph (UberGraph  *graph,   /* IN */
+               const Case *c,       /* IN */
+               gint        n_lines) /* IN */
+{
+	UberGraphPrivate *priv;
+	gdouble *values;
+	GRand *grand;
+	gint i;
+
+	priv = graph->priv;
+	uber_graph_set_line_mode(graph, c->mode);
+	uber_graph_set_quality(graph, c->quality);
+	grand = g_rand_new_with_seed(1);
+	values = g_new(gdouble, n_lines);
+	for (i = 0; i < n_lines; i++) {
+		values[i] = g_rand_double_range(grand, 0., 100.);
+	}
+	for (i = 0; i < priv->stride; i++) {
+		next_values(grand, values, n_lines);
+		uber_graph_append_values(graph, values);
+	}
+	g_free(values);
+	g_rand_free(grand);
+}
+
+/**
+ * run_full:
+ * @graph: A realized #UberGraph.
+ * @frames: The number of frames to render.
+ *
+ * Renders @frames full foregrounds after a short warm up.
+ *
+ * Returns: The mean time of a frame in microseconds.
+ * Side effects: None.
+ */
+static gdouble
+run_full (UberGraph *graph,  /* IN */
+          gint       frames) /* IN */
+{
+	UberGraphPrivate *priv;
+	gint64 begin;
+	gint i;
+
+	priv = graph->priv;
+	for (i = 0; i < MAX(1, frames / 10); i++) {
+		uber_graph_render_fg_task(graph, &priv->info[priv->flipped]);
+	}
+	gdk_flush();
+	begin = g_get_monotonic_time();
+	for (i = 0; i < frames; i++) {
+		uber_graph_render_fg_task(graph, &priv->info[priv->flipped]);
+	}
+	gdk_flush();
+	return (gdouble)(g_get_monotonic_time() - begin) / frames;
+}
+
+/**
+ * run_shift:
+ * @graph: A realized #UberGraph.
+ * @n_lines: The number of lines of @graph.
+ * @frames: The number of data points to render.
+ *
+ * Appends @frames data points, shifting the foreground for each one as the
+ * frame clock does, after a short warm up.
+ *
+ * Returns: The mean time of a data point in microseconds.
+ * Side effects: None.
+ */
+static gdouble
+run_shift (UberGraph *graph,   /* IN */
+           gint       n_lines, /* IN */
+           gint       frames)  /* IN */
+{
+	UberGraphPrivate *priv;
+	gdouble *values;
+	GRand *grand;
+	gint64 begin;
+	gint64 spent = 0;
+	gint i;
+
+	priv = graph->priv;
+	grand = g_rand_new_with_seed(2);
+	values = g_new0(gdouble, n_lines);
+	uber_graph_render_fg_task(graph, &priv->info[priv->flipped]);
+	for (i = 0; i < frames + MAX(1, frames / 10); i++) {
+		/*
+		 * Only the render is timed, not the bookkeeping of the new values.
+		 */
+		next_values(grand, values, n_lines);
+		uber_graph_append_values(graph, values);
+		if (i == MAX(1, frames / 10)) {
+			gdk_flush();
+			spent = 0;
+		}
+		begin = g_get_monotonic_time();
+		uber_graph_render_fg_shifted_task(graph,
+		                                  &priv->info[priv->flipped],
+		                                  &priv->info[!priv->flipped]);
+		priv->flipped = !priv->flipped;
+		spent += g_get_monotonic_time() - begin;
+	}
+	begin = g_get_monotonic_time();
+	gdk_flush();
+	spent += g_get_monotonic_time() - begin;
+	g_free(values);
+	g_rand_free(grand);
+	return (gdouble)spent / frames;
+}
+
+gint
+main (gint   argc,   /* IN */
+      gchar *argv[]) /* IN */
+{
+	UberGraphPrivate *priv;
+	UberRange range = { 0., 100., 100. };
+	GtkWidget *window;
+	GtkWidget *graph;
+	gdouble full;
+	gdouble shift;
+	gdouble base_full = 0.;
+	gdouble base_shift = 0.;
+	gint n_lines = 4;
+	gint width = 600;
+	gint height = 120;
+	gint frames = 500;
+	gint i;
+
+	g_thread_init(NULL);
+	gtk_init(&argc, &argv);
+	if (argc > 1) {
+		n_lines = MAX(1, atoi(argv[1]));
+	}
+	if (argc > 2) {
+		width = MAX(64, atoi(argv[2]));
+	}
+	if (argc > 3) {
+		height = MAX(64, atoi(argv[3]));
+	}
+	if (argc > 4) {
+		frames = MAX(1, atoi(argv[4]));
+	}
+	/*
+	 * Realize the graph offscreen, then build its textures directly since
+	 * an offscreen window may never be considered viewable.
+	 */
+	window = gtk_offscreen_window_new();
+	graph = uber_graph_new();
+	gtk_widget_set_size_request(graph, width, height);
+	gtk_container_add(GTK_CONTAINER(window), graph);
+	uber_graph_set_frame_budget(UBER_GRAPH(graph), 0);
+	uber_graph_set_yautoscale(UBER_GRAPH(graph), FALSE);
+	uber_graph_set_yrange(UBER_GRAPH(graph), &range);
+	for (i = 0; i < n_lines; i++) {
+		uber_graph_add_line(UBER_GRAPH(graph));
+	}
+	gtk_widget_show_all(window);
+	while (gtk_events_pending()) {
+		gtk_main_iteration();
+	}
+	priv = UBER_GRAPH(graph)->priv;
+	uber_graph_calculate_rects(UBER_GRAPH(graph));
+	uber_graph_init_graph_info(UBER_GRAPH(graph), &priv->info[0]);
+	uber_graph_init_graph_info(UBER_GRAPH(graph), &priv->info[1]);
+	g_print("%d lines, %d points, %dx%d, %d frames, %s textures\n",
+	        n_lines, priv->stride, width, height, frames,
+	        priv->have_rgba ? "server-side" : "client-side");
+	g_print("%-26s %16s %16s\n", "", "full usec/frame", "shift usec/point");
+	for (i = 0; i < G_N_ELEMENTS(cases); i++) {
+		prepare_graph(UBER_GRAPH(graph), &cases[i], n_lines);
+		full = run_full(UBER_GRAPH(graph), frames);
+		shift = run_shift(UBER_GRAPH(graph), n_lines, frames);
+		if (i == 0) {
+			base_full = full;
+			base_shift = shift;
+		}
+		g_print("%-26s %9.1f %5.2fx %9.1f %5.2fx\n", cases[i].name,
+		        full, base_full / full, shift, base_shift / shift);
+	}
+	gtk_widget_destroy(window);
+	return EXIT_SUCCESS;
+}
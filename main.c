@@ -44,6 +44,7 @@
 #include <linux/blktrace_api.h>
 
 #include "uber-graph.h"
+#include "uber-graph-grid.h"
 #include "uber-label.h"
 #include "uber-buffer.h"
 #include "uber-heat-map.h"
@@ -54,6 +55,9 @@
 #define DEBUG(f,...) g_debug(f, ## __VA_ARGS__)
 #endif
 
+#define STACKED_CPUS 8
+#define HEAT_MAP_CPUS 64
+
 typedef struct
 {
 	volatile gdouble swapFree;
@@ -64,6 +68,7 @@ typedef struct
 {
 	volatile gdouble  cpuUsage;  /* Total cpu */
 	volatile gdouble *cpusUsage; /* Per cpu */
+	volatile gint64   timestamp; /* When /proc/stat was read */
 } CpuInfo;
 
 typedef struct
@@ -118,6 +123,14 @@ static IoLatInfo  iolat_info = { 0 };
 static GtkWidget *load_graph = NULL;
 static GtkWidget *cpu_graph  = NULL;
 static GtkWidget *cpu_label_hbox = NULL;
+static GtkWidget *cpu_heat_map = NULL;
+static gint       n_cpus     = 0;
+static gint      *cpu_ids    = NULL;
+static gint      *cpu_index  = NULL;
+static gint       n_cpu_index = 0;
+static gint      *cpu_rows   = NULL;
+static gdouble   *cpu_row_values = NULL;
+static gint       n_cpu_rows = 0;
 static GtkWidget *net_label_hbox = NULL;
 static GtkWidget *mem_label_hbox = NULL;
 static GtkWidget *load_label_hbox = NULL;
@@ -145,30 +158,98 @@ static const gchar* cpu_colors[] = {
 
 static gboolean
 get_cpu (UberGraph *graph,
-         gint       line,
-         gdouble   *value,
+         gdouble   *values,
+         guint      n_values,
+         gint64    *timestamp,
          gpointer   user_data)
 {
 	UberLabel *label;
-	gint i = line - 1;
-	gchar *str;
+	gdouble scale = 1.;
+	gchar str[32];
+	gint i;
 
-#if 0
-	if (line == 1) {
-		*value = cpu_info.cpuUsage;
-	} else {
-		*value = cpu_info.cpusUsage[line - 2];
+	/*
+	 * The sampler runs on its own schedule; draw the values at the time
+	 * they were read.
+	 */
+	if (cpu_info.timestamp) {
+		*timestamp = cpu_info.timestamp;
 	}
-#endif
+	/*
+	 * The heat map shows each core, so only the total is graphed.
+	 */
+	if (cpu_heat_map) {
+		values[0] = cpu_info.cpuUsage;
+		g_snprintf(str, sizeof str, "Total CPU  %.1f%%", cpu_info.cpuUsage);
+		uber_label_set_text(g_ptr_array_index(labels, 0), str);
+		return TRUE;
+	}
+	/*
+	 * Stacked cores share the 0-100% range of the whole machine.
+	 */
+	if (uber_graph_get_line_mode(graph) == UBER_GRAPH_LINE_STACKED) {
+		scale = 1. / n_cpus;
+	}
+	n_values = MIN(n_values, labels->len);
+	for (i = 0; i < n_values; i++) {
+		values[i] = cpu_info.cpusUsage[i] * scale;
+	}
+	/*
+	 * Update all of the labels once per frame while we are here.
+	 */
+	for (i = 0; i < n_values; i++) {
+		g_snprintf(str, sizeof str, "CPU%d  %.1f%%", cpu_ids[i] + 1,
+		           cpu_info.cpusUsage[i]);
+		label = g_ptr_array_index(labels, i);
+		uber_label_set_text(label, str);
+	}
+	return TRUE;
+}
+
+static gboolean
+get_cpu_grid (UberGraphGrid *grid,
+              gdouble       *values,
+              guint          n_values,
+              gpointer       user_data)
+{
+	gint i;
 
-	*value = cpu_info.cpusUsage[i];
-	str = g_strdup_printf("CPU%d  %.1f%%", i + 1, cpu_info.cpusUsage[i]);
-	label = g_ptr_array_index(labels, i);
-	uber_label_set_text(label, str);
-	g_free(str);
+	n_values = MIN(n_values, n_cpus);
+	for (i = 0; i < n_values; i++) {
+		values[i] = cpu_info.cpusUsage[i];
+	}
 	return TRUE;
 }
 
+static gboolean
+get_cpu_heat (UberHeatMap  *map,
+              GArray      **values,
+              gpointer      user_data)
+{
+	gint i;
+
+	/*
+	 * One row per core, ordered by topology.  The rows are copied into the
+	 * column being collected, so nothing is allocated per tick.
+	 */
+	for (i = 0; i < n_cpu_rows; i++) {
+		cpu_row_values[i] = cpu_info.cpusUsage[cpu_rows[i]];
+	}
+	uber_heat_map_set_column(map, cpu_row_values, n_cpu_rows);
+	return FALSE;
+}
+
+static gchar*
+format_cpu_heat (UberHeatMap     *map,
+                 gint             column,
+                 gint             row,
+                 const UberRange *range,
+                 gdouble          value,
+                 gpointer         user_data)
+{
+	return g_strdup_printf("CPU%d  %.1f%%", cpu_ids[cpu_rows[row]] + 1, value);
+}
+
 static gboolean
 get_mem (UberGraph *graph,
          gint       line,
@@ -250,17 +331,36 @@ get_iolat (UberHeatMap  *map,
            GArray      **values,
            gpointer      user_data)
 {
-	GArray *v, *sum;
-	
-	sum = g_array_sized_new(FALSE, TRUE, sizeof(gint), 1 /* map->nbucket */);
+	GArray *v;
+	gdouble *us;
+	gint i;
 
-	while((v = g_async_queue_try_pop((GAsyncQueue *)iolat_info.q)) != NULL) {
-		if (g_async_queue_length((GAsyncQueue *)iolat_info.q) == 0)
-			break;
+	/*
+	 * Push every completion latency collected since the last column, in
+	 * microseconds.  The heat map buckets them itself.
+	 */
+	while ((v = g_async_queue_try_pop((GAsyncQueue *)iolat_info.q)) != NULL) {
+		us = g_new(gdouble, v->len);
+		for (i = 0; i < v->len; i++) {
+			us[i] = g_array_index(v, gint, i) / 1000.;
+		}
+		uber_heat_map_push_many(map, us, v->len);
 		g_array_unref(v);
+		g_free(us);
 	}
-	*values = sum;
-	return !!v;
+	return FALSE;
+}
+
+static gchar*
+format_iolat (UberHeatMap     *map,
+              gint             column,
+              gint             row,
+              const UberRange *range,
+              gdouble          value,
+              gpointer         user_data)
+{
+	return g_strdup_printf("%.0f - %.0f us\n%.0f completions",
+	                       range->begin, range->end, value);
 }
 
 static gboolean
@@ -362,26 +462,42 @@ next_cpu (void)
 	static gboolean initialized = FALSE;
 	static gfloat u1, n1, s1, i1;
 	static gfloat *_u1, *_n1, *_s1, *_i1;
+	static gchar *buf;
+	static gsize buf_len = 4096;
 	gfloat u2, n2, s2, i2;
 	gfloat u3, n3, s3, i3;
 	gdouble total;
 	int fd;
-	char buf[4096];
 	char *line;
+	gssize r;
+	gsize len = 0;
 	gint i;
+	gint id;
 	gint cpu;
 
 	if (!initialized) {
-		cpu_info.cpusUsage = g_new0(gdouble, get_nprocs());
-		_u1 = g_new0(gfloat, get_nprocs());
-		_n1 = g_new0(gfloat, get_nprocs());
-		_s1 = g_new0(gfloat, get_nprocs());
-		_i1 = g_new0(gfloat, get_nprocs());
+		cpu_info.cpusUsage = g_new0(gdouble, n_cpus);
+		_u1 = g_new0(gfloat, n_cpus);
+		_n1 = g_new0(gfloat, n_cpus);
+		_s1 = g_new0(gfloat, n_cpus);
+		_i1 = g_new0(gfloat, n_cpus);
+		buf = g_malloc(buf_len);
 	}
 
+	/*
+	 * There is a line per core, so grow the buffer until it holds the
+	 * whole file.  It is kept for the next sample.
+	 */
 	fd = open("/proc/stat", O_RDONLY);
-	i = read(fd, buf, sizeof(buf));
-	buf[i - 1] = '\0';
+	while ((r = read(fd, buf + len, buf_len - len - 1)) > 0) {
+		len += r;
+		if (len == buf_len - 1) {
+			buf_len *= 2;
+			buf = g_realloc(buf, buf_len);
+		}
+	}
+	buf[len] = '\0';
+	cpu_info.timestamp = g_get_monotonic_time();
 	line = buf;
 	for (i = 0; buf[i]; i++) {
 		if (buf[i] == '\n') {
@@ -408,9 +524,12 @@ next_cpu (void)
 				}
 			} else if (strncmp(line, "cpu", 3) == 0) {
 				line += 3;
-				cpu = strtoll(line, &line, 10);
-				if (sscanf(line, "%f %f %f %f", &u2, &n2, &s2, &i2) != 4) {
-					g_warning("Failed to read cpu %d line.", cpu);
+				id = strtoll(line, &line, 10);
+				cpu = (id >= 0 && id < n_cpu_index) ? cpu_index[id] : -1;
+				if (cpu < 0) {
+					/* Not online when we started. */
+				} else if (sscanf(line, "%f %f %f %f", &u2, &n2, &s2, &i2) != 4) {
+					g_warning("Failed to read cpu %d line.", id);
 					break;
 				} else {
 					u3 = (u2 - _u1[cpu]);
@@ -653,6 +772,156 @@ next_threads (void)
 	thread_info.n_threads = n_threads;
 }
 
+static gint
+read_sysfs_int (const gchar *path,
+                gint         default_value)
+{
+	gchar *contents = NULL;
+	gint value = default_value;
+
+	if (g_file_get_contents(path, &contents, NULL, NULL)) {
+		value = strtol(contents, NULL, 10);
+		g_free(contents);
+	}
+	return value;
+}
+
+static void
+setup_cpus (void)
+{
+	GArray *ids;
+	gchar *contents = NULL;
+	gchar *p;
+	gint first;
+	gint last;
+	gint i;
+
+	/*
+	 * Processor ids have holes once cores are taken offline, so read the
+	 * ranges of online processors, such as "0-3,8-11".
+	 */
+	ids = g_array_new(FALSE, FALSE, sizeof(gint));
+	if (g_file_get_contents("/sys/devices/system/cpu/online", &contents,
+	                        NULL, NULL)) {
+		p = contents;
+		while (g_ascii_isdigit(*p)) {
+			first = last = strtol(p, &p, 10);
+			if (*p == '-') {
+				last = strtol(p + 1, &p, 10);
+			}
+			for (i = first; i <= last; i++) {
+				g_array_append_val(ids, i);
+			}
+			if (*p == ',') {
+				p++;
+			}
+		}
+		g_free(contents);
+	}
+	if (!ids->len) {
+		for (i = 0; i < get_nprocs(); i++) {
+			g_array_append_val(ids, i);
+		}
+	}
+	/*
+	 * Processors are shown and sampled by their index in the list.
+	 */
+	n_cpus = ids->len;
+	cpu_ids = (gint *)g_array_free(ids, FALSE);
+	n_cpu_index = cpu_ids[n_cpus - 1] + 1;
+	cpu_index = g_new(gint, n_cpu_index);
+	for (i = 0; i < n_cpu_index; i++) {
+		cpu_index[i] = -1;
+	}
+	for (i = 0; i < n_cpus; i++) {
+		cpu_index[cpu_ids[i]] = i;
+	}
+}
+
+static gint
+get_cpu_node (gint cpu)
+{
+	const gchar *name;
+	gchar *path;
+	GDir *dir;
+	gint node = 0;
+
+	/*
+	 * Each core links to its NUMA node as cpuN/nodeM.
+	 */
+	path = g_strdup_printf("/sys/devices/system/cpu/cpu%d", cpu);
+	if ((dir = g_dir_open(path, 0, NULL))) {
+		while ((name = g_dir_read_name(dir))) {
+			if (g_str_has_prefix(name, "node")) {
+				node = strtol(name + 4, NULL, 10);
+				break;
+			}
+		}
+		g_dir_close(dir);
+	}
+	g_free(path);
+	return node;
+}
+
+static gint
+compare_cpu_rows (gconstpointer a,
+                  gconstpointer b,
+                  gpointer      user_data)
+{
+	const gint *keys = user_data;
+	gint cpu_a = *(const gint *)a;
+	gint cpu_b = *(const gint *)b;
+
+	if (keys[cpu_a] != keys[cpu_b]) {
+		return keys[cpu_a] - keys[cpu_b];
+	}
+	return cpu_a - cpu_b;
+}
+
+static GArray*
+setup_cpu_rows (void)
+{
+	GArray *sizes;
+	gboolean numa = FALSE;
+	gchar *path;
+	gint *nodes;
+	gint *packages;
+	gint *keys;
+	gint i;
+
+	n_cpu_rows = n_cpus;
+	cpu_rows = g_new(gint, n_cpu_rows);
+	cpu_row_values = g_new0(gdouble, n_cpu_rows);
+	nodes = g_new(gint, n_cpu_rows);
+	packages = g_new(gint, n_cpu_rows);
+	for (i = 0; i < n_cpu_rows; i++) {
+		cpu_rows[i] = i;
+		nodes[i] = get_cpu_node(cpu_ids[i]);
+		path = g_strdup_printf("/sys/devices/system/cpu/cpu%d/topology/"
+		                       "physical_package_id", cpu_ids[i]);
+		packages[i] = read_sysfs_int(path, 0);
+		g_free(path);
+		numa |= (nodes[i] != nodes[0]);
+	}
+	/*
+	 * Keep the cores of each NUMA node together, or of each socket if
+	 * there is a single node, and count the rows of each group.
+	 */
+	keys = numa ? nodes : packages;
+	g_qsort_with_data(cpu_rows, n_cpu_rows, sizeof(gint),
+	                  compare_cpu_rows, keys);
+	sizes = g_array_new(FALSE, TRUE, sizeof(guint));
+	for (i = 0; i < n_cpu_rows; i++) {
+		if (!i || keys[cpu_rows[i]] != keys[cpu_rows[i - 1]]) {
+			g_array_set_size(sizes, sizes->len + 1);
+		}
+		g_array_index(sizes, guint, sizes->len - 1)++;
+	}
+	g_free(nodes);
+	g_free(packages);
+	return sizes;
+}
+
 static int	blktrace_fd = -1;
 static GPid	blktrace_pid;
 
@@ -971,13 +1240,22 @@ create_main_window (void)
 	GtkWidget *hbox;
 	GtkWidget *label;
 	GtkWidget *group;
+	GtkWidget *cpu_grid;
+	GArray *sizes;
 #if 1
 	GtkWidget *heat;
 	GtkWidget *heat2;
 #endif
 	UberRange cpu_range = { 0., 100., 100. };
+	UberRange iolat_range = { 10., 1000000., 999990. };
+	gint n_lines;
 	gint i;
 
+	/*
+	 * The online processors are used throughout; look them up once.
+	 */
+	setup_cpus();
+
 	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
 	gtk_container_set_border_width(GTK_CONTAINER(window), 12);
 	gtk_window_set_title(GTK_WINDOW(window), _("UberGraph"));
@@ -1017,23 +1295,80 @@ create_main_window (void)
 	uber_graph_set_yrange(UBER_GRAPH(cpu_graph), &cpu_range);
 	//uber_graph_add_line(UBER_GRAPH(cpu_graph));
 	//SET_LINE_COLOR(cpu_graph, 1, "#2e3436");
-	uber_graph_set_value_func(UBER_GRAPH(cpu_graph), get_cpu, NULL, NULL);
+	uber_graph_set_values_func(UBER_GRAPH(cpu_graph), get_cpu, NULL, NULL);
+	if (n_cpus > STACKED_CPUS && n_cpus <= HEAT_MAP_CPUS) {
+		uber_graph_set_line_mode(UBER_GRAPH(cpu_graph),
+		                         UBER_GRAPH_LINE_STACKED);
+	}
 
 	hbox = new_label_container();
 	gtk_box_pack_start(GTK_BOX(group), gtk_widget_get_parent(hbox), FALSE, TRUE, 0);
 	//add_label(hbox, "Total CPU", "#2e3436");
-	for (i = 1; i <= get_nprocs(); i++) {
-		char *text = g_strdup_printf("CPU%d", i);
+	n_lines = (n_cpus <= HEAT_MAP_CPUS) ? n_cpus : 0;
+	for (i = 1; i <= n_lines; i++) {
+		char *text = g_strdup_printf("CPU%d", cpu_ids[i - 1] + 1);
 
 		uber_graph_add_line(UBER_GRAPH(cpu_graph));
 		SET_LINE_COLOR(cpu_graph, i, (gchar *)cpu_colors[(i-1) % G_N_ELEMENTS(cpu_colors)]);
 		label = add_label(hbox, text, (gchar *)cpu_colors[(i-1) % G_N_ELEMENTS(cpu_colors)]);
 		uber_label_bind_graph(UBER_LABEL(label), UBER_GRAPH(cpu_graph), i);
+		uber_label_set_max_rate(UBER_LABEL(label), 2);
+		if (n_cpus <= STACKED_CPUS) {
+			uber_label_set_show_sparkline(UBER_LABEL(label), TRUE);
+		}
 		g_ptr_array_add(labels, label);
 		g_free(text);
 	}
 	gtk_widget_show(hbox);
 	cpu_label_hbox = hbox;
+	/*
+	 * Too many cores to tell apart.  Graph the total and show each core
+	 * as a row of a heat map, grouped by topology.
+	 */
+	if (n_cpus > HEAT_MAP_CPUS) {
+		uber_graph_add_line(UBER_GRAPH(cpu_graph));
+		SET_LINE_COLOR(cpu_graph, 1, "#2e3436");
+		label = add_label(hbox, "Total CPU", "#2e3436");
+		uber_label_bind_graph(UBER_LABEL(label), UBER_GRAPH(cpu_graph), 1);
+		uber_label_set_max_rate(UBER_LABEL(label), 2);
+		g_ptr_array_add(labels, label);
+
+		cpu_heat_map = uber_heat_map_new();
+		uber_heat_map_set_block_size(UBER_HEAT_MAP(cpu_heat_map),
+		                             60, TRUE,
+		                             n_cpus, TRUE);
+		uber_heat_map_set_normalize(UBER_HEAT_MAP(cpu_heat_map),
+		                            UBER_HEAT_MAP_NORMALIZE_FIXED);
+		uber_heat_map_set_max_value(UBER_HEAT_MAP(cpu_heat_map), 100.);
+		sizes = setup_cpu_rows();
+		uber_heat_map_set_n_buckets(UBER_HEAT_MAP(cpu_heat_map), n_cpu_rows);
+		uber_heat_map_set_row_groups(UBER_HEAT_MAP(cpu_heat_map),
+		                             (guint *)sizes->data, sizes->len);
+		g_array_unref(sizes);
+		uber_heat_map_set_value_func(UBER_HEAT_MAP(cpu_heat_map),
+		                             get_cpu_heat, NULL, NULL);
+		uber_heat_map_set_format_func(UBER_HEAT_MAP(cpu_heat_map),
+		                              format_cpu_heat, NULL, NULL);
+		gtk_box_pack_start(GTK_BOX(group), cpu_heat_map, TRUE, TRUE, 0);
+		gtk_widget_show(cpu_heat_map);
+	}
+	/*
+	 * Many cores are easier to follow as small multiples.
+	 */
+	if (n_cpus > STACKED_CPUS && n_cpus <= HEAT_MAP_CPUS) {
+		cpu_grid = uber_graph_grid_new();
+		uber_graph_grid_set_n_cells(UBER_GRAPH_GRID(cpu_grid), n_cpus);
+		for (i = 0; i < n_cpus; i++) {
+			char *text = g_strdup_printf("%d", cpu_ids[i] + 1);
+
+			uber_graph_grid_set_cell_label(UBER_GRAPH_GRID(cpu_grid), i, text);
+			g_free(text);
+		}
+		uber_graph_grid_set_values_func(UBER_GRAPH_GRID(cpu_grid),
+		                                get_cpu_grid, NULL, NULL);
+		gtk_box_pack_start(GTK_BOX(group), cpu_grid, TRUE, TRUE, 0);
+		gtk_widget_show(cpu_grid);
+	}
 
 	group = gtk_vbox_new(FALSE, 3);
 	hbox = gtk_hbox_new(FALSE, 3);
@@ -1140,7 +1475,18 @@ create_main_window (void)
 	uber_heat_map_set_block_size(UBER_HEAT_MAP(heat),
 	                             60, TRUE,
 	                             5, FALSE);
+	uber_heat_map_set_y_range(UBER_HEAT_MAP(heat), &iolat_range);
+	uber_heat_map_set_scale(UBER_HEAT_MAP(heat), UBER_HEAT_MAP_SCALE_LOG10);
+	/*
+	 * Four buckets per decade.
+	 */
+	uber_heat_map_set_n_buckets(UBER_HEAT_MAP(heat), 20);
 	uber_heat_map_set_value_func(UBER_HEAT_MAP(heat), get_iolat, NULL, NULL);
+	uber_heat_map_set_format_func(UBER_HEAT_MAP(heat), format_iolat, NULL, NULL);
+	/*
+	 * Start with an overview of the last minutes; drag to zoom in.
+	 */
+	uber_heat_map_set_zoom(UBER_HEAT_MAP(heat), 3, 0);
 	gtk_container_add(GTK_CONTAINER(vbox), heat);
 	gtk_widget_show(heat);
 
@@ -0,0 +1,621 @@
+/* uber-frame-clock.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "uber-frame-clock.h"
+
+#define MAX_FPS (60)
+
+/**
+ * SECTION:uber-frame-clock
+ * @title: UberFrameClock
+ * @short_description: Process-wide frame scheduler for realtime widgets.
+ *
+ * The frame clock is a single timeout shared by all of the realtime widgets
+ * in the process.  It ticks at the highest frame rate requested by any of
+ * the registered widgets.  Each widget is scheduled against the monotonic
+ * clock and run on the first tick at or after its due time, so widgets
+ * requesting a lower frame rate do not drift from wall-clock time when
+ * their rate does not divide the clock rate.
+ *
+ * Each tick first runs the #UberFrameFunc of every widget that is due so
+ * that all data pulls for the frame happen together.  The resulting damage
+ * is then invalidated in a single pass so that GDK can process the redraws
+ * of all widgets in the same update cycle instead of one wakeup per widget.
+ *
+ * Widgets may also ask to be told when they can no longer be seen, such as
+ * when they are unmapped, fully obscured, or their toplevel is minimized,
+ * so that they can skip rendering while still collecting data.
+ */
+
+typedef struct
+{
+	guint          id;        /* Handler identifier. */
+	GtkWidget     *widget;    /* Widget to invalidate. */
+	UberFrameFunc  func;      /* Per-frame callback. */
+	gpointer       user_data; /* User data for func. */
+	gint           fps;       /* Requested frames per second. */
+	gint64         interval;  /* Microseconds between runs. */
+	gint64         due;       /* Monotonic time of the next run. */
+	gboolean       damaged;   /* Invalidate damage after this tick. */
+	GdkRectangle   damage;    /* Area to invalidate. */
+} FrameClient;
+
+typedef struct
+{
+	UberViewableFunc  func;          /* Visibility callback. */
+	gpointer          user_data;     /* User data for func. */
+	gboolean          mapped;        /* Is the widget mapped. */
+	gboolean          obscured;      /* Is the widget fully obscured. */
+	gboolean          iconified;     /* Is the toplevel minimized. */
+	GtkWidget        *toplevel;      /* Toplevel watched for iconify. */
+	gulong            state_handler; /* Toplevel "window-state-event" handler. */
+} ViewableWatch;
+
+static GPtrArray *clients    = NULL;
+static guint      source_id  = 0;
+static gint       clock_fps  = 0;
+static guint      last_id    = 0;
+static gboolean   in_tick    = FALSE;
+static gboolean   need_prune = FALSE;
+
+static GQuark     watch_quark = 0;
+
+static void uber_frame_clock_update (void);
+
+/**
+ * uber_frame_clock_lookup:
+ * @handler: A handler identifier.
+ *
+ * Finds the client registered as @handler.
+ *
+ * Returns: A FrameClient or %NULL.
+ * Side effects: None.
+ */
+static FrameClient*
+uber_frame_clock_lookup (guint handler) /* IN */
+{
+	FrameClient *client;
+	gint i;
+
+	if (!clients) {
+		return NULL;
+	}
+	for (i = 0; i < clients->len; i++) {
+		client = g_ptr_array_index(clients, i);
+		if (client->id == handler) {
+			return client;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * uber_frame_clock_prune:
+ *
+ * Frees clients that were removed while the clock was ticking.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_prune (void)
+{
+	FrameClient *client;
+	gint i;
+
+	for (i = clients->len - 1; i >= 0; i--) {
+		client = g_ptr_array_index(clients, i);
+		if (!client->func) {
+			g_ptr_array_remove_index(clients, i);
+			g_slice_free(FrameClient, client);
+		}
+	}
+	need_prune = FALSE;
+}
+
+/**
+ * uber_frame_clock_tick:
+ * @data: Unused.
+ *
+ * Runs a single frame.  All due clients are run before any damage is
+ * invalidated.
+ *
+ * Returns: %TRUE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_frame_clock_tick (gpointer data) /* IN */
+{
+	FrameClient *client;
+	GdkWindow *window;
+	gint64 now;
+	gint64 slack;
+	gint i;
+
+	in_tick = TRUE;
+	now = g_get_monotonic_time();
+	/*
+	 * A client is due if its deadline falls before the middle of the next
+	 * clock period; running it now is closer to on time than waiting.
+	 */
+	slack = G_USEC_PER_SEC / MAX(1, clock_fps) / 2;
+	/*
+	 * Run the data phase for every client that is due.
+	 */
+	for (i = 0; i < clients->len; i++) {
+		client = g_ptr_array_index(clients, i);
+		client->damaged = FALSE;
+		if (!client->func) {
+			continue;
+		}
+		if (now + slack < client->due) {
+			continue;
+		}
+		/*
+		 * Advance by whole intervals so that a late tick does not push
+		 * back later runs, unless we have fallen a full interval behind.
+		 */
+		client->due += client->interval;
+		if (now - client->due >= client->interval) {
+			client->due = now + client->interval;
+		}
+		client->damaged = client->func(client->widget, &client->damage,
+		                               client->user_data);
+	}
+	/*
+	 * Invalidate all of the damage at once.  The redraws are then handled
+	 * together in GDK's next update cycle.
+	 */
+	for (i = 0; i < clients->len; i++) {
+		client = g_ptr_array_index(clients, i);
+		if (!client->func || !client->damaged) {
+			continue;
+		}
+		if ((window = gtk_widget_get_window(client->widget))) {
+			gdk_window_invalidate_rect(window, &client->damage, FALSE);
+		}
+	}
+	in_tick = FALSE;
+	if (need_prune) {
+		uber_frame_clock_prune();
+		uber_frame_clock_update();
+	}
+	return TRUE;
+}
+
+/**
+ * uber_frame_clock_update:
+ *
+ * Recalculates the clock rate from the registered clients.  The timeout is
+ * replaced if the clock rate changed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_update (void)
+{
+	FrameClient *client;
+	gint fps = 0;
+	gint i;
+
+	for (i = 0; i < clients->len; i++) {
+		client = g_ptr_array_index(clients, i);
+		if (client->func) {
+			fps = MAX(fps, client->fps);
+		}
+	}
+	fps = MIN(fps, MAX_FPS);
+	if (fps == clock_fps) {
+		return;
+	}
+	if (source_id) {
+		g_source_remove(source_id);
+		source_id = 0;
+	}
+	clock_fps = fps;
+	if (clock_fps > 0) {
+		source_id = g_timeout_add(1000 / clock_fps, uber_frame_clock_tick,
+		                          NULL);
+	}
+}
+
+/**
+ * uber_frame_clock_add:
+ * @widget: A #GtkWidget.
+ * @fps: The desired frames per second.
+ * @func: An #UberFrameFunc.
+ * @user_data: User data for @func.
+ *
+ * Registers @widget with the frame clock.  @func will be called @fps times
+ * per second on average, aligned to the ticks of the shared clock.
+ *
+ * Returns: A handler identifier for uber_frame_clock_remove().
+ * Side effects: None.
+ */
+guint
+uber_frame_clock_add (GtkWidget     *widget,    /* IN */
+                      gint           fps,       /* IN */
+                      UberFrameFunc  func,      /* IN */
+                      gpointer       user_data) /* IN */
+{
+	FrameClient *client;
+
+	g_return_val_if_fail(GTK_IS_WIDGET(widget), 0);
+	g_return_val_if_fail(func != NULL, 0);
+
+	if (!clients) {
+		clients = g_ptr_array_new();
+	}
+	client = g_slice_new0(FrameClient);
+	client->id = ++last_id;
+	client->widget = widget;
+	client->func = func;
+	client->user_data = user_data;
+	client->fps = MAX(1, fps);
+	client->interval = G_USEC_PER_SEC / client->fps;
+	client->due = g_get_monotonic_time() + client->interval;
+	g_ptr_array_add(clients, client);
+	uber_frame_clock_update();
+	return client->id;
+}
+
+/**
+ * uber_frame_clock_set_fps:
+ * @handler: A handler identifier from uber_frame_clock_add().
+ * @fps: The desired frames per second.
+ *
+ * Changes the frame rate of a registered widget.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_frame_clock_set_fps (guint handler, /* IN */
+                          gint  fps)     /* IN */
+{
+	FrameClient *client;
+
+	g_return_if_fail(handler != 0);
+
+	if (!(client = uber_frame_clock_lookup(handler))) {
+		return;
+	}
+	client->fps = MAX(1, fps);
+	/*
+	 * Keep the current deadline unless the new rate is due sooner.
+	 */
+	client->due = MIN(client->due,
+	                  g_get_monotonic_time() + G_USEC_PER_SEC / client->fps);
+	client->interval = G_USEC_PER_SEC / client->fps;
+	uber_frame_clock_update();
+}
+
+/**
+ * uber_frame_clock_remove:
+ * @handler: A handler identifier from uber_frame_clock_add().
+ *
+ * Unregisters a widget from the frame clock.  The clock stops when no
+ * widgets are registered.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_frame_clock_remove (guint handler) /* IN */
+{
+	FrameClient *client;
+
+	g_return_if_fail(handler != 0);
+
+	if (!(client = uber_frame_clock_lookup(handler))) {
+		return;
+	}
+	client->func = NULL;
+	if (in_tick) {
+		need_prune = TRUE;
+		return;
+	}
+	uber_frame_clock_prune();
+	uber_frame_clock_update();
+}
+
+/**
+ * uber_frame_clock_get_watch:
+ * @widget: A #GtkWidget.
+ *
+ * Retrieves the visibility state attached to @widget.
+ *
+ * Returns: A ViewableWatch or %NULL.
+ * Side effects: None.
+ */
+static inline ViewableWatch*
+uber_frame_clock_get_watch (GtkWidget *widget) /* IN */
+{
+	return g_object_get_qdata(G_OBJECT(widget), watch_quark);
+}
+
+/**
+ * uber_frame_clock_watch_is_viewable:
+ * @watch: A ViewableWatch.
+ *
+ * Checks if the widget of @watch can currently be seen by the user.
+ *
+ * Returns: %TRUE if the widget is viewable; otherwise %FALSE.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_frame_clock_watch_is_viewable (ViewableWatch *watch) /* IN */
+{
+	return watch->mapped && !watch->obscured && !watch->iconified;
+}
+
+/**
+ * uber_frame_clock_watch_notify:
+ * @widget: A #GtkWidget.
+ * @watch: The ViewableWatch of @widget.
+ * @was_viewable: If @widget was viewable before the state change.
+ *
+ * Called after one of the visibility states of @widget has changed.  The
+ * callback is run if the widget became viewable or stopped being viewable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_notify (GtkWidget     *widget,       /* IN */
+                               ViewableWatch *watch,        /* IN */
+                               gboolean       was_viewable) /* IN */
+{
+	gboolean viewable;
+
+	viewable = uber_frame_clock_watch_is_viewable(watch);
+	if (viewable != was_viewable) {
+		watch->func(widget, viewable, watch->user_data);
+	}
+}
+
+/**
+ * uber_frame_clock_watch_map:
+ * @widget: A #GtkWidget.
+ * @watch: The ViewableWatch of @widget.
+ *
+ * Handles @widget being mapped.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_map (GtkWidget     *widget, /* IN */
+                            ViewableWatch *watch)  /* IN */
+{
+	gboolean was_viewable;
+
+	was_viewable = uber_frame_clock_watch_is_viewable(watch);
+	watch->mapped = TRUE;
+	uber_frame_clock_watch_notify(widget, watch, was_viewable);
+}
+
+/**
+ * uber_frame_clock_watch_unmap:
+ * @widget: A #GtkWidget.
+ * @watch: The ViewableWatch of @widget.
+ *
+ * Handles @widget being unmapped, such as when it is in a hidden notebook
+ * page.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_unmap (GtkWidget     *widget, /* IN */
+                              ViewableWatch *watch)  /* IN */
+{
+	gboolean was_viewable;
+
+	was_viewable = uber_frame_clock_watch_is_viewable(watch);
+	watch->mapped = FALSE;
+	uber_frame_clock_watch_notify(widget, watch, was_viewable);
+}
+
+/**
+ * uber_frame_clock_watch_visibility_notify:
+ * @widget: A #GtkWidget.
+ * @event: A #GdkEventVisibility.
+ * @watch: The ViewableWatch of @widget.
+ *
+ * Tracks if the window of @widget is fully obscured by other windows.
+ *
+ * Returns: %FALSE to allow further callbacks.
+ * Side effects: None.
+ */
+static gboolean
+uber_frame_clock_watch_visibility_notify (GtkWidget          *widget, /* IN */
+                                          GdkEventVisibility *event,  /* IN */
+                                          ViewableWatch      *watch)  /* IN */
+{
+	gboolean was_viewable;
+
+	was_viewable = uber_frame_clock_watch_is_viewable(watch);
+	watch->obscured = (event->state == GDK_VISIBILITY_FULLY_OBSCURED);
+	uber_frame_clock_watch_notify(widget, watch, was_viewable);
+	return FALSE;
+}
+
+/**
+ * uber_frame_clock_watch_window_state:
+ * @toplevel: The toplevel #GtkWindow.
+ * @event: A #GdkEventWindowState.
+ * @widget: The watched #GtkWidget.
+ *
+ * Tracks if the toplevel containing @widget has been minimized.
+ *
+ * Returns: %FALSE to allow further callbacks.
+ * Side effects: None.
+ */
+static gboolean
+uber_frame_clock_watch_window_state (GtkWidget           *toplevel, /* IN */
+                                     GdkEventWindowState *event,    /* IN */
+                                     GtkWidget           *widget)   /* IN */
+{
+	ViewableWatch *watch;
+	gboolean was_viewable;
+
+	if (!(watch = uber_frame_clock_get_watch(widget))) {
+		return FALSE;
+	}
+	was_viewable = uber_frame_clock_watch_is_viewable(watch);
+	watch->iconified = !!(event->new_window_state & GDK_WINDOW_STATE_ICONIFIED);
+	uber_frame_clock_watch_notify(widget, watch, was_viewable);
+	return FALSE;
+}
+
+/**
+ * uber_frame_clock_watch_unwatch_toplevel:
+ * @watch: A ViewableWatch.
+ *
+ * Stops tracking the window state of the current toplevel.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_unwatch_toplevel (ViewableWatch *watch) /* IN */
+{
+	if (watch->toplevel) {
+		/*
+		 * The handler is already gone if the widget is being finalized.
+		 */
+		if (g_signal_handler_is_connected(watch->toplevel,
+		                                  watch->state_handler)) {
+			g_signal_handler_disconnect(watch->toplevel,
+			                            watch->state_handler);
+		}
+		g_object_remove_weak_pointer(G_OBJECT(watch->toplevel),
+		                             (gpointer *)&watch->toplevel);
+		watch->toplevel = NULL;
+	}
+	watch->state_handler = 0;
+	watch->iconified = FALSE;
+}
+
+/**
+ * uber_frame_clock_watch_hierarchy_changed:
+ * @widget: A #GtkWidget.
+ * @previous_toplevel: The previous toplevel or %NULL.
+ * @watch: The ViewableWatch of @widget.
+ *
+ * Handles @widget being moved to a new toplevel.  The window state of the
+ * toplevel is tracked so rendering stops while it is minimized.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_hierarchy_changed (GtkWidget     *widget,            /* IN */
+                                          GtkWidget     *previous_toplevel, /* IN */
+                                          ViewableWatch *watch)             /* IN */
+{
+	GtkWidget *toplevel;
+	gboolean was_viewable;
+
+	was_viewable = uber_frame_clock_watch_is_viewable(watch);
+	uber_frame_clock_watch_unwatch_toplevel(watch);
+	toplevel = gtk_widget_get_toplevel(widget);
+	if (gtk_widget_is_toplevel(toplevel)) {
+		watch->toplevel = toplevel;
+		g_object_add_weak_pointer(G_OBJECT(toplevel),
+		                          (gpointer *)&watch->toplevel);
+		watch->state_handler =
+			g_signal_connect_object(toplevel, "window-state-event",
+			                        G_CALLBACK(uber_frame_clock_watch_window_state),
+			                        widget, 0);
+	}
+	uber_frame_clock_watch_notify(widget, watch, was_viewable);
+}
+
+/**
+ * uber_frame_clock_watch_free:
+ * @data: A ViewableWatch.
+ *
+ * Frees the visibility state of a widget when the widget is finalized.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_frame_clock_watch_free (gpointer data) /* IN */
+{
+	ViewableWatch *watch = data;
+
+	uber_frame_clock_watch_unwatch_toplevel(watch);
+	g_slice_free(ViewableWatch, watch);
+}
+
+/**
+ * uber_frame_clock_watch_viewable:
+ * @widget: A #GtkWidget.
+ * @func: An #UberViewableFunc.
+ * @user_data: User data for @func.
+ *
+ * Tracks whether any part of @widget can be seen by the user.  @widget is
+ * not viewable while it is unmapped, fully obscured by other windows, or
+ * its toplevel is minimized.  @func is called whenever that changes.  The
+ * widget starts out not viewable.
+ *
+ * This should be called once from the instance init function of @widget.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_frame_clock_watch_viewable (GtkWidget        *widget,    /* IN */
+                                 UberViewableFunc  func,      /* IN */
+                                 gpointer          user_data) /* IN */
+{
+	ViewableWatch *watch;
+
+	g_return_if_fail(GTK_IS_WIDGET(widget));
+	g_return_if_fail(func != NULL);
+
+	if (!watch_quark) {
+		watch_quark = g_quark_from_static_string("uber-frame-clock-watch");
+	}
+	g_return_if_fail(uber_frame_clock_get_watch(widget) == NULL);
+
+	watch = g_slice_new0(ViewableWatch);
+	watch->func = func;
+	watch->user_data = user_data;
+	g_object_set_qdata_full(G_OBJECT(widget), watch_quark, watch,
+	                        uber_frame_clock_watch_free);
+	gtk_widget_add_events(widget, GDK_VISIBILITY_NOTIFY_MASK);
+	g_signal_connect(widget, "map",
+	                 G_CALLBACK(uber_frame_clock_watch_map), watch);
+	g_signal_connect(widget, "unmap",
+	                 G_CALLBACK(uber_frame_clock_watch_unmap), watch);
+	g_signal_connect(widget, "visibility-notify-event",
+	                 G_CALLBACK(uber_frame_clock_watch_visibility_notify),
+	                 watch);
+	g_signal_connect(widget, "hierarchy-changed",
+	                 G_CALLBACK(uber_frame_clock_watch_hierarchy_changed),
+	                 watch);
+}
@@ -0,0 +1,71 @@
+/* uber-frame-clock.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_FRAME_CLOCK_H__
+#define __UBER_FRAME_CLOCK_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/**
+ * UberFrameFunc:
+ * @widget: The #GtkWidget registered with the frame clock.
+ * @damage: A location for the area of @widget to invalidate.
+ * @user_data: User data supplied to uber_frame_clock_add().
+ *
+ * Callback run by the frame clock when a frame is due for @widget.  Data
+ * should be pulled and pixmaps updated here.  Invalidation of @damage is
+ * done by the frame clock after all callbacks for the frame have run.
+ *
+ * Returns: %TRUE if @damage should be invalidated; otherwise %FALSE.
+ * Side effects: Implementation specific.
+ */
+typedef gboolean (*UberFrameFunc) (GtkWidget    *widget,
+                                   GdkRectangle *damage,
+                                   gpointer      user_data);
+
+/**
+ * UberViewableFunc:
+ * @widget: The #GtkWidget being watched.
+ * @viewable: If any part of @widget can now be seen by the user.
+ * @user_data: User data supplied to uber_frame_clock_watch_viewable().
+ *
+ * Callback run when @widget becomes viewable or stops being viewable.
+ *
+ * Returns: None.
+ * Side effects: Implementation specific.
+ */
+typedef void (*UberViewableFunc) (GtkWidget *widget,
+                                  gboolean   viewable,
+                                  gpointer   user_data);
+
+guint uber_frame_clock_add     (GtkWidget     *widget,
+                                gint           fps,
+                                UberFrameFunc  func,
+                                gpointer       user_data);
+void  uber_frame_clock_remove  (guint          handler);
+void  uber_frame_clock_set_fps (guint          handler,
+                                gint           fps);
+void  uber_frame_clock_watch_viewable (GtkWidget        *widget,
+                                       UberViewableFunc  func,
+                                       gpointer          user_data);
+
+G_END_DECLS
+
+#endif /* __UBER_FRAME_CLOCK_H__ */
@@ -0,0 +1,1105 @@
+/* uber-graph-grid.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-frame-clock.h"
+#include "uber-graph-grid.h"
+#include "uber-text-cache.h"
+
+#define WIDGET ((GtkWidgetClass *)uber_graph_grid_parent_class)
+
+#define CELL_GAP    3 /* Pixels between cells. */
+#define CELL_STEP   2 /* Pixels between data points. */
+#define GRID_FPS    1 /* Data points per second. */
+#define GDK_RECTANGLE_RIGHT(r)  ((r).x + (r).width)
+#define GDK_RECTANGLE_BOTTOM(r) ((r).y + (r).height)
+
+/*
+ * Values are stored one row of n_cells per data point.  Index 0 is the
+ * most recent data point.
+ */
+#define GRID_VALUE(p, i, c) \
+    ((p)->data[((((p)->pos - 1 - (i)) + (p)->stride) % (p)->stride) * \
+               (p)->n_cells + (c)])
+
+/**
+ * SECTION:uber-graph-grid.h
+ * @title: UberGraphGrid
+ * @short_description: Small multiples of many series in one widget.
+ *
+ * #UberGraphGrid renders a compact sparkline for each of its cells into a
+ * single pair of server-side pixmaps.  All of the cells share one timer
+ * and one x-axis so that advancing the grid is a single copy of the
+ * previous frame followed by a thin sliver of new content per cell.  This
+ * scales to hundreds of series where an #UberGraph per series would not.
+ */
+
+G_DEFINE_TYPE(UberGraphGrid, uber_graph_grid, GTK_TYPE_DRAWING_AREA)
+
+typedef struct
+{
+	GdkPixmap *pixmap;
+	cairo_t   *cairo;
+} GridTexture;
+
+struct _UberGraphGridPrivate
+{
+	GridTexture            textures[2];
+	gboolean               flipped;
+	gboolean               full_draw;
+	guint                  n_cells;     /* Number of series. */
+	gchar                **labels;      /* Markup for each cell or NULL. */
+	gdouble               *data;        /* stride * n_cells values. */
+	gint                   stride;      /* Data points per cell. */
+	gint                   pos;         /* Next data point slot. */
+	gint                   columns;
+	gint                   rows;
+	gint                   req_rows;    /* Rows the size request was for. */
+	gint                   cell_width;  /* Requested cell width. */
+	gint                   cell_height; /* Requested cell height. */
+	gint                   cur_width;   /* Allocated cell width. */
+	gint                   cur_height;  /* Allocated cell height. */
+	UberRange              range;
+	GdkColor               color;
+	PangoFontDescription  *font;
+	UberGraphGridFunc      func;
+	gpointer               func_data;
+	GDestroyNotify         func_notify;
+	guint                  fps_handler;
+	gboolean               viewable;
+};
+
+/**
+ * uber_graph_grid_new:
+ *
+ * Creates a new instance of #UberGraphGrid.
+ *
+ * Returns: the newly created instance of #UberGraphGrid.
+ * Side effects: None.
+ */
+GtkWidget*
+uber_graph_grid_new (void)
+{
+	return g_object_new(UBER_TYPE_GRAPH_GRID, NULL);
+}
+
+/**
+ * uber_graph_grid_get_viewable:
+ * @grid: A #UberGraphGrid.
+ *
+ * Checks if any part of the grid can currently be seen by the user.
+ *
+ * Returns: %TRUE if the grid is viewable; otherwise %FALSE.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_graph_grid_get_viewable (UberGraphGrid *grid) /* IN */
+{
+	return grid->priv->viewable;
+}
+
+/**
+ * uber_graph_grid_get_cell_rect:
+ * @grid: A #UberGraphGrid.
+ * @cell: The cell index.
+ * @rect: A location for the cell area.
+ *
+ * Retrieves the area of @cell within the widget.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_grid_get_cell_rect (UberGraphGrid *grid, /* IN */
+                               guint          cell, /* IN */
+                               GdkRectangle  *rect) /* OUT */
+{
+	UberGraphGridPrivate *priv = grid->priv;
+
+	rect->x = (cell % priv->columns) * (priv->cur_width + CELL_GAP);
+	rect->y = (cell / priv->columns) * (priv->cur_height + CELL_GAP);
+	rect->width = priv->cur_width;
+	rect->height = priv->cur_height;
+}
+
+/**
+ * uber_graph_grid_get_y:
+ * @grid: A #UberGraphGrid.
+ * @rect: The area of the cell.
+ * @value: The value to translate.
+ *
+ * Translates @value into a y coordinate within @rect.
+ *
+ * Returns: The y coordinate.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_graph_grid_get_y (UberGraphGrid      *grid,  /* IN */
+                       const GdkRectangle *rect,  /* IN */
+                       gdouble             value) /* IN */
+{
+	UberGraphGridPrivate *priv = grid->priv;
+	gdouble y;
+
+	y = (value - priv->range.begin) / priv->range.range;
+	y = CLAMP(y, 0., 1.);
+	return GDK_RECTANGLE_BOTTOM(*rect) - 1.5 - (y * (rect->height - 3));
+}
+
+/**
+ * uber_graph_grid_resize_data:
+ * @grid: A #UberGraphGrid.
+ * @stride: The number of data points to keep per cell.
+ * @n_cells: The number of cells.
+ *
+ * Resizes the data point storage, keeping as many of the most recent data
+ * points as fit.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_resize_data (UberGraphGrid *grid,    /* IN */
+                             gint           stride,  /* IN */
+                             guint          n_cells) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	gdouble *data;
+	gint count;
+	gint i;
+	guint j;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(stride > 0);
+
+	priv = grid->priv;
+	if (stride == priv->stride && n_cells == priv->n_cells) {
+		return;
+	}
+	data = g_new(gdouble, stride * n_cells);
+	for (i = 0; i < stride * n_cells; i++) {
+		data[i] = -INFINITY;
+	}
+	/*
+	 * Copy the newest data points, oldest first, to the front of the
+	 * new storage.
+	 */
+	count = MIN(stride, priv->stride);
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < MIN(n_cells, priv->n_cells); j++) {
+			data[i * n_cells + j] = GRID_VALUE(priv, count - 1 - i, j);
+		}
+	}
+	g_free(priv->data);
+	priv->data = data;
+	priv->stride = stride;
+	priv->n_cells = n_cells;
+	priv->pos = count % stride;
+}
+
+/**
+ * uber_graph_grid_init_texture:
+ * @grid: A #UberGraphGrid.
+ * @texture: A GridTexture.
+ *
+ * Initializes the server-side pixmap for @texture.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_init_texture (UberGraphGrid *grid,    /* IN */
+                              GridTexture   *texture) /* IN */
+{
+	GtkAllocation alloc;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(texture != NULL);
+
+	gtk_widget_get_allocation(GTK_WIDGET(grid), &alloc);
+	texture->pixmap = gdk_pixmap_new(gtk_widget_get_window(GTK_WIDGET(grid)),
+	                                 MAX(1, alloc.width),
+	                                 MAX(1, alloc.height),
+	                                 -1);
+	texture->cairo = gdk_cairo_create(texture->pixmap);
+}
+
+/**
+ * uber_graph_grid_destroy_texture:
+ * @grid: A #UberGraphGrid.
+ * @texture: A GridTexture.
+ *
+ * Destroys the server-side pixmap for @texture.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_destroy_texture (UberGraphGrid *grid,    /* IN */
+                                 GridTexture   *texture) /* IN */
+{
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(texture != NULL);
+
+	if (texture->cairo) {
+		cairo_destroy(texture->cairo);
+		texture->cairo = NULL;
+	}
+	if (texture->pixmap) {
+		g_object_unref(texture->pixmap);
+		texture->pixmap = NULL;
+	}
+}
+
+/**
+ * uber_graph_grid_get_columns:
+ * @grid: A #UberGraphGrid.
+ * @width: The width available to the grid.
+ *
+ * Calculates how many columns of cells fit within @width.
+ *
+ * Returns: The number of columns, at least one.
+ * Side effects: None.
+ */
+static gint
+uber_graph_grid_get_columns (UberGraphGrid *grid,  /* IN */
+                             gint           width) /* IN */
+{
+	UberGraphGridPrivate *priv = grid->priv;
+	gint columns;
+
+	columns = (width + CELL_GAP) / (priv->cell_width + CELL_GAP);
+	return CLAMP(columns, 1, MAX(1, priv->n_cells));
+}
+
+/**
+ * uber_graph_grid_calculate_layout:
+ * @grid: A #UberGraphGrid.
+ *
+ * Calculates the number of columns and rows and the size of each cell for
+ * the current allocation.  The data point storage is resized to fit the
+ * width of a cell.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_calculate_layout (UberGraphGrid *grid) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	GtkAllocation alloc;
+	guint n_cells;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+
+	priv = grid->priv;
+	gtk_widget_get_allocation(GTK_WIDGET(grid), &alloc);
+	n_cells = MAX(1, priv->n_cells);
+	priv->columns = uber_graph_grid_get_columns(grid, alloc.width);
+	priv->rows = (n_cells + priv->columns - 1) / priv->columns;
+	priv->cur_width = (alloc.width - ((priv->columns - 1) * CELL_GAP))
+	                / priv->columns;
+	priv->cur_height = (alloc.height - ((priv->rows - 1) * CELL_GAP))
+	                 / priv->rows;
+	priv->cur_width = MAX(priv->cur_width, CELL_STEP * 2);
+	priv->cur_height = MAX(priv->cur_height, 4);
+	uber_graph_grid_resize_data(grid,
+	                            (priv->cur_width / CELL_STEP) + 2,
+	                            priv->n_cells);
+}
+
+/**
+ * uber_graph_grid_render_full:
+ * @grid: A #UberGraphGrid.
+ *
+ * Renders every cell of the grid to the current texture.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_render_full (UberGraphGrid *grid) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	GridTexture *texture;
+	GtkAllocation alloc;
+	GdkRectangle rect;
+	GtkStyle *style;
+	gboolean drawing;
+	gdouble value;
+	gdouble x;
+	guint cell;
+	gint i;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+
+	priv = grid->priv;
+	texture = &priv->textures[priv->flipped];
+	style = gtk_widget_get_style(GTK_WIDGET(grid));
+	gtk_widget_get_allocation(GTK_WIDGET(grid), &alloc);
+	cairo_save(texture->cairo);
+	/*
+	 * Fill the widget background and then the background of every cell.
+	 */
+	gdk_cairo_set_source_color(texture->cairo, &style->bg[GTK_STATE_NORMAL]);
+	cairo_paint(texture->cairo);
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		uber_graph_grid_get_cell_rect(grid, cell, &rect);
+		gdk_cairo_rectangle(texture->cairo, &rect);
+	}
+	gdk_cairo_set_source_color(texture->cairo, &style->light[GTK_STATE_NORMAL]);
+	cairo_fill(texture->cairo);
+	/*
+	 * Build the path for every sparkline and stroke them at once.
+	 */
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		uber_graph_grid_get_cell_rect(grid, cell, &rect);
+		drawing = FALSE;
+		for (i = 0; i < priv->stride; i++) {
+			x = GDK_RECTANGLE_RIGHT(rect) - .5 - (i * CELL_STEP);
+			if (x < rect.x) {
+				break;
+			}
+			value = GRID_VALUE(priv, i, cell);
+			if (isnan(value) || isinf(value)) {
+				drawing = FALSE;
+				continue;
+			}
+			if (drawing) {
+				cairo_line_to(texture->cairo, x,
+				              uber_graph_grid_get_y(grid, &rect, value));
+			} else {
+				cairo_move_to(texture->cairo, x,
+				              uber_graph_grid_get_y(grid, &rect, value));
+				drawing = TRUE;
+			}
+		}
+	}
+	gdk_cairo_set_source_color(texture->cairo, &priv->color);
+	cairo_set_line_width(texture->cairo, 1.);
+	cairo_stroke(texture->cairo);
+	cairo_restore(texture->cairo);
+}
+
+/**
+ * uber_graph_grid_render_shifted:
+ * @grid: A #UberGraphGrid.
+ *
+ * Advances the grid by one data point.  The previous frame is copied once,
+ * shifted left, to the other texture and only the newest sliver of each
+ * cell is rendered.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_render_shifted (UberGraphGrid *grid) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	GridTexture *src;
+	GridTexture *dst;
+	GtkAllocation alloc;
+	GdkRectangle rect;
+	GtkStyle *style;
+	gdouble value;
+	gdouble last;
+	gdouble prev;
+	gdouble x;
+	guint cell;
+	gint right;
+	gint width;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+
+	priv = grid->priv;
+	style = gtk_widget_get_style(GTK_WIDGET(grid));
+	gtk_widget_get_allocation(GTK_WIDGET(grid), &alloc);
+	src = &priv->textures[priv->flipped];
+	dst = &priv->textures[!priv->flipped];
+	priv->flipped = !priv->flipped;
+	cairo_save(dst->cairo);
+	/*
+	 * Copy the previous frame for every cell in one operation.
+	 */
+	gdk_cairo_set_source_pixmap(dst->cairo, src->pixmap, -CELL_STEP, 0);
+	cairo_paint(dst->cairo);
+	/*
+	 * The gaps to the right of each cell received content from the cell
+	 * next to it, as did the right edge of the widget.
+	 */
+	cairo_rectangle(dst->cairo, alloc.width - CELL_STEP, 0,
+	                CELL_STEP, alloc.height);
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		uber_graph_grid_get_cell_rect(grid, cell, &rect);
+		right = (cell % priv->columns == priv->columns - 1) ?
+		        alloc.width : GDK_RECTANGLE_RIGHT(rect) + CELL_GAP;
+		cairo_rectangle(dst->cairo, GDK_RECTANGLE_RIGHT(rect), rect.y,
+		                right - GDK_RECTANGLE_RIGHT(rect), rect.height);
+	}
+	gdk_cairo_set_source_color(dst->cairo, &style->bg[GTK_STATE_NORMAL]);
+	cairo_fill(dst->cairo);
+	/*
+	 * Clear the new sliver of every cell and clip to them.  The sliver
+	 * takes a pixel more than a step, as the butt end of the previous
+	 * segment stops half a pixel short of it.
+	 */
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		uber_graph_grid_get_cell_rect(grid, cell, &rect);
+		width = MIN(CELL_STEP + 1, rect.width);
+		cairo_rectangle(dst->cairo, GDK_RECTANGLE_RIGHT(rect) - width,
+		                rect.y, width, rect.height);
+	}
+	gdk_cairo_set_source_color(dst->cairo, &style->light[GTK_STATE_NORMAL]);
+	cairo_fill_preserve(dst->cairo);
+	cairo_clip(dst->cairo);
+	/*
+	 * Draw the newest segment of every sparkline in one stroke, along with
+	 * the segment before it so that the joint is covered.
+	 */
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		value = GRID_VALUE(priv, 0, cell);
+		last = GRID_VALUE(priv, 1, cell);
+		if (isnan(value) || isinf(value) || isnan(last) || isinf(last)) {
+			continue;
+		}
+		uber_graph_grid_get_cell_rect(grid, cell, &rect);
+		x = GDK_RECTANGLE_RIGHT(rect) - .5;
+		prev = GRID_VALUE(priv, 2, cell);
+		if (isnan(prev) || isinf(prev)) {
+			cairo_move_to(dst->cairo, x - CELL_STEP,
+			              uber_graph_grid_get_y(grid, &rect, last));
+		} else {
+			cairo_move_to(dst->cairo, x - (2 * CELL_STEP),
+			              uber_graph_grid_get_y(grid, &rect, prev));
+			cairo_line_to(dst->cairo, x - CELL_STEP,
+			              uber_graph_grid_get_y(grid, &rect, last));
+		}
+		cairo_line_to(dst->cairo, x,
+		              uber_graph_grid_get_y(grid, &rect, value));
+	}
+	gdk_cairo_set_source_color(dst->cairo, &priv->color);
+	cairo_set_line_width(dst->cairo, 1.);
+	cairo_stroke(dst->cairo);
+	cairo_restore(dst->cairo);
+}
+
+/**
+ * uber_graph_grid_fps_timeout:
+ * @widget: A #UberGraphGrid.
+ * @damage: A location for the area to invalidate.
+ * @user_data: Unused.
+ *
+ * #UberFrameFunc to retrieve the next value of every cell and advance the
+ * grid.
+ *
+ * Returns: %TRUE if the grid should be redrawn; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_grid_fps_timeout (GtkWidget    *widget,    /* IN */
+                             GdkRectangle *damage,    /* OUT */
+                             gpointer      user_data) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	UberGraphGrid *grid = UBER_GRAPH_GRID(widget);
+	GtkAllocation alloc;
+	gdouble *values;
+	guint i;
+
+	g_return_val_if_fail(UBER_IS_GRAPH_GRID(grid), FALSE);
+
+	priv = grid->priv;
+	if (!priv->data || !priv->n_cells) {
+		return FALSE;
+	}
+	/*
+	 * Values are written straight into the storage for the next slot.
+	 */
+	values = &priv->data[priv->pos * priv->n_cells];
+	for (i = 0; i < priv->n_cells; i++) {
+		values[i] = -INFINITY;
+	}
+	if (priv->func) {
+		if (!priv->func(grid, values, priv->n_cells, priv->func_data)) {
+			for (i = 0; i < priv->n_cells; i++) {
+				values[i] = -INFINITY;
+			}
+		}
+	}
+	priv->pos = (priv->pos + 1) % priv->stride;
+	/*
+	 * While hidden, only collect the values.  A full render happens once
+	 * the grid is viewable again.
+	 */
+	if (!uber_graph_grid_get_viewable(grid) || !priv->textures[0].pixmap) {
+		priv->full_draw = TRUE;
+		return FALSE;
+	}
+	if (!priv->full_draw) {
+		uber_graph_grid_render_shifted(grid);
+	}
+	gtk_widget_get_allocation(widget, &alloc);
+	damage->x = 0;
+	damage->y = 0;
+	damage->width = alloc.width;
+	damage->height = alloc.height;
+	return TRUE;
+}
+
+/**
+ * uber_graph_grid_queue_full_draw:
+ * @grid: A #UberGraphGrid.
+ *
+ * Schedules every cell to be rendered again on the next expose.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_grid_queue_full_draw (UberGraphGrid *grid) /* IN */
+{
+	grid->priv->full_draw = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(grid));
+}
+
+/**
+ * uber_graph_grid_set_n_cells:
+ * @grid: A #UberGraphGrid.
+ * @n_cells: The number of series.
+ *
+ * Sets the number of cells, one per series, displayed by the grid.
+ *
+ * Returns: None.
+ * Side effects: Existing data for removed cells is discarded.
+ */
+void
+uber_graph_grid_set_n_cells (UberGraphGrid *grid,    /* IN */
+                             guint          n_cells) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	guint i;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+
+	priv = grid->priv;
+	for (i = n_cells; i < priv->n_cells; i++) {
+		g_free(priv->labels[i]);
+	}
+	priv->labels = g_renew(gchar*, priv->labels, n_cells + 1);
+	for (i = priv->n_cells; i <= n_cells; i++) {
+		priv->labels[i] = NULL;
+	}
+	uber_graph_grid_resize_data(grid, priv->stride, n_cells);
+	gtk_widget_queue_resize(GTK_WIDGET(grid));
+	uber_graph_grid_queue_full_draw(grid);
+}
+
+/**
+ * uber_graph_grid_get_n_cells:
+ * @grid: A #UberGraphGrid.
+ *
+ * Retrieves the number of cells displayed by the grid.
+ *
+ * Returns: The number of cells.
+ * Side effects: None.
+ */
+guint
+uber_graph_grid_get_n_cells (UberGraphGrid *grid) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH_GRID(grid), 0);
+	return grid->priv->n_cells;
+}
+
+/**
+ * uber_graph_grid_set_cell_label:
+ * @grid: A #UberGraphGrid.
+ * @cell: The cell index.
+ * @markup: Pango markup for the label or %NULL.
+ *
+ * Sets the label drawn in the corner of @cell.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_grid_set_cell_label (UberGraphGrid *grid,   /* IN */
+                                guint          cell,   /* IN */
+                                const gchar   *markup) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(cell < grid->priv->n_cells);
+
+	priv = grid->priv;
+	g_free(priv->labels[cell]);
+	priv->labels[cell] = g_strdup(markup);
+	gtk_widget_queue_draw(GTK_WIDGET(grid));
+}
+
+/**
+ * uber_graph_grid_set_cell_size:
+ * @grid: A #UberGraphGrid.
+ * @width: The minimum width of a cell.
+ * @height: The minimum height of a cell.
+ *
+ * Sets the minimum size of each cell.  As many columns of cells as fit
+ * within the allocation are displayed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_grid_set_cell_size (UberGraphGrid *grid,   /* IN */
+                               gint           width,  /* IN */
+                               gint           height) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(width > 0);
+	g_return_if_fail(height > 0);
+
+	priv = grid->priv;
+	priv->cell_width = width;
+	priv->cell_height = height;
+	gtk_widget_queue_resize(GTK_WIDGET(grid));
+}
+
+/**
+ * uber_graph_grid_set_color:
+ * @grid: A #UberGraphGrid.
+ * @color: A #GdkColor.
+ *
+ * Sets the color used for the sparkline of every cell.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_grid_set_color (UberGraphGrid  *grid,  /* IN */
+                           const GdkColor *color) /* IN */
+{
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(color != NULL);
+
+	grid->priv->color = *color;
+	uber_graph_grid_queue_full_draw(grid);
+}
+
+/**
+ * uber_graph_grid_set_range:
+ * @grid: A #UberGraphGrid.
+ * @range: An #UberRange.
+ *
+ * Sets the range of values shared by every cell.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_grid_set_range (UberGraphGrid   *grid,  /* IN */
+                           const UberRange *range) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+	g_return_if_fail(range != NULL);
+	g_return_if_fail(range->end > range->begin);
+
+	priv = grid->priv;
+	priv->range = *range;
+	priv->range.range = priv->range.end - priv->range.begin;
+	uber_graph_grid_queue_full_draw(grid);
+}
+
+/**
+ * uber_graph_grid_set_values_func:
+ * @grid: A #UberGraphGrid.
+ * @func: An #UberGraphGridFunc.
+ * @user_data: User data for @func.
+ * @notify: A #GDestroyNotify to free @user_data or %NULL.
+ *
+ * Sets the callback used to retrieve the next value of every cell.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_grid_set_values_func (UberGraphGrid     *grid,      /* IN */
+                                 UberGraphGridFunc  func,      /* IN */
+                                 gpointer           user_data, /* IN */
+                                 GDestroyNotify     notify)    /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(grid));
+
+	priv = grid->priv;
+	if (priv->func_notify) {
+		priv->func_notify(priv->func_data);
+	}
+	priv->func = func;
+	priv->func_data = user_data;
+	priv->func_notify = notify;
+}
+
+/**
+ * uber_graph_grid_expose_event:
+ * @widget: A #UberGraphGrid.
+ * @expose: A #GdkEventExpose.
+ *
+ * Handles the exposure event.  The current texture is drawn followed by
+ * the cell labels, which are not part of the texture so they do not
+ * scroll with the data.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_grid_expose_event (GtkWidget      *widget, /* IN */
+                              GdkEventExpose *expose) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	const UberText *text;
+	GdkRectangle rect;
+	GdkRectangle area;
+	GtkStyle *style;
+	cairo_t *cr;
+	guint cell;
+
+	g_return_val_if_fail(UBER_IS_GRAPH_GRID(widget), FALSE);
+
+	priv = UBER_GRAPH_GRID(widget)->priv;
+	if (!priv->textures[0].pixmap) {
+		return FALSE;
+	}
+	if (priv->full_draw) {
+		uber_graph_grid_render_full(UBER_GRAPH_GRID(widget));
+		priv->full_draw = FALSE;
+	}
+	style = gtk_widget_get_style(widget);
+	cr = gdk_cairo_create(expose->window);
+	gdk_cairo_rectangle(cr, &expose->area);
+	cairo_clip(cr);
+	gdk_cairo_set_source_pixmap(cr, priv->textures[priv->flipped].pixmap, 0, 0);
+	cairo_paint(cr);
+	/*
+	 * Draw the labels of the exposed cells.
+	 */
+	gdk_cairo_set_source_color(cr, &style->fg[GTK_STATE_NORMAL]);
+	for (cell = 0; cell < priv->n_cells; cell++) {
+		if (!priv->labels[cell]) {
+			continue;
+		}
+		uber_graph_grid_get_cell_rect(UBER_GRAPH_GRID(widget), cell, &rect);
+		if (!gdk_rectangle_intersect(&rect, &expose->area, &area)) {
+			continue;
+		}
+		text = uber_text_cache_lookup(priv->labels[cell], priv->font, 1.);
+		if (text) {
+			uber_text_cache_show(cr, text, rect.x + 2, rect.y + 1);
+		}
+	}
+	cairo_destroy(cr);
+	return FALSE;
+}
+
+/**
+ * uber_graph_grid_realize:
+ * @widget: A #UberGraphGrid.
+ *
+ * Handles the "realize" event.  The textures are created for the current
+ * allocation.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_realize (GtkWidget *widget) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(widget));
+
+	priv = UBER_GRAPH_GRID(widget)->priv;
+	WIDGET->realize(widget);
+	uber_graph_grid_init_texture(UBER_GRAPH_GRID(widget), &priv->textures[0]);
+	uber_graph_grid_init_texture(UBER_GRAPH_GRID(widget), &priv->textures[1]);
+	priv->full_draw = TRUE;
+}
+
+/**
+ * uber_graph_grid_unrealize:
+ * @widget: A #UberGraphGrid.
+ *
+ * Handles the "unrealize" event.  The textures are released.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_unrealize (GtkWidget *widget) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(widget));
+
+	priv = UBER_GRAPH_GRID(widget)->priv;
+	uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(widget), &priv->textures[0]);
+	uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(widget), &priv->textures[1]);
+	WIDGET->unrealize(widget);
+}
+
+/**
+ * uber_graph_grid_size_allocate:
+ * @widget: A #UberGraphGrid.
+ * @alloc: A #GtkAllocation.
+ *
+ * Handles the widget being resized.  The cells are laid out again and
+ * the textures are recreated.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_size_allocate (GtkWidget     *widget, /* IN */
+                               GtkAllocation *alloc)  /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(widget));
+
+	priv = UBER_GRAPH_GRID(widget)->priv;
+	WIDGET->size_allocate(widget, alloc);
+	uber_graph_grid_calculate_layout(UBER_GRAPH_GRID(widget));
+	/*
+	 * The requested height depends on the allocated width.  Ask again if
+	 * the cells wrap into a different number of rows at this width.
+	 */
+	if (priv->rows != priv->req_rows) {
+		gtk_widget_queue_resize(widget);
+	}
+	if (gtk_widget_get_realized(widget)) {
+		uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(widget), &priv->textures[0]);
+		uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(widget), &priv->textures[1]);
+		uber_graph_grid_init_texture(UBER_GRAPH_GRID(widget), &priv->textures[0]);
+		uber_graph_grid_init_texture(UBER_GRAPH_GRID(widget), &priv->textures[1]);
+	}
+	priv->full_draw = TRUE;
+}
+
+/**
+ * uber_graph_grid_size_request:
+ * @widget: A #UberGraphGrid.
+ * @req: A #GtkRequisition.
+ *
+ * Requests the width of a single cell and the height of every row of cells
+ * at the allocated width.  Before the first allocation the cells are
+ * assumed to be laid out in a square.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_size_request (GtkWidget      *widget, /* IN */
+                              GtkRequisition *req)    /* OUT */
+{
+	UberGraphGridPrivate *priv;
+	GtkAllocation alloc;
+	gint columns;
+	gint n_cells;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(widget));
+
+	priv = UBER_GRAPH_GRID(widget)->priv;
+	gtk_widget_get_allocation(widget, &alloc);
+	n_cells = MAX(1, priv->n_cells);
+	if (alloc.width > 1) {
+		columns = uber_graph_grid_get_columns(UBER_GRAPH_GRID(widget),
+		                                      alloc.width);
+	} else {
+		columns = ceil(sqrt(n_cells));
+	}
+	priv->req_rows = (n_cells + columns - 1) / columns;
+	req->width = priv->cell_width;
+	req->height = (priv->req_rows * priv->cell_height)
+	            + ((priv->req_rows - 1) * CELL_GAP);
+}
+
+/**
+ * uber_graph_grid_viewable_changed:
+ * @widget: A #UberGraphGrid.
+ * @viewable: If the grid can now be seen.
+ * @user_data: Unused.
+ *
+ * #UberViewableFunc called when the grid becomes viewable or stops being
+ * viewable.  If the grid just became viewable, it is fully redrawn to
+ * catch up with values collected while hidden.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_viewable_changed (GtkWidget *widget,    /* IN */
+                                  gboolean   viewable,  /* IN */
+                                  gpointer   user_data) /* IN */
+{
+	g_return_if_fail(UBER_IS_GRAPH_GRID(widget));
+
+	UBER_GRAPH_GRID(widget)->priv->viewable = viewable;
+	if (viewable) {
+		uber_graph_grid_queue_full_draw(UBER_GRAPH_GRID(widget));
+	}
+}
+
+/**
+ * uber_graph_grid_dispose:
+ * @object: A #UberGraphGrid.
+ *
+ * Unregisters the widget from the frame clock so that no frame runs while
+ * it is being destroyed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_dispose (GObject *object) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(object));
+
+	priv = UBER_GRAPH_GRID(object)->priv;
+	if (priv->fps_handler) {
+		uber_frame_clock_remove(priv->fps_handler);
+		priv->fps_handler = 0;
+	}
+	G_OBJECT_CLASS(uber_graph_grid_parent_class)->dispose(object);
+}
+
+/**
+ * uber_graph_grid_finalize:
+ * @object: A #UberGraphGrid.
+ *
+ * Finalizer for a #UberGraphGrid instance.  Frees any resources held by
+ * the instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_finalize (GObject *object) /* IN */
+{
+	UberGraphGridPrivate *priv;
+	guint i;
+
+	g_return_if_fail(UBER_IS_GRAPH_GRID(object));
+
+	priv = UBER_GRAPH_GRID(object)->priv;
+	if (priv->func_notify) {
+		priv->func_notify(priv->func_data);
+	}
+	uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(object), &priv->textures[0]);
+	uber_graph_grid_destroy_texture(UBER_GRAPH_GRID(object), &priv->textures[1]);
+	pango_font_description_free(priv->font);
+	for (i = 0; i < priv->n_cells; i++) {
+		g_free(priv->labels[i]);
+	}
+	g_free(priv->labels);
+	g_free(priv->data);
+	G_OBJECT_CLASS(uber_graph_grid_parent_class)->finalize(object);
+}
+
+/**
+ * uber_graph_grid_class_init:
+ * @klass: A #UberGraphGridClass.
+ *
+ * Initializes the #UberGraphGridClass and prepares the vtable.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_class_init (UberGraphGridClass *klass) /* IN */
+{
+	GObjectClass *object_class;
+	GtkWidgetClass *widget_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = uber_graph_grid_dispose;
+	object_class->finalize = uber_graph_grid_finalize;
+	g_type_class_add_private(object_class, sizeof(UberGraphGridPrivate));
+
+	widget_class = GTK_WIDGET_CLASS(klass);
+	widget_class->realize = uber_graph_grid_realize;
+	widget_class->unrealize = uber_graph_grid_unrealize;
+	widget_class->expose_event = uber_graph_grid_expose_event;
+	widget_class->size_allocate = uber_graph_grid_size_allocate;
+	widget_class->size_request = uber_graph_grid_size_request;
+}
+
+/**
+ * uber_graph_grid_init:
+ * @grid: A #UberGraphGrid.
+ *
+ * Initializes the newly created #UberGraphGrid instance.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_grid_init (UberGraphGrid *grid) /* IN */
+{
+	UberGraphGridPrivate *priv;
+
+	grid->priv = G_TYPE_INSTANCE_GET_PRIVATE(grid,
+	                                         UBER_TYPE_GRAPH_GRID,
+	                                         UberGraphGridPrivate);
+	priv = grid->priv;
+	/*
+	 * Setup defaults.
+	 */
+	priv->cell_width = 96;
+	priv->cell_height = 32;
+	priv->columns = 1;
+	priv->rows = 1;
+	priv->range.begin = 0.;
+	priv->range.end = 100.;
+	priv->range.range = 100.;
+	priv->labels = g_new0(gchar*, 1);
+	gdk_color_parse("#3465a4", &priv->color);
+	priv->font = pango_font_description_new();
+	pango_font_description_set_family(priv->font, "MONOSPACE");
+	pango_font_description_set_size(priv->font, 7 * PANGO_SCALE);
+	uber_graph_grid_resize_data(grid, 2, 0);
+	uber_frame_clock_watch_viewable(GTK_WIDGET(grid),
+	                                uber_graph_grid_viewable_changed, NULL);
+	/*
+	 * A single registration with the frame clock drives every cell.
+	 */
+	priv->fps_handler = uber_frame_clock_add(GTK_WIDGET(grid), GRID_FPS,
+	                                         uber_graph_grid_fps_timeout,
+	                                         NULL);
+}
@@ -0,0 +1,94 @@
+/* uber-graph-grid.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_GRAPH_GRID_H__
+#define __UBER_GRAPH_GRID_H__
+
+#include <gtk/gtk.h>
+
+#include "uber-range.h"
+
+G_BEGIN_DECLS
+
+#define UBER_TYPE_GRAPH_GRID            (uber_graph_grid_get_type())
+#define UBER_GRAPH_GRID(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), UBER_TYPE_GRAPH_GRID, UberGraphGrid))
+#define UBER_GRAPH_GRID_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj), UBER_TYPE_GRAPH_GRID, UberGraphGrid const))
+#define UBER_GRAPH_GRID_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  UBER_TYPE_GRAPH_GRID, UberGraphGridClass))
+#define UBER_IS_GRAPH_GRID(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), UBER_TYPE_GRAPH_GRID))
+#define UBER_IS_GRAPH_GRID_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  UBER_TYPE_GRAPH_GRID))
+#define UBER_GRAPH_GRID_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  UBER_TYPE_GRAPH_GRID, UberGraphGridClass))
+
+typedef struct _UberGraphGrid        UberGraphGrid;
+typedef struct _UberGraphGridClass   UberGraphGridClass;
+typedef struct _UberGraphGridPrivate UberGraphGridPrivate;
+
+/**
+ * UberGraphGridFunc:
+ * @grid: A #UberGraphGrid.
+ * @values: An array to store the next value of each cell.
+ * @n_values: The number of elements in @values.
+ * @user_data: User data supplied to uber_graph_grid_set_values_func().
+ *
+ * Callback to retrieve the next value for every cell of the grid.  Each
+ * element of @values is -INFINITY on entry; cells left untouched have no
+ * value for the data point.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+typedef gboolean (*UberGraphGridFunc) (UberGraphGrid *grid,
+                                       gdouble       *values,
+                                       guint          n_values,
+                                       gpointer       user_data);
+
+struct _UberGraphGrid
+{
+	GtkDrawingArea parent;
+
+	/*< private >*/
+	UberGraphGridPrivate *priv;
+};
+
+struct _UberGraphGridClass
+{
+	GtkDrawingAreaClass parent_class;
+};
+
+GType      uber_graph_grid_get_type        (void) G_GNUC_CONST;
+GtkWidget* uber_graph_grid_new             (void);
+void       uber_graph_grid_set_n_cells     (UberGraphGrid     *grid,
+                                            guint              n_cells);
+guint      uber_graph_grid_get_n_cells     (UberGraphGrid     *grid);
+void       uber_graph_grid_set_cell_label  (UberGraphGrid     *grid,
+                                            guint              cell,
+                                            const gchar       *markup);
+void       uber_graph_grid_set_cell_size   (UberGraphGrid     *grid,
+                                            gint               width,
+                                            gint               height);
+void       uber_graph_grid_set_color       (UberGraphGrid     *grid,
+                                            const GdkColor    *color);
+void       uber_graph_grid_set_range       (UberGraphGrid     *grid,
+                                            const UberRange   *range);
+void       uber_graph_grid_set_values_func (UberGraphGrid     *grid,
+                                            UberGraphGridFunc  func,
+                                            gpointer           user_data,
+                                            GDestroyNotify     notify);
+
+G_END_DECLS
+
+#endif /* __UBER_GRAPH_GRID_H__ */
@@ -24,6 +24,9 @@
 
 #include "uber-graph.h"
 #include "uber-buffer.h"
+#include "uber-frame-clock.h"
+#include "uber-surface-pool.h"
+#include "uber-text-cache.h"
 
 #define BASE_CLASS   (GTK_WIDGET_CLASS(uber_graph_parent_class))
 #define DEFAULT_SIZE (64)
@@ -41,6 +44,14 @@
 #define GIBIBYTE_STR ("Gi")
 
 #define SCALE_FACTOR (1.3334)
+#define DOWNSCALE_USEC     (5 * G_USEC_PER_SEC)
+#define DATA_POINT_USEC    (G_USEC_PER_SEC)
+#define FRAME_BUDGET       (5000)
+#define GOVERNOR_ALPHA     (.2)
+#define PUSH_BLOCK         (256) /* PushNodes allocated at once. */
+#define GOVERNOR_FRAMES    (10)
+#define AREA_ALPHA         (.35)
+#define SNAP(v)            (floor(v) + .5)
 
 #define GET_PIXEL_RANGE(pr, rect)                \
     G_STMT_START {                               \
@@ -49,30 +60,28 @@
         (pr).range = (pr).end - (pr).begin;      \
     } G_STMT_END
 
-#define DRAW_Y_LABEL_FRACTION(y, i, n)                               \
-    G_STMT_START {                                                   \
-        gchar *v = uber_graph_get_ylabel_at_pos(graph, y, i, n);     \
-        gint h, w;                                                   \
-        pango_layout_set_markup(info->tick_layout, v, -1);           \
-        pango_layout_get_pixel_size(info->tick_layout, &w, &h);      \
-        cairo_move_to(info->bg_cairo,                                \
-                      priv->content_rect.x - priv->tick_len - w - 3, \
-		              ((gint)y) - (h / 2) + .5);                     \
-		pango_cairo_show_layout(info->bg_cairo, info->tick_layout);  \
-		g_free(v);                                                   \
+#define DRAW_Y_LABEL_FRACTION(y, i, n)                                     \
+    G_STMT_START {                                                         \
+        gchar *v = uber_graph_get_ylabel_at_pos(graph, y, i, n);           \
+        const UberText *t;                                                 \
+        t = uber_text_cache_lookup(v, priv->tick_font, 1.);                \
+        uber_text_cache_show(info->bg_cairo, t,                            \
+                             priv->content_rect.x - priv->tick_len         \
+                             - t->width - 3,                               \
+                             ((gint)y) - (t->height / 2));                 \
+		g_free(v);                                                         \
     } G_STMT_END
 
 #define DRAW_Y_LABEL(_y, i)                                                \
     G_STMT_START {                                                         \
     	gdouble o = i;                                                     \
-    	gchar *v;                                                          \
-        gint h, w;                                                         \
+    	gchar v[64];                                                       \
+        const UberText *t;                                                 \
         gdouble ry = _y;                                                   \
         priv->scale(graph, &priv->yrange, &pixel_range, &o);               \
-    	v = g_strdup_printf("<span size=\"smaller\">%d </span>",           \
-    	                    (gint)i);                                      \
-        pango_layout_set_markup(info->tick_layout, v, -1);                 \
-        pango_layout_get_pixel_size(info->tick_layout, &w, &h);            \
+    	g_snprintf(v, sizeof v, "<span size=\"smaller\">%d </span>",       \
+    	           (gint)i);                                               \
+        t = uber_text_cache_lookup(v, priv->tick_font, 1.);                \
         if (ry == -1) {                                                    \
 			ry = i;                                                        \
 			priv->scale(graph, &priv->yrange, &pixel_range, &ry);          \
@@ -85,11 +94,10 @@
 						  (gint)ry + .5);                                  \
 			cairo_stroke(info->bg_cairo);                                  \
 		}                                                                  \
-        cairo_move_to(info->bg_cairo,                                      \
-                      priv->content_rect.x - priv->tick_len - w - 3,       \
-		              ((gint)ry) - (h / 2) + .5);                          \
-		pango_cairo_show_layout(info->bg_cairo, info->tick_layout);        \
-		g_free(v);                                                         \
+        uber_text_cache_show(info->bg_cairo, t,                            \
+                             priv->content_rect.x - priv->tick_len         \
+                             - t->width - 3,                               \
+                             ((gint)ry) - (t->height / 2));                \
     } G_STMT_END
 
 #ifdef UBER_TRACE
@@ -137,26 +145,57 @@
  * When adding new values to the graph, the contents of the pixmap are shifted
  * and the new sliver of content added to the pixmap.  This helps reduce the
  * amount of data to send to the X-server.
+ *
+ * If the screen has no RGBA colormap, the background and foreground are kept
+ * in client-side image surfaces instead.  The foreground alpha channel holds
+ * the line coverage, and each frame is composited over the background in a
+ * scratch surface before a single upload of the damaged area.
  */
 
 G_DEFINE_TYPE(UberGraph, uber_graph, GTK_TYPE_DRAWING_AREA)
 
 typedef struct
 {
-	GdkPixmap   *bg_pixmap;   /* Server-side pixmap for background. */
-	GdkPixmap   *fg_pixmap;   /* Server-side pixmap for foreground. */
+	GdkPixmap   *bg_pixmap;   /* Server-side pixmap for background or NULL. */
+	GdkPixmap   *fg_pixmap;   /* Server-side pixmap for foreground or NULL. */
 	cairo_t     *bg_cairo;    /* Cairo context for foreground pixmap. */
 	cairo_t     *fg_cairo;    /* Cairo context for background pixmap. */
-	PangoLayout *tick_layout; /* Pango layout for tick labels. */
 } GraphInfo;
 
+typedef struct
+{
+	gdouble     sum;        /* Sum of values pushed. */
+	gdouble     max;        /* Largest value pushed. */
+	gdouble     last;       /* Value with the newest timestamp. */
+	gint64      last_time;  /* Timestamp of last. */
+	guint       count;      /* Number of values pushed. */
+} PushBin;
+
 typedef struct
 {
 	UberBuffer *buffer;
 	UberBuffer *scaled;
+	UberBuffer *stack;      /* Scaled running sum of this and lower lines. */
 	GdkColor    color;
+	PushBin     push[2];    /* Values for the next two data points. */
+	gdouble     push_last;  /* Last merged value, held between pushes. */
 } LineInfo;
 
+typedef struct _PushNode PushNode;
+
+struct _PushNode
+{
+	PushNode *next;      /* Next (older) node in the stack. */
+	gint      line;      /* Line the value belongs to. */
+	gint64    timestamp; /* Monotonic time of the value. */
+	gdouble   value;     /* The pushed value. */
+};
+
+typedef struct
+{
+	PushNode *head;      /* Free nodes owned by the thread. */
+} PushCache;
+
 struct _UberGraphPrivate
 {
 	GraphInfo         info[2];         /* Two GraphInfo's for swapping. */
@@ -165,14 +204,14 @@ struct _UberGraphPrivate
 	gdouble           line_width;      /* The desired line width. */
 	gint              fps;             /* Frames per second. */
 	gint              fps_calc;        /* Calculated FPS, might be reduced from fps. */
-	gint              fps_off;         /* Offset in frame-slide */
+	gint64            dp_time;         /* Monotonic time of last data point. */
 	gint              fps_to;          /* Frames per second timeout (in MS) */
 	gint              stride;          /* Number of data points to store. */
 	gfloat            fps_each;        /* How much each frame skews. */
 	gfloat            x_each;          /* Precalculated space between points.  */
 	UberGraphFormat   format;          /* The graph format. */
-	guint             fps_handler;     /* GSource identifier for invalidating rect. */
-	guint             down_handler;    /* Downscale timeout handler. */
+	guint             fps_handler;     /* Frame clock handler for invalidating rect. */
+	gint64            down_time;       /* Time of last downscale check. */
 	UberScale         scale;           /* Scaling of values to pixels. */
 	UberRange         yrange;          /* Y-Axis range in for raw values. */
 	GArray           *lines;           /* Lines to draw. */
@@ -183,7 +222,7 @@ struct _UberGraphPrivate
 	gboolean          show_xlabel;     /* Should the xlabels be shown. */
 	gboolean          have_rgba;       /* Do we have RGBA colormaps. */
 	GdkGC            *bg_gc;           /* Drawing context for blitting background */
-	GdkGC            *fg_gc;           /* Drawing context for blitting foreground */
+	cairo_surface_t  *compose;         /* Scratch surface when lacking RGBA. */
 	GdkRectangle      x_tick_rect;     /* Pre-calculated X tick area. */
 	GdkRectangle      y_tick_rect;     /* Pre-calculated Y tick area. */
 	GdkRectangle      content_rect;    /* Main content area. */
@@ -191,8 +230,31 @@ struct _UberGraphPrivate
 	gint              colors_len;      /* Length of colors array. */
 	gint              color;           /* Next color to hand out. */
 	UberGraphFunc     value_func;      /* Callback to retrieve next value. */
+	UberGraphValuesFunc values_func;   /* Callback to retrieve all next values. */
+	gdouble          *values;          /* Next value for each line. */
+	gdouble          *stack_values;    /* Running sums of values when stacked. */
+	guint             generation;      /* Number of data points appended. */
+	gint64            sample_time;     /* Timestamp of the last values. */
+	gint64            sample_lag;      /* How long before dp_time they were sampled. */
+	gpointer          push_head;       /* Lock-free stack of PushNodes. */
+	gboolean          pushed;          /* Have values ever been pushed. */
+	gint64            push_time[2];    /* Newest pushed timestamp per PushBin. */
+	UberGraphMerge    merge;           /* How pushed values are merged. */
 	gpointer          value_user_data; /* User data for callback. */
 	GDestroyNotify    value_notify;    /* Cleanup callback for value_user_data. */
+	UberAutoscale     autoscale;       /* Calculates the autoscaled yrange. */
+	UberAutoscalePolicy autoscale_policy; /* Autoscale tunables. */
+	gint64            autoscale_time;  /* Time of last yrange change. */
+	gboolean          viewable;        /* Can the graph be seen. */
+	gboolean          scale_dirty;     /* Rescale deferred while not viewable. */
+	PangoFontDescription *tick_font;   /* Font for tick labels. */
+	guint             frame_budget;    /* Per-frame render budget in usec. */
+	gint64            frame_acc;       /* Render cost of the current frame. */
+	gdouble           frame_cost;      /* Moving average of frame cost. */
+	gint              over_budget;     /* Consecutive frames over budget. */
+	gint              under_budget;    /* Consecutive frames with headroom. */
+	UberGraphQuality  quality;         /* Current quality tier. */
+	UberGraphLineMode line_mode;       /* How lines are drawn. */
 };
 
 typedef struct
@@ -206,7 +268,10 @@ typedef struct
 	gdouble    last_x;
 	gdouble    x_epoch;
 	gint       offset;
+	gint       decimate;
+	UberGraphLineMode mode;
 	gboolean   first;
+	gdouble    first_x;
 } RenderClosure;
 
 enum
@@ -218,6 +283,7 @@ enum
 {
 	PROP_0,
 	PROP_LINE_WIDTH,
+	PROP_QUALITY_TIER,
 };
 
 static const gchar *default_colors[] = {
@@ -228,6 +294,9 @@ static const gchar *default_colors[] = {
 	NULL
 };
 
+static gpointer       push_free  = NULL;                  /* Free PushNodes. */
+static GStaticPrivate push_cache = G_STATIC_PRIVATE_INIT; /* PushCache per thread. */
+
 static void gdk_cairo_rectangle_clean         (cairo_t      *cr,
                                                GdkRectangle *rect);
 static void pango_layout_get_pixel_rectangle  (PangoLayout  *layout,
@@ -244,6 +313,8 @@ static void uber_graph_render_bg_task         (UberGraph    *graph,
                                                GraphInfo    *info);
 static void uber_graph_scale_changed          (UberGraph    *graph);
 static void uber_graph_update_scaled          (UberGraph    *graph);
+static void uber_graph_update_fps             (UberGraph    *graph);
+static void uber_graph_downscale              (UberGraph    *graph);
 
 /**
  * uber_graph_new:
@@ -277,24 +348,48 @@ uber_graph_copy_background (UberGraph *graph, /* IN */
 	priv = graph->priv;
 	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
 	cairo_save(dst->bg_cairo);
-	gdk_cairo_set_source_pixmap(dst->bg_cairo, src->bg_pixmap, 0, 0);
+	cairo_set_source_surface(dst->bg_cairo, cairo_get_target(src->bg_cairo),
+	                         0, 0);
 	cairo_rectangle(dst->bg_cairo, 0, 0, alloc.width, alloc.height);
 	cairo_paint(dst->bg_cairo);
 	cairo_restore(dst->bg_cairo);
 	EXIT;
 }
 
+/**
+ * uber_graph_get_viewable:
+ * @graph: A #UberGraph.
+ *
+ * Checks if any part of the graph can currently be seen by the user.  While
+ * the graph is not viewable, data is still collected but no pixels are
+ * rendered.
+ *
+ * Returns: %TRUE if the graph is viewable; otherwise %FALSE.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_graph_get_viewable (UberGraph *graph) /* IN */
+{
+	return graph->priv->viewable;
+}
+
 static void
 uber_graph_scale_changed (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
-	gint fps_off;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	ENTRY;
 	priv = graph->priv;
-	fps_off = priv->fps_off;
+	/*
+	 * Rebuilding the pixmaps is expensive; wait until we can be seen.
+	 */
+	if (!uber_graph_get_viewable(graph)) {
+		priv->scale_dirty = TRUE;
+		EXIT;
+	}
+	priv->scale_dirty = FALSE;
 	uber_graph_update_scaled(graph);
 	uber_graph_calculate_rects(graph);
 	uber_graph_init_graph_info(graph, &priv->info[0]);
@@ -302,7 +397,6 @@ uber_graph_scale_changed (UberGraph *graph) /* IN */
 	uber_graph_render_bg_task(graph, &priv->info[0]);
 	uber_graph_copy_background(graph, &priv->info[0], &priv->info[1]);
 	priv->fg_dirty = TRUE;
-	priv->fps_off = fps_off;
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 	EXIT;
 }
@@ -395,281 +489,1181 @@ uber_graph_set_value_func (UberGraph      *graph,     /* IN */
 	priv->value_notify = notify;
 	priv->value_user_data = user_data;
 	priv->value_func = func;
+	priv->values_func = NULL;
+	EXIT;
+}
+
+/**
+ * uber_graph_set_values_func:
+ * @graph: A UberGraph.
+ * @func: The callback function.
+ * @user_data: user data for @func.
+ * @notify: A #GDestroyNotify to cleanup after user_data.
+ *
+ * Sets the function callback to retrieve the next value for every line of
+ * the graph in a single call.  This replaces any callback set with
+ * uber_graph_set_value_func().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_values_func (UberGraph           *graph,     /* IN */
+                            UberGraphValuesFunc  func,      /* IN */
+                            gpointer             user_data, /* IN */
+                            GDestroyNotify       notify)    /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(func != NULL);
+
+	ENTRY;
+	priv = graph->priv;
+	if (priv->value_notify) {
+		priv->value_notify(priv->value_user_data);
+	}
+	priv->value_notify = notify;
+	priv->value_user_data = user_data;
+	priv->values_func = func;
+	priv->value_func = NULL;
+	EXIT;
+}
+
+/**
+ * uber_graph_stack_push:
+ * @stack: A lock-free stack of PushNodes.
+ * @first: The first PushNode of a chain.
+ * @last: The last PushNode of the chain starting at @first.
+ *
+ * Atomically pushes a chain of PushNodes onto @stack.  This is safe to
+ * call from any thread.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_stack_push (gpointer *stack, /* IN */
+                       PushNode *first, /* IN */
+                       PushNode *last)  /* IN */
+{
+	PushNode *head;
+
+	do {
+		head = g_atomic_pointer_get(stack);
+		last->next = head;
+	} while (!g_atomic_pointer_compare_and_exchange(stack, head, first));
+}
+
+/**
+ * uber_graph_stack_take:
+ * @stack: A lock-free stack of PushNodes.
+ *
+ * Atomically takes every PushNode from @stack.  Taking the whole stack at
+ * once never reads a node another thread may own, so it is safe to call
+ * from any thread.
+ *
+ * Returns: The chain of PushNodes, newest first, or %NULL.
+ * Side effects: None.
+ */
+static inline PushNode*
+uber_graph_stack_take (gpointer *stack) /* IN */
+{
+	PushNode *head;
+
+	do {
+		if (!(head = g_atomic_pointer_get(stack))) {
+			return NULL;
+		}
+	} while (!g_atomic_pointer_compare_and_exchange(stack, head, NULL));
+	return head;
+}
+
+/**
+ * uber_graph_alloc_block:
+ *
+ * Allocates a chain of PUSH_BLOCK PushNodes.  PushNodes are never freed;
+ * they are recycled through the free stack.
+ *
+ * Returns: The first PushNode of the chain.
+ * Side effects: None.
+ */
+static PushNode*
+uber_graph_alloc_block (void)
+{
+	PushNode *block;
+	gint i;
+
+	block = g_new(PushNode, PUSH_BLOCK);
+	for (i = 0; i < PUSH_BLOCK - 1; i++) {
+		block[i].next = &block[i + 1];
+	}
+	block[PUSH_BLOCK - 1].next = NULL;
+	return block;
+}
+
+/**
+ * uber_graph_push_cache_free:
+ * @data: A PushCache.
+ *
+ * Returns the PushNodes cached by an exiting thread to the free stack.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_push_cache_free (gpointer data) /* IN */
+{
+	PushCache *cache = data;
+	PushNode *last;
+
+	if (cache->head) {
+		for (last = cache->head; last->next; last = last->next) {
+		}
+		uber_graph_stack_push(&push_free, cache->head, last);
+	}
+	g_free(cache);
+}
+
+/**
+ * uber_graph_alloc_node:
+ *
+ * Takes a PushNode from the cache of the calling thread.  An empty cache is
+ * refilled with every node on the free stack at once, so the free stack is
+ * only touched once per batch of nodes and never needs a lock.
+ *
+ * Returns: A PushNode.
+ * Side effects: None.
+ */
+static inline PushNode*
+uber_graph_alloc_node (void)
+{
+	PushCache *cache;
+	PushNode *node;
+
+	if (G_UNLIKELY(!(cache = g_static_private_get(&push_cache)))) {
+		cache = g_new0(PushCache, 1);
+		g_static_private_set(&push_cache, cache, uber_graph_push_cache_free);
+	}
+	if (G_UNLIKELY(!cache->head)) {
+		if (!(cache->head = uber_graph_stack_take(&push_free))) {
+			cache->head = uber_graph_alloc_block();
+		}
+	}
+	node = cache->head;
+	cache->head = node->next;
+	return node;
+}
+
+/**
+ * uber_graph_push:
+ * @graph: A #UberGraph.
+ * @line: The line the value belongs to, starting from 1.
+ * @timestamp: The monotonic time of the value in microseconds, or 0 for now.
+ * @value: The value.
+ *
+ * Queues @value to be added to @line.  The value is added to the first data
+ * point at or after @timestamp.  All values pushed to the same data point
+ * are merged according to uber_graph_set_merge().
+ *
+ * This function is lock-free and may be called from any thread as long as
+ * a reference to @graph is held.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_push (UberGraph *graph,     /* IN */
+                 gint       line,      /* IN */
+                 gint64     timestamp, /* IN */
+                 gdouble    value)     /* IN */
+{
+	PushNode *node;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(line > 0);
+
+	node = uber_graph_alloc_node();
+	node->line = line;
+	node->timestamp = timestamp ? timestamp : g_get_monotonic_time();
+	node->value = value;
+	uber_graph_stack_push(&graph->priv->push_head, node, node);
+}
+
+/**
+ * uber_graph_pushv:
+ * @graph: A #UberGraph.
+ * @timestamp: The monotonic time of the values in microseconds, or 0 for now.
+ * @values: An array of values, one for each line starting from line 1.
+ * @n_values: The number of elements in @values.
+ *
+ * Queues a value for each of the first @n_values lines of the graph.  The
+ * values are enqueued with a single atomic operation.  See uber_graph_push().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_pushv (UberGraph     *graph,     /* IN */
+                  gint64         timestamp, /* IN */
+                  const gdouble *values,    /* IN */
+                  guint          n_values)  /* IN */
+{
+	PushNode *first = NULL;
+	PushNode *last = NULL;
+	PushNode *node;
+	gint i;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(values != NULL || n_values == 0);
+
+	if (!n_values) {
+		return;
+	}
+	if (!timestamp) {
+		timestamp = g_get_monotonic_time();
+	}
+	for (i = n_values - 1; i >= 0; i--) {
+		node = uber_graph_alloc_node();
+		node->next = first;
+		node->line = i + 1;
+		node->timestamp = timestamp;
+		node->value = values[i];
+		first = node;
+		if (!last) {
+			last = node;
+		}
+	}
+	uber_graph_stack_push(&graph->priv->push_head, first, last);
+}
+
+/**
+ * uber_graph_set_merge:
+ * @graph: A #UberGraph.
+ * @merge: An #UberGraphMerge.
+ *
+ * Sets how multiple values pushed to a line for the same data point are
+ * merged into a single data point.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_merge (UberGraph      *graph, /* IN */
+                      UberGraphMerge  merge) /* IN */
+{
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(merge <= UBER_GRAPH_MERGE_MAX);
+
+	ENTRY;
+	graph->priv->merge = merge;
 	EXIT;
 }
 
 /**
- * uber_graph_get_next_value:
+ * uber_graph_push_bin_reset:
+ * @bin: A PushBin.
+ *
+ * Empties @bin.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_push_bin_reset (PushBin *bin) /* IN */
+{
+	bin->sum = 0.;
+	bin->max = -INFINITY;
+	bin->last = -INFINITY;
+	bin->last_time = 0;
+	bin->count = 0;
+}
+
+/**
+ * uber_graph_drain_pushed:
+ * @graph: A #UberGraph.
+ *
+ * Takes all of the values pushed since the last drain and accumulates them
+ * into the PushBin of the data point they belong to.  This must be called
+ * from the main loop.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_drain_pushed (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	PushNode *head;
+	PushNode *node;
+	PushBin *bin;
+	LineInfo *line;
+	gint64 due;
+	gint n;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	if (!(head = uber_graph_stack_take(&priv->push_head))) {
+		return;
+	}
+	/*
+	 * Values up to the pending data point go into the first bin, later ones
+	 * into the second.  Values older than the last data point arrived too
+	 * late for it and are merged into the pending one.  Before the first
+	 * data point everything is pending.
+	 */
+	due = priv->dp_time ? priv->dp_time + DATA_POINT_USEC : G_MAXINT64;
+	for (node = head; ; node = node->next) {
+		if (node->line <= priv->lines->len &&
+		    !isnan(node->value) && !isinf(node->value)) {
+			n = (node->timestamp > due) ? 1 : 0;
+			line = &g_array_index(priv->lines, LineInfo, node->line - 1);
+			bin = &line->push[n];
+			bin->sum += node->value;
+			bin->max = MAX(bin->max, node->value);
+			bin->count++;
+			/*
+			 * The stack is newest first, so a tie keeps the later push.
+			 */
+			if (bin->count == 1 || node->timestamp > bin->last_time) {
+				bin->last = node->value;
+				bin->last_time = node->timestamp;
+			}
+			priv->push_time[n] = MAX(priv->push_time[n], node->timestamp);
+		}
+		if (!node->next) {
+			break;
+		}
+	}
+	/*
+	 * Recycle the whole chain with a single atomic operation.
+	 */
+	uber_graph_stack_push(&push_free, head, node);
+	priv->pushed = TRUE;
+}
+
+/**
+ * uber_graph_merge_pushed:
+ * @graph: A #UberGraph.
+ *
+ * Merges the values pushed to each line for this data point into
+ * priv->values.  Lines that had no values pushed hold their previous value
+ * unless a value callback provided one.  Values already pushed for the
+ * following data point are kept for it.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_merge_pushed (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	LineInfo *line;
+	PushBin *bin;
+	gboolean hold;
+	gint i;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	hold = !priv->value_func && !priv->values_func;
+	for (i = 0; i < priv->lines->len; i++) {
+		line = &g_array_index(priv->lines, LineInfo, i);
+		bin = &line->push[0];
+		if (bin->count) {
+			switch (priv->merge) {
+			case UBER_GRAPH_MERGE_MEAN:
+				line->push_last = bin->sum / bin->count;
+				break;
+			case UBER_GRAPH_MERGE_MAX:
+				line->push_last = bin->max;
+				break;
+			case UBER_GRAPH_MERGE_LAST:
+			default:
+				line->push_last = bin->last;
+				break;
+			}
+			priv->values[i] = line->push_last;
+		} else if (hold) {
+			priv->values[i] = line->push_last;
+		}
+		line->push[0] = line->push[1];
+		uber_graph_push_bin_reset(&line->push[1]);
+	}
+	if (priv->push_time[0]) {
+		priv->sample_time = priv->push_time[0];
+	}
+	priv->push_time[0] = priv->push_time[1];
+	priv->push_time[1] = 0;
+}
+
+/**
+ * uber_graph_get_next_values:
  * @graph: A #UberGraph.
  *
- * Retrieves the next value for a particular line in the graph.
+ * Retrieves the next value for every line in the graph into priv->values.
+ * Lines without a value are set to -INFINITY.  priv->dp_time must already
+ * be the time of the new data point.
  *
  * Returns: None.
  * Side effects: None.
  */
 static inline void
-uber_graph_get_next_value (UberGraph *graph, /* IN */
-                           gint       line,  /* IN */
-                           LineInfo  *info,  /* IN */
-                           gdouble   *value) /* OUT */
+uber_graph_get_next_values (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
+	gint i;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
-	g_return_if_fail(info != NULL);
-	g_return_if_fail(value != NULL);
 
 	ENTRY;
 	priv = graph->priv;
-	*value = -INFINITY;
-	if (G_LIKELY(priv->value_func)) {
-		priv->value_func(graph, line, value, priv->value_user_data);
+	for (i = 0; i < priv->lines->len; i++) {
+		priv->values[i] = -INFINITY;
+	}
+	priv->sample_time = priv->dp_time;
+	if (priv->values_func) {
+		priv->values_func(graph, priv->values, priv->lines->len,
+		                  &priv->sample_time, priv->value_user_data);
+	} else if (priv->value_func) {
+		for (i = 0; i < priv->lines->len; i++) {
+			priv->value_func(graph, i + 1, &priv->values[i],
+			                 priv->value_user_data);
+		}
 	}
+	if (priv->pushed) {
+		uber_graph_merge_pushed(graph);
+	}
+	/*
+	 * Samples taken before the data point are drawn that much further to
+	 * the left.  A sample can neither be newer than the data point nor
+	 * older than the one before it.
+	 */
+	priv->sample_lag = CLAMP(priv->dp_time - priv->sample_time,
+	                         0, DATA_POINT_USEC);
 	EXIT;
 }
 
 /**
- * uber_graph_append:
+ * uber_graph_autoscale_needs_grow:
  * @graph: A #UberGraph.
- * @info: A LineInfo.
+ * @value: A raw value about to be appended.
  *
- * Appends @value to the LineInfo.  If the graph is set to autoscale
- * and the scale was changed, %TRUE will be returned.
+ * Checks if @value crosses the grow threshold of the autoscale policy.  This
+ * is a cheap test so that the autoscale function is only called for values
+ * that may actually change the range.
  *
- * Returns: %TRUE if the scale changed; otherwise %FALSE.
+ * Returns: %TRUE if the range may need to grow; otherwise %FALSE.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_graph_autoscale_needs_grow (UberGraph *graph, /* IN */
+                                 gdouble    value) /* IN */
+{
+	UberGraphPrivate *priv;
+	gdouble threshold;
+
+	priv = graph->priv;
+	threshold = priv->autoscale_policy.grow_threshold * priv->yrange.range;
+	return ((value >= priv->yrange.begin + threshold) ||
+	        (value < priv->yrange.end - threshold));
+}
+
+/**
+ * uber_graph_autoscale:
+ * @graph: A #UberGraph.
+ * @values: The range of raw values which must be visible.
+ * @allow_shrink: If the range may shrink.
+ *
+ * Applies the autoscale function to the y-axis range.  While values are
+ * being appended, @allow_shrink is %FALSE and only growth is applied.  The
+ * range is never shrunk within the policy's dwell time of the last change,
+ * which bounds the number of full re-renders for bursty series.
+ *
+ * Returns: %TRUE if the y-axis range changed; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_autoscale (UberGraph       *graph,        /* IN */
+                      const UberRange *values,       /* IN */
+                      gboolean         allow_shrink) /* IN */
+{
+	UberGraphPrivate *priv;
+	UberRange range;
+	gint64 now;
+
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+
+	ENTRY;
+	priv = graph->priv;
+	if (!priv->autoscale(graph, &priv->autoscale_policy, values,
+	                     &priv->yrange, &range)) {
+		RETURN(FALSE);
+	}
+	now = g_get_monotonic_time();
+	if (allow_shrink) {
+		if ((now - priv->autoscale_time) <
+		    ((gint64)priv->autoscale_policy.min_dwell * 1000)) {
+			allow_shrink = FALSE;
+		}
+	}
+	if (!allow_shrink) {
+		range.begin = MIN(range.begin, priv->yrange.begin);
+		range.end = MAX(range.end, priv->yrange.end);
+	}
+	if (priv->format == UBER_GRAPH_INTEGRAL) {
+		range.begin = floor(range.begin);
+		range.end = ceil(range.end);
+	}
+	range.range = range.end - range.begin;
+	if ((range.begin == priv->yrange.begin) &&
+	    (range.end == priv->yrange.end)) {
+		RETURN(FALSE);
+	}
+	priv->yrange = range;
+	priv->autoscale_time = now;
+	RETURN(TRUE);
+}
+
+/**
+ * uber_graph_stack_values:
+ * @graph: A #UberGraph.
+ * @values: The raw value of each line for a single data point.
+ * @stack: A location for the running sum at each line.
+ *
+ * Calculates the running (prefix) sum of @values for the stacked line mode.
+ * Missing values count as zero unless every line is missing, in which case
+ * every element of @stack is -INFINITY.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_stack_values (UberGraph     *graph,  /* IN */
+                         const gdouble *values, /* IN */
+                         gdouble       *stack)  /* OUT */
+{
+	UberGraphPrivate *priv = graph->priv;
+	gboolean any = FALSE;
+	gdouble sum = 0.;
+	gint i;
+
+	for (i = 0; i < priv->lines->len; i++) {
+		if (!isnan(values[i]) && !isinf(values[i])) {
+			sum += values[i];
+			any = TRUE;
+		}
+		stack[i] = sum;
+	}
+	if (!any) {
+		for (i = 0; i < priv->lines->len; i++) {
+			stack[i] = -INFINITY;
+		}
+	}
+}
+
+/**
+ * uber_graph_append_values:
+ * @graph: A #UberGraph.
+ * @values: An array containing the next value for each line.
+ *
+ * Appends the next value of every line in the graph.  If the graph is set
+ * to autoscale, the range is checked once for the whole batch before any
+ * of the values are scaled.
+ *
+ * Returns: %TRUE if the scale changed; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_append_values (UberGraph     *graph,  /* IN */
+                          const gdouble *values) /* IN */
+{
+	UberGraphPrivate *priv;
+	UberRange pixel_range;
+	UberRange batch = { INFINITY, -INFINITY, 0. };
+	LineInfo *info;
+	const gdouble *bounds = values;
+	gboolean stacked;
+	gboolean scale_changed = FALSE;
+	gdouble value;
+	gint i;
+
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+
+	ENTRY;
+	priv = graph->priv;
+	GET_PIXEL_RANGE(pixel_range, priv->content_rect);
+	/*
+	 * The running sums are calculated once here so that rendering a
+	 * stacked column never has to walk the lines below it.
+	 */
+	stacked = (priv->line_mode == UBER_GRAPH_LINE_STACKED);
+	if (stacked) {
+		uber_graph_stack_values(graph, values, priv->stack_values);
+		bounds = priv->stack_values;
+	}
+	if (priv->yautoscale) {
+		for (i = 0; i < priv->lines->len; i++) {
+			if (!isnan(bounds[i]) && !isinf(bounds[i])) {
+				batch.begin = MIN(batch.begin, bounds[i]);
+				batch.end = MAX(batch.end, bounds[i]);
+			}
+		}
+		if (batch.begin <= batch.end &&
+		    (uber_graph_autoscale_needs_grow(graph, batch.begin) ||
+		     uber_graph_autoscale_needs_grow(graph, batch.end))) {
+			batch.range = batch.end - batch.begin;
+			scale_changed = uber_graph_autoscale(graph, &batch, FALSE);
+		}
+	}
+	for (i = 0; i < priv->lines->len; i++) {
+		info = &g_array_index(priv->lines, LineInfo, i);
+		value = values[i];
+		uber_buffer_append(info->buffer, value);
+		if (value != -INFINITY) {
+			if (!priv->scale(graph, &priv->yrange, &pixel_range, &value)) {
+				value = -INFINITY;
+			}
+		}
+		uber_buffer_append(info->scaled, value);
+		if (stacked) {
+			value = priv->stack_values[i];
+			if (value != -INFINITY &&
+			    !priv->scale(graph, &priv->yrange, &pixel_range, &value)) {
+				value = -INFINITY;
+			}
+			uber_buffer_append(info->stack, value);
+		}
+	}
+	priv->generation++;
+	RETURN(scale_changed);
+}
+
+/**
+ * uber_graph_get_generation:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves a counter which is incremented each time a data point is
+ * appended to the lines of the graph.  Observers such as #UberLabel can
+ * compare it against a previous value to find how many new data points
+ * are available from uber_graph_get_line_value().
+ *
+ * Returns: The current generation.
+ * Side effects: None.
+ */
+guint
+uber_graph_get_generation (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0);
+	return graph->priv->generation;
+}
+
+/**
+ * uber_graph_get_line_value:
+ * @graph: A #UberGraph.
+ * @line: The line, starting from 1.
+ * @idx: The age of the data point, 0 being the most recent.
+ *
+ * Retrieves a raw value of @line without copying the line's buffer.
+ *
+ * Returns: The value or -INFINITY if there is no value at @idx.
+ * Side effects: None.
+ */
+gdouble
+uber_graph_get_line_value (UberGraph *graph, /* IN */
+                           guint      line,  /* IN */
+                           gint       idx)   /* IN */
+{
+	UberGraphPrivate *priv;
+	LineInfo *info;
+
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), -INFINITY);
+	g_return_val_if_fail(line > 0, -INFINITY);
+	g_return_val_if_fail(line <= graph->priv->lines->len, -INFINITY);
+
+	priv = graph->priv;
+	if (idx < 0 || idx >= priv->stride) {
+		return -INFINITY;
+	}
+	info = &g_array_index(priv->lines, LineInfo, line - 1);
+	return uber_buffer_get_index(info->buffer, idx);
+}
+
+/**
+ * uber_graph_get_line_width:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves the current line width of the lines in the graph.
+ *
+ * Returns: A #gdouble.
+ * Side effects: None.
+ */
+gdouble
+uber_graph_get_line_width (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0);
+
+	ENTRY;
+	RETURN(graph->priv->line_width);
+}
+
+/**
+ * uber_graph_set_line_width:
+ * @graph: A #UberGraph.
+ *
+ * Sets the width of the lines the graph draws.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_line_width (UberGraph *graph,      /* IN */
+                           gdouble    line_width) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	ENTRY;
+	priv = graph->priv;
+	priv->line_width = line_width;
+	EXIT;
+}
+
+/**
+ * uber_graph_set_line_mode:
+ * @graph: A #UberGraph.
+ * @mode: An #UberGraphLineMode.
+ *
+ * Sets how the lines of the graph are drawn.  %UBER_GRAPH_LINE_BEZIER is
+ * the smoothest but most expensive; the other modes stroke with butt caps
+ * and miter joins which cairo renders much faster.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_line_mode (UberGraph         *graph, /* IN */
+                          UberGraphLineMode  mode)  /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(mode <= UBER_GRAPH_LINE_STACKED);
+
+	ENTRY;
+	priv = graph->priv;
+	if ((priv->line_mode == UBER_GRAPH_LINE_STACKED) !=
+	    (mode == UBER_GRAPH_LINE_STACKED)) {
+		priv->line_mode = mode;
+		uber_graph_update_scaled(graph);
+		if (priv->yautoscale) {
+			uber_graph_downscale(graph);
+		}
+	}
+	priv->line_mode = mode;
+	priv->fg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(graph));
+	EXIT;
+}
+
+/**
+ * uber_graph_get_line_mode:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves how the lines of the graph are drawn.
+ *
+ * Returns: An #UberGraphLineMode.
+ * Side effects: None.
+ */
+UberGraphLineMode
+uber_graph_get_line_mode (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), UBER_GRAPH_LINE_BEZIER);
+	return graph->priv->line_mode;
+}
+
+/**
+ * uber_graph_set_stride:
+ * @graph: A UberGraph.
+ *
+ * Sets the number of x-axis points allowed in the circular buffer.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_stride (UberGraph *graph, /* IN */
+                       gint       stride) /* IN */
+{
+	UberGraphPrivate *priv;
+	LineInfo *line;
+	gint i;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(stride > 0);
+
+	ENTRY;
+	priv = graph->priv;
+	priv->stride = stride;
+	for (i = 0; i < priv->lines->len; i++) {
+		line = &g_array_index(priv->lines, LineInfo, i);
+		uber_buffer_set_size(line->buffer, stride);
+		uber_buffer_set_size(line->scaled, stride);
+		uber_buffer_set_size(line->stack, stride);
+	}
+	uber_graph_calculate_rects(graph);
+	uber_graph_init_graph_info(graph, &priv->info[0]);
+	uber_graph_init_graph_info(graph, &priv->info[1]);
+	EXIT;
+}
+
+/**
+ * uber_graph_set_yrange:
+ * @graph: A UberGraph.
+ * @range: An #UberRange.
+ *
+ * Sets the vertical range the graph should contain.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_yrange (UberGraph       *graph,  /* IN */
+                       const UberRange *yrange) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	ENTRY;
+	priv = graph->priv;
+	priv->yrange = *yrange;
+	if (priv->yrange.range == 0.) {
+		priv->yrange.range = priv->yrange.end - priv->yrange.begin;
+	}
+	gtk_widget_queue_draw(GTK_WIDGET(graph));
+	EXIT;
+}
+
+/**
+ * uber_graph_get_yrange:
+ * @graph: A UberGraph.
+ * @range: A location for an #UberRange.
+ *
+ * Retrieves the vertical range currently displayed by the graph.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_get_yrange (UberGraph *graph, /* IN */
+                       UberRange *range) /* OUT */
+{
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(range != NULL);
+
+	*range = graph->priv->yrange;
+}
+
+/**
+ * uber_graph_extend_range:
+ * @graph: A #UberGraph.
+ *
+ * Callback for determining the range of an #UberBuffer.
+ *
+ * Returns: always %FALSE to continue iteration.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_graph_extend_range (UberBuffer *buffer, /* IN */
+                         gdouble     value,  /* IN */
+                         UberRange  *range)  /* IN */
+{
+	g_return_val_if_fail(buffer != NULL, FALSE);
+	g_return_val_if_fail(range != NULL, FALSE);
+
+	if (isnan(value) || isinf(value)) {
+		return FALSE;
+	}
+	range->begin = MIN(range->begin, value);
+	range->end = MAX(range->end, value);
+	return FALSE;
+}
+
+/**
+ * uber_graph_downscale:
+ * @graph: An #UberGraph.
+ *
+ * Called every few seconds from the frame clock when we need to recalculate
+ * if we can shrink the range of the graph.  If the graph y-axis range can be
+ * shrunk, the the graph contents are marked dirty and re-rendered.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_downscale (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	UberRange range = { INFINITY, -INFINITY, 0. };
+	LineInfo *line;
+	gdouble *raw;
+	gint i;
+	gint j;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	ENTRY;
+	priv = graph->priv;
+	if (priv->line_mode == UBER_GRAPH_LINE_STACKED) {
+		raw = g_newa(gdouble, priv->lines->len);
+		for (j = 0; j < priv->stride; j++) {
+			for (i = 0; i < priv->lines->len; i++) {
+				line = &g_array_index(priv->lines, LineInfo, i);
+				raw[i] = uber_buffer_get_index(line->buffer, j);
+			}
+			uber_graph_stack_values(graph, raw, priv->stack_values);
+			for (i = 0; i < priv->lines->len; i++) {
+				if (priv->stack_values[i] != -INFINITY) {
+					range.begin = MIN(range.begin, priv->stack_values[i]);
+					range.end = MAX(range.end, priv->stack_values[i]);
+				}
+			}
+		}
+	} else {
+		for (i = 0; i < priv->lines->len; i++) {
+			line = &g_array_index(priv->lines, LineInfo, i);
+			uber_buffer_foreach(line->buffer, uber_graph_extend_range, &range);
+		}
+	}
+	if (range.begin > range.end) {
+		EXIT;
+	}
+	range.range = range.end - range.begin;
+	if (uber_graph_autoscale(graph, &range, TRUE)) {
+		uber_graph_scale_changed(graph);
+	}
+	EXIT;
+}
+
+/**
+ * uber_graph_set_yautoscale:
+ * @graph: A UberGraph.
+ * @yautoscale: If y-axis should autoscale to handle values outside of
+ *    its current range.
+ *
+ * Sets the graph to autoscale to handle the current range.  If @yautoscale
+ * is %TRUE, new values outside the current y range will cause the range to
+ * grow and the graph redrawn to match the new scale.  The range is compacted
+ * again once the larger values have moved off the graph.  See
+ * uber_graph_set_autoscale_policy() for tuning how eagerly that happens.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_yautoscale (UberGraph *graph,      /* IN */
+                           gboolean   yautoscale) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	ENTRY;
+	priv = graph->priv;
+	priv->yautoscale = yautoscale;
+	priv->down_time = g_get_monotonic_time();
+	EXIT;
+}
+
+/**
+ * uber_graph_get_yautoscale:
+ * @graph: A UberGraph.
+ *
+ * Retrieves if the graph is set to autoscale the y-axis.
+ *
+ * Returns: None.
  * Side effects: None.
  */
-static inline gboolean
-uber_graph_append (UberGraph *graph, /* IN */
-                   LineInfo  *info,  /* IN */
-                   gdouble    value) /* IN */
+gboolean
+uber_graph_get_yautoscale (UberGraph *graph) /* IN */
 {
-	UberGraphPrivate *priv;
-	UberRange pixel_range;
-	gboolean scale_changed = FALSE;
-
 	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
-	g_return_val_if_fail(info != NULL, FALSE);
 
 	ENTRY;
-	priv = graph->priv;
-	GET_PIXEL_RANGE(pixel_range, priv->content_rect);
-	uber_buffer_append(info->buffer, value);
-	if (value != -INFINITY) {
-		if (priv->yautoscale) {
-			if (value >= priv->yrange.end) {
-				priv->yrange.end = value + ABS((SCALE_FACTOR - 1.) * value);
-				if (priv->format == UBER_GRAPH_INTEGRAL) {
-					priv->yrange.end = ceil(priv->yrange.end);
-				}
-				priv->yrange.range = priv->yrange.end - priv->yrange.begin;
-				scale_changed = TRUE;
-			} else if (value < priv->yrange.begin) {
-				priv->yrange.begin = value - ABS((SCALE_FACTOR - 1.) * value);
-				priv->yrange.range = priv->yrange.end - priv->yrange.begin;
-				scale_changed = TRUE;
-			}
-		}
-		if (!priv->scale(graph, &priv->yrange, &pixel_range, &value)) {
-			value = -INFINITY;
-		}
-	}
-	uber_buffer_append(info->scaled, value);
-	RETURN(scale_changed);
+	RETURN(graph->priv->yautoscale);
 }
 
 /**
- * uber_graph_get_line_width:
+ * uber_graph_set_autoscale:
  * @graph: A #UberGraph.
+ * @autoscale: An #UberAutoscale function.
  *
- * Retrieves the current line width of the lines in the graph.
+ * Sets the function used to calculate the y-axis range when the graph is
+ * set to autoscale.  The default is uber_autoscale_nice().
  *
- * Returns: A #gdouble.
+ * Returns: None.
  * Side effects: None.
  */
-gdouble
-uber_graph_get_line_width (UberGraph *graph) /* IN */
+void
+uber_graph_set_autoscale (UberGraph     *graph,     /* IN */
+                          UberAutoscale  autoscale) /* IN */
 {
-	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0);
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(autoscale != NULL);
 
 	ENTRY;
-	RETURN(graph->priv->line_width);
+	graph->priv->autoscale = autoscale;
+	EXIT;
 }
 
 /**
- * uber_graph_set_line_width:
+ * uber_graph_set_autoscale_policy:
  * @graph: A #UberGraph.
+ * @policy: An #UberAutoscalePolicy.
  *
- * Sets the width of the lines the graph draws.
+ * Sets the tunables used when autoscaling the y-axis range.
  *
  * Returns: None.
  * Side effects: None.
  */
 void
-uber_graph_set_line_width (UberGraph *graph,      /* IN */
-                           gdouble    line_width) /* IN */
+uber_graph_set_autoscale_policy (UberGraph                 *graph,  /* IN */
+                                 const UberAutoscalePolicy *policy) /* IN */
 {
 	UberGraphPrivate *priv;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(policy != NULL);
+	g_return_if_fail(policy->headroom >= 0.);
+	g_return_if_fail(policy->grow_threshold > 0.);
+	g_return_if_fail(policy->shrink_threshold <= 1.);
 
 	ENTRY;
 	priv = graph->priv;
-	priv->line_width = line_width;
+	priv->autoscale_policy = *policy;
 	EXIT;
 }
 
 /**
- * uber_graph_set_stride:
- * @graph: A UberGraph.
+ * uber_graph_get_autoscale_policy:
+ * @graph: A #UberGraph.
+ * @policy: A location for an #UberAutoscalePolicy.
  *
- * Sets the number of x-axis points allowed in the circular buffer.
+ * Retrieves the tunables used when autoscaling the y-axis range.
  *
  * Returns: None.
  * Side effects: None.
  */
 void
-uber_graph_set_stride (UberGraph *graph, /* IN */
-                       gint       stride) /* IN */
+uber_graph_get_autoscale_policy (UberGraph           *graph,  /* IN */
+                                 UberAutoscalePolicy *policy) /* OUT */
 {
-	UberGraphPrivate *priv;
-	LineInfo *line;
-	gint i;
-
 	g_return_if_fail(UBER_IS_GRAPH(graph));
-	g_return_if_fail(stride > 0);
+	g_return_if_fail(policy != NULL);
 
 	ENTRY;
-	priv = graph->priv;
-	priv->stride = stride;
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		uber_buffer_set_size(line->buffer, stride);
-		uber_buffer_set_size(line->scaled, stride);
-	}
-	uber_graph_calculate_rects(graph);
-	uber_graph_init_graph_info(graph, &priv->info[0]);
-	uber_graph_init_graph_info(graph, &priv->info[1]);
+	*policy = graph->priv->autoscale_policy;
 	EXIT;
 }
 
 /**
- * uber_graph_set_yrange:
- * @graph: A UberGraph.
- * @range: An #UberRange.
+ * uber_graph_set_quality:
+ * @graph: A #UberGraph.
+ * @quality: The new #UberGraphQuality.
  *
- * Sets the vertical range the graph should contain.
+ * Switches the graph to a new quality tier.  New content is rendered using
+ * the new tier; existing content is left as is.
  *
  * Returns: None.
  * Side effects: None.
  */
-void
-uber_graph_set_yrange (UberGraph       *graph,  /* IN */
-                       const UberRange *yrange) /* IN */
+static void
+uber_graph_set_quality (UberGraph        *graph,   /* IN */
+                        UberGraphQuality  quality) /* IN */
 {
 	UberGraphPrivate *priv;
+	UberGraphQuality old_quality;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	ENTRY;
 	priv = graph->priv;
-	priv->yrange = *yrange;
-	if (priv->yrange.range == 0.) {
-		priv->yrange.range = priv->yrange.end - priv->yrange.begin;
+	old_quality = priv->quality;
+	priv->quality = quality;
+	priv->over_budget = 0;
+	priv->under_budget = 0;
+	priv->frame_cost = priv->frame_budget * .75;
+	if ((old_quality >= UBER_GRAPH_QUALITY_LOW_FPS) !=
+	    (quality >= UBER_GRAPH_QUALITY_LOW_FPS)) {
+		uber_graph_update_fps(graph);
 	}
-	gtk_widget_queue_draw(GTK_WIDGET(graph));
+	g_object_notify(G_OBJECT(graph), "quality-tier");
 	EXIT;
 }
 
 /**
- * uber_graph_extend_range:
+ * uber_graph_govern:
  * @graph: A #UberGraph.
  *
- * Callback for determining the range of an #UberBuffer.
- *
- * Returns: always %FALSE to continue iteration.
- * Side effects: None.
- */
-static inline gboolean
-uber_graph_extend_range (UberBuffer *buffer, /* IN */
-                         gdouble     value,  /* IN */
-                         UberRange  *range)  /* IN */
-{
-	g_return_val_if_fail(buffer != NULL, FALSE);
-	g_return_val_if_fail(range != NULL, FALSE);
-
-	range->begin = MIN(range->begin, value);
-	range->end = MAX(range->end, value);
-	return FALSE;
-}
-
-/**
- * uber_graph_downscale_timeout:
- * @data: An #UberGraph.
- *
- * Timeout handler called when we need to recalculate if we can shrink
- * the range of the graph.  If the graph y-axis range can be shrunk,
- * the the graph contents are marked dirty and re-rendered.
+ * Folds the cost of the previous frame into the moving average and steps
+ * the quality tier down when the frame budget is repeatedly exceeded, or
+ * back up when there is plenty of headroom.
  *
- * Returns: %TRUE always to keep the timeout continuing.
+ * Returns: None.
  * Side effects: None.
  */
-static gboolean
-uber_graph_downscale_timeout (gpointer data) /* IN */
+static void
+uber_graph_govern (UberGraph *graph) /* IN */
 {
-	UberGraph *graph = data;
 	UberGraphPrivate *priv;
-	UberRange range = { 0 };
-	UberRange yorig;
-	LineInfo *line;
-	gint i;
 
-	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	g_return_if_fail(UBER_IS_GRAPH(graph));
 
-	ENTRY;
 	priv = graph->priv;
-	yorig = priv->yrange;
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		uber_buffer_foreach(line->buffer, uber_graph_extend_range, &range);
-	}
-	if (range.begin == range.end) {
-		RETURN(TRUE);
+	priv->frame_cost = (priv->frame_cost * (1. - GOVERNOR_ALPHA))
+	                 + (priv->frame_acc * GOVERNOR_ALPHA);
+	priv->frame_acc = 0;
+	if (!priv->frame_budget) {
+		return;
 	}
-	if ((range.end * SCALE_FACTOR) < priv->yrange.end) {
-		priv->yrange.end = range.end * SCALE_FACTOR;
-		if (priv->format == UBER_GRAPH_INTEGRAL) {
-			priv->yrange.end = ceil(priv->yrange.end);
+	if (priv->frame_cost > priv->frame_budget) {
+		priv->under_budget = 0;
+		if (++priv->over_budget >= GOVERNOR_FRAMES &&
+		    priv->quality < UBER_GRAPH_QUALITY_DECIMATE) {
+			uber_graph_set_quality(graph, priv->quality + 1);
 		}
-		priv->yrange.range = priv->yrange.end - priv->yrange.begin;
-		if ((yorig.begin != priv->yrange.begin) &&
-		    (yorig.end != priv->yrange.end)) {
-			uber_graph_scale_changed(graph);
+	} else if (priv->frame_cost < (priv->frame_budget / 2.)) {
+		priv->over_budget = 0;
+		if (++priv->under_budget >= (GOVERNOR_FRAMES * 4) &&
+		    priv->quality > UBER_GRAPH_QUALITY_FULL) {
+			uber_graph_set_quality(graph, priv->quality - 1);
 		}
+	} else {
+		priv->over_budget = 0;
+		priv->under_budget = 0;
 	}
-	/* TODO: Scale yrange.begin */
-	RETURN(TRUE);
 }
 
 /**
- * uber_graph_set_yautoscale:
- * @graph: A UberGraph.
- * @yautoscale: If y-axis should autoscale to handle values outside of
- *    its current range.
- *
- * Sets the graph to autoscale to handle the current range.  If @yautoscale
- * is %TRUE, new values outside the current y range will cause the range to
- * grow and the graph redrawn to match the new scale.
+ * uber_graph_set_frame_budget:
+ * @graph: A #UberGraph.
+ * @budget: The budget in microseconds, or 0 to disable.
  *
- * In the future, the graph may compact the scale when the larger values
- * have moved off the graph.  However, this has not yet been implemented.
+ * Sets the amount of time the graph may spend each frame pulling data and
+ * rendering.  When the budget is exceeded, the graph steps down through
+ * the #UberGraphQuality tiers, and steps back up once there is headroom.
  *
  * Returns: None.
  * Side effects: None.
  */
 void
-uber_graph_set_yautoscale (UberGraph *graph,      /* IN */
-                           gboolean   yautoscale) /* IN */
+uber_graph_set_frame_budget (UberGraph *graph,  /* IN */
+                             guint      budget) /* IN */
 {
 	UberGraphPrivate *priv;
 
@@ -677,71 +1671,84 @@ uber_graph_set_yautoscale (UberGraph *graph,      /* IN */
 
 	ENTRY;
 	priv = graph->priv;
-	priv->yautoscale = yautoscale;
-	if (priv->down_handler) {
-		g_source_remove(priv->down_handler);
-	}
-	if (yautoscale) {
-		priv->down_handler =
-			g_timeout_add_seconds(5, uber_graph_downscale_timeout, graph);
+	priv->frame_budget = budget;
+	if (!budget && priv->quality != UBER_GRAPH_QUALITY_FULL) {
+		uber_graph_set_quality(graph, UBER_GRAPH_QUALITY_FULL);
 	}
 	EXIT;
 }
 
 /**
- * uber_graph_get_yautoscale:
- * @graph: A UberGraph.
+ * uber_graph_get_quality:
+ * @graph: A #UberGraph.
  *
- * Retrieves if the graph is set to autoscale the y-axis.
+ * Retrieves the quality tier the graph is currently rendered with.
  *
- * Returns: None.
+ * Returns: An #UberGraphQuality.
  * Side effects: None.
  */
-gboolean
-uber_graph_get_yautoscale (UberGraph *graph) /* IN */
+UberGraphQuality
+uber_graph_get_quality (UberGraph *graph) /* IN */
 {
-	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
-
-	ENTRY;
-	RETURN(graph->priv->yautoscale);
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), UBER_GRAPH_QUALITY_FULL);
+	return graph->priv->quality;
 }
 
 /**
  * uber_graph_fps_timeout:
- * @graph: A #UberGraph.
+ * @widget: A #UberGraph.
+ * @damage: A location for the area to invalidate.
+ * @user_data: Unused.
  *
- * GSourceFunc that is called when the amount of time has passed between each
- * frame that needs to be rendered.
+ * #UberFrameFunc that is called by the frame clock when the amount of time
+ * has passed between each frame that needs to be rendered.
  *
  * Returns: %TRUE always.
  * Side effects: None.
  */
 static gboolean
-uber_graph_fps_timeout (gpointer data) /* IN */
+uber_graph_fps_timeout (GtkWidget    *widget,    /* IN */
+                        GdkRectangle *damage,    /* OUT */
+                        gpointer      user_data) /* IN */
 {
 	UberGraphPrivate *priv;
-	UberGraph *graph = data;
-	LineInfo *info;
-	GdkWindow *window;
-	gdouble value;
-	gboolean scale_changed = FALSE;
-	gint i;
+	UberGraph *graph = UBER_GRAPH(widget);
+	gboolean scale_changed;
+	gint64 now;
 
 	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
 
 	priv = graph->priv;
+	uber_graph_govern(graph);
+	now = g_get_monotonic_time();
+	/*
+	 * Collect values pushed from other threads since the last frame.
+	 */
+	uber_graph_drain_pushed(graph);
 	/*
 	 * Retrieve the next value for the graph if necessary.
 	 */
-	if (G_UNLIKELY(priv->fps_off >= priv->fps_calc)) {
-		for (i = 0; i < priv->lines->len; i++) {
-			info = &g_array_index(priv->lines, LineInfo, i);
-			uber_graph_get_next_value(graph, i + 1, info, &value);
-			if (uber_graph_append(graph, info, value)) {
-				scale_changed = TRUE;
-			}
+	if (G_UNLIKELY(now - priv->dp_time >= DATA_POINT_USEC)) {
+		/*
+		 * Advance by whole data points so that a late tick does not drift
+		 * from wall-clock time, unless we have fallen a full point behind.
+		 */
+		priv->dp_time += DATA_POINT_USEC;
+		if (now - priv->dp_time >= DATA_POINT_USEC) {
+			priv->dp_time = now;
 		}
-		if (scale_changed) {
+		uber_graph_get_next_values(graph);
+		scale_changed = uber_graph_append_values(graph, priv->values);
+		if (!uber_graph_get_viewable(graph)) {
+			/*
+			 * Keep collecting data, but skip the pixel work.  The
+			 * foreground is rendered in full once we are visible.
+			 */
+			if (scale_changed) {
+				priv->scale_dirty = TRUE;
+			}
+			priv->fg_dirty = TRUE;
+		} else if (scale_changed) {
 			uber_graph_scale_changed(graph);
 		} else {
 			uber_graph_render_fg_shifted_task(graph,
@@ -749,13 +1756,25 @@ uber_graph_fps_timeout (gpointer data) /* IN */
 											  &priv->info[!priv->flipped]);
 			priv->flipped = !priv->flipped;
 		}
-		priv->fps_off = 0;
+	}
+	/*
+	 * Check if the y-axis range can be compacted every few seconds.
+	 */
+	if (priv->yautoscale && (now - priv->down_time >= DOWNSCALE_USEC)) {
+		priv->down_time = now;
+		uber_graph_downscale(graph);
+	}
+	priv->frame_acc += g_get_monotonic_time() - now;
+	/*
+	 * Nothing to invalidate while hidden.
+	 */
+	if (!uber_graph_get_viewable(graph)) {
+		return FALSE;
 	}
 	/*
 	 * Update the content area.
 	 */
-	window = gtk_widget_get_window(GTK_WIDGET(graph));
-	gdk_window_invalidate_rect(window, &graph->priv->content_rect, FALSE);
+	*damage = priv->content_rect;
 	return TRUE;
 }
 
@@ -781,14 +1800,40 @@ uber_graph_set_fps (UberGraph *graph, /* IN */
 	ENTRY;
 	priv = graph->priv;
 	priv->fps = fps;
+	uber_graph_update_fps(graph);
+	EXIT;
+}
+
+/**
+ * uber_graph_update_fps:
+ * @graph: A UberGraph.
+ *
+ * Calculates the frame rate actually used for the graph from the requested
+ * frames-per-second, the width of the graph, and the quality tier.  The
+ * frame clock is updated to match.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_update_fps (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	gint fps;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	ENTRY;
+	priv = graph->priv;
+	fps = priv->fps;
+	if (priv->quality >= UBER_GRAPH_QUALITY_LOW_FPS) {
+		fps = MAX(1, fps / 2);
+	}
 	priv->fps_calc = fps;
 	priv->fps_to = 1000. / fps;
 	priv->fps_each = (gfloat)priv->content_rect.width /
 	                 (gfloat)priv->stride /
-	                 (gfloat)priv->fps;
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-	}
+	                 (gfloat)fps;
 	/*
 	 * If we are moving less than one pixel per frame, then go ahead and lower
 	 * the actual framerate and move 1 pixel at a time.
@@ -796,36 +1841,40 @@ uber_graph_set_fps (UberGraph *graph, /* IN */
 	if (priv->fps_each < 1.) {
 		priv->fps_each = 1.;
 		priv->fps_calc = (gfloat)priv->content_rect.width / (gfloat)priv->stride;
-		priv->fps_to = 1000. / priv->fps_calc;
+		priv->fps_to = 1000. / MAX(1, priv->fps_calc);
+	}
+	/*
+	 * Frames are driven by the shared frame clock so that all graphs in
+	 * the process wake up and redraw together.
+	 */
+	if (priv->fps_handler) {
+		uber_frame_clock_set_fps(priv->fps_handler, priv->fps_calc);
+	} else {
+		priv->fps_handler = uber_frame_clock_add(GTK_WIDGET(graph),
+		                                         priv->fps_calc,
+		                                         uber_graph_fps_timeout,
+		                                         NULL);
 	}
-	priv->fps_handler = g_timeout_add(priv->fps_to,
-	                                  uber_graph_fps_timeout,
-	                                  graph);
 	EXIT;
 }
 
 /**
- * uber_graph_prepare_layout:
- * @graph: A #UberGraph.
- * @layout: A #PangoLayout.
+ * uber_graph_prepare_font:
  * @mode: The layout mode.
  *
- * Prepares the #PangoLayout with the settings required to render the given
- * mode, such as LAYOUT_TICK.
+ * Creates the #PangoFontDescription required to render the given mode,
+ * such as LAYOUT_TICK.
  *
- * Returns: None.
+ * Returns: A #PangoFontDescription which should be freed with
+ *   pango_font_description_free().
  * Side effects: None.
  */
-static void
-uber_graph_prepare_layout (UberGraph   *graph,  /* IN */
-                           PangoLayout *layout, /* IN */
-                           gint         mode)   /* IN */
+static PangoFontDescription*
+uber_graph_prepare_font (gint mode) /* IN */
 {
-	UberGraphPrivate *priv;
 	PangoFontDescription *desc;
 
 	ENTRY;
-	priv = graph->priv;
 	desc = pango_font_description_new();
 	switch (mode) {
 	case LAYOUT_TICK:
@@ -835,9 +1884,7 @@ uber_graph_prepare_layout (UberGraph   *graph,  /* IN */
 	default:
 		g_assert_not_reached();
 	}
-	pango_layout_set_font_description(layout, desc);
-	pango_font_description_free(desc);
-	EXIT;
+	RETURN(desc);
 }
 
 /**
@@ -881,9 +1928,7 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
-	GdkWindow *window;
-	PangoLayout *pl;
-	cairo_t *cr;
+	const UberText *tick;
 	gint tick_w;
 	gint tick_h;
 
@@ -891,22 +1936,16 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 
 	ENTRY;
 	priv = graph->priv;
-	if (!(window = gtk_widget_get_window(GTK_WIDGET(graph)))) {
+	if (!gtk_widget_get_window(GTK_WIDGET(graph))) {
 		return;
 	}
 	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
-	/*
-	 * Create a cairo context and PangoLayout to calculate the sizing
-	 * of various strings.
-	 */
-	cr = gdk_cairo_create(GDK_DRAWABLE(window));
-	pl = pango_cairo_create_layout(cr);
 	/*
 	 * Determine largest size of tick labels.
 	 */
-	uber_graph_prepare_layout(graph, pl, LAYOUT_TICK);
-	pango_layout_set_text(pl, "XXXXXXXX", -1);
-	pango_layout_get_pixel_size(pl, &tick_w, &tick_h);
+	tick = uber_text_cache_lookup("XXXXXXXX", priv->tick_font, 1.);
+	tick_w = tick->width;
+	tick_h = tick->height;
 	/*
 	 * Calculate the X-Axis tick area.
 	 */
@@ -935,12 +1974,6 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 	priv->content_rect.y = tick_h / 2 + 1;
 	priv->content_rect.width = alloc.width - priv->content_rect.x - 2;
 	priv->content_rect.height = priv->x_tick_rect.y - priv->content_rect.y - 2;
-	gdk_gc_set_clip_rectangle(priv->fg_gc, &priv->content_rect);
-	/*
-	 * Cleanup after allocations.
-	 */
-	g_object_unref(pl);
-	cairo_destroy(cr);
 	EXIT;
 }
 
@@ -959,12 +1992,11 @@ uber_graph_render_bg_x_ticks (UberGraph *graph, /* IN */
                               GraphInfo *info)  /* IN */
 {
 	UberGraphPrivate *priv;
+	const UberText *t;
 	GdkColor color;
 	gfloat fraction;
 	gint n_lines;
 	gint i;
-	gint w;
-	gint h;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
@@ -974,26 +2006,21 @@ uber_graph_render_bg_x_ticks (UberGraph *graph, /* IN */
 
 	#define DRAW_TICK_LABEL(v, o)                                            \
 	    G_STMT_START {                                                       \
-	        gint _v = (v);                                                   \
-	        gchar *_v_str;                                                   \
-	        _v_str = g_markup_printf_escaped(                                \
-	            "<span size='smaller'>%d</span>",                            \
-	            _v);                                                         \
-	        pango_layout_set_markup(info->tick_layout, _v_str, -1);          \
-	        pango_layout_get_pixel_size(info->tick_layout, &w, &h);          \
-	        if (o == 0) { \
-	             cairo_move_to(info->bg_cairo, \
-	                           priv->content_rect.x + priv->content_rect.width - w, \
-	                           priv->content_rect.y + priv->content_rect.height + priv->tick_len + 5); \
-	        } else { \
-	             cairo_move_to(info->bg_cairo,                                    \
-		                       priv->content_rect.x + priv->content_rect.width - (int)(o * (priv->x_tick_rect.width / (gfloat)n_lines)) + .5 - (w / 2), \
-	                           priv->content_rect.y + priv->content_rect.height + priv->tick_len + 5); \
-	        } \
-	        if (priv->show_xlabel) { \
-	            pango_cairo_show_layout(info->bg_cairo, info->tick_layout);      \
-			} \
-	        g_free(_v_str);                                                  \
+	        gchar _v_str[64];                                                \
+	        if (priv->show_xlabel) {                                         \
+	            g_snprintf(_v_str, sizeof _v_str,                            \
+	                       "<span size='smaller'>%d</span>", (gint)(v));     \
+	            t = uber_text_cache_lookup(_v_str, priv->tick_font, 1.);     \
+	            if (o == 0) { \
+	                uber_text_cache_show(info->bg_cairo, t, \
+	                                     priv->content_rect.x + priv->content_rect.width - t->width, \
+	                                     priv->content_rect.y + priv->content_rect.height + priv->tick_len + 5); \
+	            } else { \
+	                uber_text_cache_show(info->bg_cairo, t, \
+	                                     priv->content_rect.x + priv->content_rect.width - (int)(o * (priv->x_tick_rect.width / (gfloat)n_lines)) - (t->width / 2), \
+	                                     priv->content_rect.y + priv->content_rect.height + priv->tick_len + 5); \
+	            } \
+	        }                                                                \
 		} G_STMT_END
 
 	cairo_save(info->bg_cairo);
@@ -1049,7 +2076,8 @@ uber_graph_get_ylabel_at_pos (UberGraph *graph,  /* IN */
 	GET_PIXEL_RANGE(range, priv->content_rect);
 	switch (priv->format) {
 	CASE(UBER_GRAPH_DIRECT); {
-		f = (gfloat)(range.end - y) / (gfloat)range.range * (gfloat)priv->yrange.range;
+		f = (gfloat)(range.end - y) / (gfloat)range.range * (gfloat)priv->yrange.range
+		  + priv->yrange.begin;
 		if ( f >= 1000000000 || f <= -1000000000) {
 			f /= 1000000000;
 			a = "g ";
@@ -1064,7 +2092,8 @@ uber_graph_get_ylabel_at_pos (UberGraph *graph,  /* IN */
 		break;
 	}
 	CASE(UBER_GRAPH_DIRECT1024); {
-		f = (gfloat)(range.end - y) / (gfloat)range.range * (gfloat)priv->yrange.range;
+		f = (gfloat)(range.end - y) / (gfloat)range.range * (gfloat)priv->yrange.range
+		  + priv->yrange.begin;
 		if (f >= GIBIBYTE || f <= -GIBIBYTE) {
 			f /= GIBIBYTE;
 			a = GIBIBYTE_STR;
@@ -1144,7 +2173,6 @@ uber_graph_render_bg_y_ticks_integral (UberGraph *graph, /* IN */
 	UberRange pixel_range;
 	gdouble value;
 	gint n_lines;
-	gint end;
 	gint i;
 
 	ENTRY;
@@ -1152,13 +2180,12 @@ uber_graph_render_bg_y_ticks_integral (UberGraph *graph, /* IN */
 	GET_PIXEL_RANGE(pixel_range, priv->content_rect);
 	n_lines = MIN(5, MAX(1, (gint)priv->yrange.end - (gint)priv->yrange.begin));
 	n_lines = MIN(priv->content_rect.height / 20, n_lines);
-	end = priv->yrange.end - priv->yrange.begin;
-	DRAW_Y_LABEL((gint)pixel_range.end, 0);
+	DRAW_Y_LABEL((gint)pixel_range.end, priv->yrange.begin);
 	for (i = 1; i < n_lines; i++) {
 		value = priv->yrange.begin + (i * (priv->yrange.range / n_lines));
 		DRAW_Y_LABEL(-1, value);
 	}
-	DRAW_Y_LABEL((gint)pixel_range.begin, end);
+	DRAW_Y_LABEL((gint)pixel_range.begin, priv->yrange.end);
 	EXIT;
 }
 
@@ -1264,6 +2291,52 @@ uber_graph_render_bg_task (UberGraph *graph, /* IN */
 	EXIT;
 }
 
+/**
+ * uber_graph_line_segment:
+ * @cr: A cairo context with a current point at @last_x,@last_y.
+ * @mode: The #UberGraphLineMode.
+ * @last_x: The x position of the newer data point.
+ * @last_y: The y position of the newer data point.
+ * @x: The x position of the older data point.
+ * @y: The y position of the older data point.
+ *
+ * Adds the path segment between two data points according to @mode.  Step
+ * segments are snapped to pixel centers so cairo can use its rectilinear
+ * stroker; @x and @y are updated with the snapped position.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_line_segment (cairo_t           *cr,     /* IN */
+                         UberGraphLineMode  mode,   /* IN */
+                         gdouble            last_x, /* IN */
+                         gdouble            last_y, /* IN */
+                         gdouble           *x,      /* IN/OUT */
+                         gdouble           *y)      /* IN/OUT */
+{
+	switch (mode) {
+	case UBER_GRAPH_LINE_BEZIER:
+		cairo_curve_to(cr,
+		               last_x - ((last_x - *x) / 2.),
+		               last_y,
+		               last_x - ((last_x - *x) / 2.),
+		               *y, *x, *y);
+		break;
+	case UBER_GRAPH_LINE_STEP:
+		*x = SNAP(*x);
+		*y = SNAP(*y);
+		cairo_line_to(cr, *x, last_y);
+		cairo_line_to(cr, *x, *y);
+		break;
+	case UBER_GRAPH_LINE_LINEAR:
+	case UBER_GRAPH_LINE_AREA:
+	default:
+		cairo_line_to(cr, *x, *y);
+		break;
+	}
+}
+
 /**
  * uber_graph_render_fg_each:
  * @graph: A #UberGraph.
@@ -1289,21 +2362,31 @@ uber_graph_render_fg_each (UberBuffer *buffer,    /* IN */
 	g_return_val_if_fail(closure->graph != NULL, FALSE);
 
 	priv = closure->graph->priv;
-	x = closure->x_epoch - (closure->offset++ * priv->x_each);
+	x = closure->x_epoch - (closure->offset * priv->x_each);
 	if (isnan(value) || isinf(value)) {
+		closure->offset++;
 		goto skip;
 	}
 	y = closure->pixel_range.end - value;
 	if (G_UNLIKELY(closure->first)) {
 		closure->first = FALSE;
+		closure->offset++;
+		if (closure->mode == UBER_GRAPH_LINE_STEP) {
+			x = SNAP(x);
+			y = SNAP(y);
+		}
+		closure->first_x = x;
 		cairo_move_to(closure->info->fg_cairo, x, y);
 		goto finish;
 	}
-	cairo_curve_to(closure->info->fg_cairo,
-	               closure->last_x - (priv->x_each / 2.),
-	               closure->last_y,
-	               closure->last_x - (priv->x_each / 2.),
-	               y, x, y);
+	/*
+	 * Only every Nth data point is drawn when decimating.
+	 */
+	if (closure->offset++ % closure->decimate) {
+		return FALSE;
+	}
+	uber_graph_line_segment(closure->info->fg_cairo, closure->mode,
+	                        closure->last_x, closure->last_y, &x, &y);
   skip:
   finish:
   	closure->last_x = x;
@@ -1311,42 +2394,149 @@ uber_graph_render_fg_each (UberBuffer *buffer,    /* IN */
 	return FALSE;
 }
 
+/**
+ * uber_graph_get_line_mode_for_render:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves the line mode to render with, taking the quality tier into
+ * account.
+ *
+ * Returns: An #UberGraphLineMode.
+ * Side effects: None.
+ */
+static inline UberGraphLineMode
+uber_graph_get_line_mode_for_render (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv = graph->priv;
+
+	if (priv->line_mode == UBER_GRAPH_LINE_BEZIER &&
+	    priv->quality >= UBER_GRAPH_QUALITY_LINEAR) {
+		return UBER_GRAPH_LINE_LINEAR;
+	}
+	return priv->line_mode;
+}
+
+/**
+ * uber_graph_fill_area:
+ * @graph: A #UberGraph.
+ * @cr: A cairo context containing the area path.
+ *
+ * Fills the current path of @cr using a translucent version of the current
+ * source.  The path is consumed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_fill_area (UberGraph *graph, /* IN */
+                      cairo_t   *cr)    /* IN */
+{
+	cairo_save(cr);
+	cairo_clip(cr);
+	cairo_paint_with_alpha(cr, AREA_ALPHA);
+	cairo_restore(cr);
+}
+
 /**
  * uber_graph_stylize_line:
  * @graph: A #UberGraph.
- * @line: A LineInfo.
- * @cr: A cairo context.
+ * @line: A LineInfo.
+ * @cr: A cairo context.
+ *
+ * Stylizes the cairo context according to the lines settings.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_stylize_line (UberGraph *graph, /* IN */
+                         LineInfo  *line,  /* IN */
+                         cairo_t   *cr)    /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(line != NULL);
+	g_return_if_fail(cr != NULL);
+
+	priv = graph->priv;
+	cairo_set_line_width(cr, priv->line_width);
+	gdk_cairo_set_source_color(cr, &line->color);
+	/*
+	 * Round caps and joins are only needed to smooth curves.  Butt caps
+	 * and miter joins let cairo use its much faster polyline stroker.
+	 */
+	if (uber_graph_get_line_mode_for_render(graph) == UBER_GRAPH_LINE_BEZIER) {
+		cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+		cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+	} else {
+		cairo_set_line_cap(cr, CAIRO_LINE_CAP_BUTT);
+		cairo_set_line_join(cr, CAIRO_LINE_JOIN_MITER);
+	}
+	cairo_set_antialias(cr, (priv->quality >= UBER_GRAPH_QUALITY_NO_ANTIALIAS)
+	                        ? CAIRO_ANTIALIAS_NONE
+	                        : CAIRO_ANTIALIAS_DEFAULT);
+}
+
+/**
+ * uber_graph_render_fg_stacked:
+ * @graph: A #UberGraph.
+ * @info: A GraphInfo.
+ * @closure: The prepared RenderClosure.
  *
- * Stylizes the cairo context according to the lines settings.
+ * Renders the foreground for the stacked line mode.  Each line is filled
+ * as a band between its running sum and the running sum of the line below.
  *
  * Returns: None.
  * Side effects: None.
  */
-static inline void
-uber_graph_stylize_line (UberGraph *graph, /* IN */
-                         LineInfo  *line,  /* IN */
-                         cairo_t   *cr)    /* IN */
+static void
+uber_graph_render_fg_stacked (UberGraph     *graph,   /* IN */
+                              GraphInfo     *info,    /* IN */
+                              RenderClosure *closure) /* IN */
 {
 	UberGraphPrivate *priv;
-	GdkColor color;
-	GdkColor white;
+	LineInfo *line;
+	LineInfo *lower = NULL;
+	gdouble bottom;
+	gdouble top;
+	gint count;
+	gint i;
+	gint j;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
-	g_return_if_fail(line != NULL);
-	g_return_if_fail(cr != NULL);
 
+	ENTRY;
 	priv = graph->priv;
-	cairo_set_line_width(cr, priv->line_width);
-	color = line->color;
-	if (!priv->have_rgba) {
-		white = gtk_widget_get_style(GTK_WIDGET(graph))->light[GTK_STATE_NORMAL];
-		color.red ^= white.red;
-		color.green ^= white.green;
-		color.blue ^= white.blue;
+	for (i = 0; i < priv->lines->len; i++, lower = line) {
+		line = &g_array_index(priv->lines, LineInfo, i);
+		uber_graph_stylize_line(graph, line, info->fg_cairo);
+		for (count = 0; count < priv->stride; count++) {
+			top = uber_buffer_get_index(line->stack, count);
+			if (isnan(top) || isinf(top)) {
+				break;
+			}
+			cairo_line_to(info->fg_cairo,
+			              closure->x_epoch - (count * priv->x_each),
+			              closure->pixel_range.end - top);
+		}
+		if (count < 2) {
+			cairo_new_path(info->fg_cairo);
+			continue;
+		}
+		for (j = count - 1; j >= 0; j--) {
+			bottom = lower ? uber_buffer_get_index(lower->stack, j) : 0.;
+			if (isnan(bottom) || isinf(bottom)) {
+				bottom = 0.;
+			}
+			cairo_line_to(info->fg_cairo,
+			              closure->x_epoch - (j * priv->x_each),
+			              closure->pixel_range.end - bottom);
+		}
+		cairo_close_path(info->fg_cairo);
+		cairo_fill(info->fg_cairo);
 	}
-	gdk_cairo_set_source_color(cr, &color);
-	cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-	cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+	EXIT;
 }
 
 /**
@@ -1367,6 +2557,7 @@ uber_graph_render_fg_task (UberGraph *graph, /* IN */
 	GtkAllocation alloc;
 	RenderClosure closure = { 0 };
 	LineInfo *line;
+	cairo_path_t *path;
 	gint i;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
@@ -1384,6 +2575,8 @@ uber_graph_render_fg_task (UberGraph *graph, /* IN */
 	GET_PIXEL_RANGE(closure.pixel_range, priv->content_rect);
 	closure.value_range = priv->yrange;
 	closure.x_epoch = priv->content_rect.x + priv->content_rect.width + priv->x_each;
+	closure.mode = uber_graph_get_line_mode_for_render(graph);
+	closure.decimate = (priv->quality >= UBER_GRAPH_QUALITY_DECIMATE) ? 2 : 1;
 	/*
 	 * Clear the background.
 	 */
@@ -1402,22 +2595,36 @@ uber_graph_render_fg_task (UberGraph *graph, /* IN */
 	                priv->content_rect.width + priv->x_each,
 	                priv->content_rect.height);
 	cairo_clip(info->fg_cairo);
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		closure.last_x = -INFINITY;
-		closure.last_y = -INFINITY;
-		closure.first = TRUE;
-		closure.offset = 0;
-		cairo_move_to(info->fg_cairo,
-		              closure.x_epoch,
-		              priv->content_rect.y + priv->content_rect.height - 1);
-		uber_graph_stylize_line(graph, line, info->fg_cairo);
-		uber_buffer_foreach(line->scaled, uber_graph_render_fg_each, &closure);
-		cairo_stroke(info->fg_cairo);
+	if (closure.mode == UBER_GRAPH_LINE_STACKED) {
+		uber_graph_render_fg_stacked(graph, info, &closure);
+	} else {
+		for (i = 0; i < priv->lines->len; i++) {
+			line = &g_array_index(priv->lines, LineInfo, i);
+			closure.last_x = -INFINITY;
+			closure.last_y = -INFINITY;
+			closure.first = TRUE;
+			closure.offset = 0;
+			cairo_move_to(info->fg_cairo,
+			              closure.x_epoch,
+			              priv->content_rect.y + priv->content_rect.height - 1);
+			uber_graph_stylize_line(graph, line, info->fg_cairo);
+			uber_buffer_foreach(line->scaled, uber_graph_render_fg_each, &closure);
+			if (closure.mode == UBER_GRAPH_LINE_AREA && !closure.first) {
+				path = cairo_copy_path(info->fg_cairo);
+				cairo_line_to(info->fg_cairo, closure.last_x,
+				              closure.pixel_range.end);
+				cairo_line_to(info->fg_cairo, closure.first_x,
+				              closure.pixel_range.end);
+				cairo_close_path(info->fg_cairo);
+				uber_graph_fill_area(graph, info->fg_cairo);
+				cairo_append_path(info->fg_cairo, path);
+				cairo_path_destroy(path);
+			}
+			cairo_stroke(info->fg_cairo);
+		}
 	}
 	cairo_restore(info->fg_cairo);
 	priv->fg_dirty = FALSE;
-	priv->fps_off++;
 	EXIT;
 }
 
@@ -1442,9 +2649,16 @@ uber_graph_render_fg_shifted_task (UberGraph    *graph,  /* IN */
 	UberGraphPrivate *priv;
 	LineInfo *line;
 	GtkAllocation alloc;
+	UberGraphLineMode mode;
+	LineInfo *lower = NULL;
+	gdouble bottom;
+	gdouble last_bottom;
 	gdouble last_y;
 	gdouble x_epoch;
+	gdouble x_prev;
+	gdouble clip_x;
 	gdouble y_end;
+	gdouble x;
 	gdouble y;
 	gint i;
 
@@ -1470,7 +2684,8 @@ uber_graph_render_fg_shifted_task (UberGraph    *graph,  /* IN */
 	 */
 	cairo_save(dst->fg_cairo);
 	cairo_set_operator(dst->fg_cairo, CAIRO_OPERATOR_OVER);
-	gdk_cairo_set_source_pixmap(dst->fg_cairo, src->fg_pixmap, -(gint)priv->x_each, 0);
+	cairo_set_source_surface(dst->fg_cairo, cairo_get_target(src->fg_cairo),
+	                         -(gint)priv->x_each, 0);
 	cairo_rectangle(dst->fg_cairo, 0, 0, alloc.width, alloc.height);
 	cairo_fill(dst->fg_cairo);
 	cairo_restore(dst->fg_cairo);
@@ -1479,13 +2694,48 @@ uber_graph_render_fg_shifted_task (UberGraph    *graph,  /* IN */
 	 */
 	y_end = priv->content_rect.y + priv->content_rect.height - 1;
 	x_epoch = priv->content_rect.x + priv->content_rect.width + priv->x_each;
+	mode = uber_graph_get_line_mode_for_render(graph);
+	x_prev = priv->content_rect.x + priv->content_rect.width;
+	/*
+	 * Step lines have their vertical on the edge of the new area, so
+	 * extend the clip far enough to include the whole stroke.
+	 */
+	clip_x = x_prev;
+	if (mode == UBER_GRAPH_LINE_STEP) {
+		clip_x -= ceil(priv->line_width);
+	}
 	cairo_save(dst->fg_cairo);
 	cairo_rectangle(dst->fg_cairo,
-	                priv->content_rect.x + priv->content_rect.width,
+	                clip_x,
 	                priv->content_rect.y,
-	                priv->x_each,
+	                x_epoch - clip_x,
 	                priv->content_rect.height);
 	cairo_clip(dst->fg_cairo);
+	/*
+	 * Stacked bands only need the new column filled; the running sums were
+	 * calculated when the values were appended.
+	 */
+	if (mode == UBER_GRAPH_LINE_STACKED) {
+		for (i = 0; i < priv->lines->len; i++, lower = line) {
+			line = &g_array_index(priv->lines, LineInfo, i);
+			y = uber_buffer_get_index(line->stack, 0);
+			last_y = uber_buffer_get_index(line->stack, 1);
+			if ((isnan(y) || isinf(y)) || (isnan(last_y) || isinf(last_y))) {
+				continue;
+			}
+			bottom = lower ? uber_buffer_get_index(lower->stack, 0) : 0.;
+			last_bottom = lower ? uber_buffer_get_index(lower->stack, 1) : 0.;
+			uber_graph_stylize_line(graph, line, dst->fg_cairo);
+			cairo_move_to(dst->fg_cairo, x_epoch, y_end - y);
+			cairo_line_to(dst->fg_cairo, x_prev, y_end - last_y);
+			cairo_line_to(dst->fg_cairo, x_prev, y_end - last_bottom);
+			cairo_line_to(dst->fg_cairo, x_epoch, y_end - bottom);
+			cairo_close_path(dst->fg_cairo);
+			cairo_fill(dst->fg_cairo);
+		}
+		cairo_restore(dst->fg_cairo);
+		EXIT;
+	}
 	for (i = 0; i < priv->lines->len; i++) {
 		line = &g_array_index(priv->lines, LineInfo, i);
 		y = uber_buffer_get_index(line->scaled, 0);
@@ -1502,28 +2752,115 @@ uber_graph_render_fg_shifted_task (UberGraph    *graph,  /* IN */
 		 * Convert relative position to fixed from bottom pixel.
 		 */
 		uber_graph_stylize_line(graph, line, dst->fg_cairo);
+		x = x_prev;
+		if (mode == UBER_GRAPH_LINE_STEP) {
+			y = SNAP(y);
+		}
+		if (mode == UBER_GRAPH_LINE_AREA) {
+			cairo_move_to(dst->fg_cairo, x_epoch, y);
+			cairo_line_to(dst->fg_cairo, x, last_y);
+			cairo_line_to(dst->fg_cairo, x, y_end);
+			cairo_line_to(dst->fg_cairo, x_epoch, y_end);
+			cairo_close_path(dst->fg_cairo);
+			uber_graph_fill_area(graph, dst->fg_cairo);
+		}
 		cairo_move_to(dst->fg_cairo, x_epoch, y);
-		cairo_curve_to(dst->fg_cairo,
-		               x_epoch - (priv->x_each / 2.),
-		               y,
-		               x_epoch - (priv->x_each / 2.),
-		               last_y,
-		               priv->content_rect.x + priv->content_rect.width,
-		               last_y);
+		uber_graph_line_segment(dst->fg_cairo, mode, x_epoch, y, &x, &last_y);
 		cairo_stroke(dst->fg_cairo);
 	}
 	cairo_restore(dst->fg_cairo);
 	EXIT;
 }
 
+/**
+ * uber_graph_release_texture:
+ * @cr: A location of a cairo context.
+ * @pixmap: A location of a #GdkPixmap.
+ *
+ * Releases a texture of a GraphInfo.  Pixmaps are handed back to the
+ * surface pool.
+ *
+ * Returns: None.
+ * Side effects: @cr and @pixmap are set to %NULL.
+ */
+static void
+uber_graph_release_texture (cairo_t   **cr,     /* IN/OUT */
+                            GdkPixmap **pixmap) /* IN/OUT */
+{
+	if (*cr) {
+		cairo_destroy(*cr);
+		*cr = NULL;
+	}
+	if (*pixmap) {
+		uber_surface_pool_release_pixmap(*pixmap);
+		*pixmap = NULL;
+	}
+}
+
+/**
+ * uber_graph_init_texture:
+ * @graph: A #UberGraph.
+ * @drawable: The #GdkDrawable of the graph.
+ * @cr: A location of a cairo context.
+ * @pixmap: A location of a #GdkPixmap.
+ * @width: The width of the texture.
+ * @height: The height of the texture.
+ * @alpha: If the texture needs an alpha channel.
+ *
+ * Ensures a texture of a GraphInfo is at least @width by @height.  With
+ * RGBA colormaps, the texture is a pooled server-side pixmap.  Otherwise it
+ * is a client-side image surface which is composited in the expose handler.
+ * An existing texture is kept if it still fits.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_init_texture (UberGraph    *graph,    /* IN */
+                         GdkDrawable  *drawable, /* IN */
+                         cairo_t     **cr,       /* IN/OUT */
+                         GdkPixmap   **pixmap,   /* IN/OUT */
+                         gint          width,    /* IN */
+                         gint          height,   /* IN */
+                         gboolean      alpha)    /* IN */
+{
+	cairo_surface_t *surface;
+
+	if (graph->priv->have_rgba) {
+		if (*pixmap &&
+		    uber_surface_pool_pixmap_fits(*pixmap, width, height, alpha)) {
+			return;
+		}
+		uber_graph_release_texture(cr, pixmap);
+		*pixmap = uber_surface_pool_acquire_pixmap(drawable, width, height,
+		                                           alpha);
+		*cr = gdk_cairo_create(GDK_DRAWABLE(*pixmap));
+	} else {
+		if (*cr && !*pixmap) {
+			surface = cairo_get_target(*cr);
+			if (cairo_image_surface_get_width(surface) == width &&
+			    cairo_image_surface_get_height(surface) == height) {
+				return;
+			}
+		}
+		uber_graph_release_texture(cr, pixmap);
+		surface = cairo_image_surface_create(alpha ? CAIRO_FORMAT_ARGB32
+		                                           : CAIRO_FORMAT_RGB24,
+		                                     width, height);
+		*cr = cairo_create(surface);
+		cairo_surface_destroy(surface);
+	}
+}
+
 /**
  * uber_graph_init_graph_info:
  * @graph: A #UberGraph.
  * @info: A GraphInfo.
  *
  * Initializes the GraphInfo structure to match the current settings of the
- * #UberGraph.  If @info has existing server-side pixmaps, they will be scaled
- * to match the new size of the widget.
+ * #UberGraph.  Pixmaps come from the surface pool in bucketed sizes, so
+ * existing pixmaps and cairo contexts are kept when the new size falls in
+ * the same bucket; only their clip is updated to the new extents.
  *
  * The renderer will perform a redraw of the entire area on its next pass as
  * the contents will potentially be lossy and skewed.  But this is still far
@@ -1539,12 +2876,7 @@ uber_graph_init_graph_info (UberGraph *graph, /* IN */
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
 	GdkDrawable *drawable;
-	GdkPixmap *bg_pixmap;
-	GdkPixmap *fg_pixmap;
-	GdkColormap *colormap;
-	GdkVisual *visual;
 	GdkColor bg_color;
-	cairo_t *cr;
 	gint fg_width;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
@@ -1554,78 +2886,41 @@ uber_graph_init_graph_info (UberGraph *graph, /* IN */
 	priv = graph->priv;
 	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
 	drawable = GDK_DRAWABLE(gtk_widget_get_window(GTK_WIDGET(graph)));
-	priv->have_rgba = !!gdk_screen_get_rgba_colormap(gdk_drawable_get_screen(drawable));
-	bg_pixmap = gdk_pixmap_new(drawable, alloc.width, alloc.height, -1);
 	/*
 	 * Try to use a 32-bit colormap for alpha channel. If the system doesn't
-	 * support it, we need to note it so we can fallback to an XOR draw.
+	 * support it, we fall back to compositing client-side.
 	 */
+	priv->have_rgba = !!gdk_screen_get_rgba_colormap(gdk_drawable_get_screen(drawable));
 	fg_width = alloc.width + priv->x_each + 1;
-	if (priv->have_rgba) {
-		visual = gdk_visual_get_best_with_depth(32);
-		fg_pixmap = gdk_pixmap_new(NULL, fg_width, alloc.height, 32);
-		colormap = gdk_colormap_new(visual, FALSE);
-		gdk_drawable_set_colormap(GDK_DRAWABLE(fg_pixmap), colormap);
-		g_object_unref(colormap);
-	} else {
-		fg_pixmap = gdk_pixmap_new(drawable, fg_width, alloc.height, -1);
-	}
+	uber_graph_init_texture(graph, drawable, &info->bg_cairo, &info->bg_pixmap,
+	                        alloc.width, alloc.height, FALSE);
+	uber_graph_init_texture(graph, drawable, &info->fg_cairo, &info->fg_pixmap,
+	                        fg_width, alloc.height, TRUE);
+	/*
+	 * Pooled pixmaps may be larger than requested; restrict drawing to the
+	 * extents of the widget.
+	 */
+	cairo_reset_clip(info->bg_cairo);
+	cairo_rectangle(info->bg_cairo, 0, 0, alloc.width, alloc.height);
+	cairo_clip(info->bg_cairo);
+	cairo_reset_clip(info->fg_cairo);
+	cairo_rectangle(info->fg_cairo, 0, 0, fg_width, alloc.height);
+	cairo_clip(info->fg_cairo);
 	/*
 	 * Set background to default widget background.
 	 */
 	bg_color = gtk_widget_get_style(GTK_WIDGET(graph))->bg[GTK_STATE_NORMAL];
-	cr = gdk_cairo_create(GDK_DRAWABLE(bg_pixmap));
-	gdk_cairo_set_source_color(cr, &bg_color);
-	cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-	cairo_fill(cr);
-	cairo_destroy(cr);
+	cairo_save(info->bg_cairo);
+	gdk_cairo_set_source_color(info->bg_cairo, &bg_color);
+	cairo_paint(info->bg_cairo);
+	cairo_restore(info->bg_cairo);
 	/*
 	 * Clear contents of foreground.
 	 */
-	cr = gdk_cairo_create(GDK_DRAWABLE(fg_pixmap));
-	cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-	cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-	cairo_set_source_rgb(cr, 1, 1, 1);
-	cairo_paint(cr);
-	cairo_destroy(cr);
-	/*
-	 * Cleanup after any previous cairo contexts.
-	 */
-	if (info->bg_cairo) {
-		if (info->tick_layout) {
-			g_object_unref(info->tick_layout);
-		}
-		cairo_destroy(info->bg_cairo);
-	}
-	if (info->fg_cairo) {
-		cairo_destroy(info->fg_cairo);
-	}
-	/*
-	 * If there is an existing pixmap, we will scale it to the new size
-	 * so that there is data to render until the render thread has had
-	 * a chance to pass over and re-render the updated content.
-	 */
-	if (info->bg_pixmap) {
-		g_object_unref(info->bg_pixmap);
-	}
-	if (info->fg_pixmap) {
-		g_object_unref(info->fg_pixmap);
-	}
-	info->bg_pixmap = bg_pixmap;
-	info->fg_pixmap = fg_pixmap;
-	/*
-	 * Update cached cairo contexts.
-	 */
-	info->bg_cairo = gdk_cairo_create(GDK_DRAWABLE(info->bg_pixmap));
-	info->fg_cairo = gdk_cairo_create(GDK_DRAWABLE(info->fg_pixmap));
-	/*
-	 * Create PangoLayouts for rendering text.
-	 */
-	info->tick_layout = pango_cairo_create_layout(info->bg_cairo);
-	/*
-	 * Update the layouts to reflect proper styling.
-	 */
-	uber_graph_prepare_layout(graph, info->tick_layout, LAYOUT_TICK);
+	cairo_save(info->fg_cairo);
+	cairo_set_operator(info->fg_cairo, CAIRO_OPERATOR_CLEAR);
+	cairo_paint(info->fg_cairo);
+	cairo_restore(info->fg_cairo);
 	EXIT;
 }
 
@@ -1634,7 +2929,8 @@ uber_graph_init_graph_info (UberGraph *graph, /* IN */
  * @graph: A #UberGraph.
  * @info: A GraphInfo.
  *
- * Cleans up and frees resources allocated to the GraphInfo.
+ * Cleans up resources allocated to the GraphInfo.  The pixmaps are handed
+ * back to the surface pool.
  *
  * Returns: None.
  * Side effects: None.
@@ -1644,21 +2940,8 @@ uber_graph_destroy_graph_info (UberGraph *graph, /* IN */
                                GraphInfo *info)  /* IN */
 {
 	ENTRY;
-	if (info->tick_layout) {
-		g_object_unref(info->tick_layout);
-	}
-	if (info->bg_cairo) {
-		cairo_destroy(info->bg_cairo);
-	}
-	if (info->fg_cairo) {
-		cairo_destroy(info->fg_cairo);
-	}
-	if (info->bg_pixmap) {
-		g_object_unref(info->bg_pixmap);
-	}
-	if (info->fg_pixmap) {
-		g_object_unref(info->fg_pixmap);
-	}
+	uber_graph_release_texture(&info->bg_cairo, &info->bg_pixmap);
+	uber_graph_release_texture(&info->fg_cairo, &info->fg_pixmap);
 	EXIT;
 }
 
@@ -1677,6 +2960,7 @@ uber_graph_update_scaled (UberGraph *graph) /* IN */
 	UberGraphPrivate *priv;
 	UberRange pixel_range = { 0 };
 	LineInfo *line;
+	gdouble *raw;
 	gdouble value;
 	gint i;
 	gint j;
@@ -1696,6 +2980,28 @@ uber_graph_update_scaled (UberGraph *graph) /* IN */
 			}
 		}
 	}
+	/*
+	 * Rebuild the running sums from the oldest data point forward.
+	 */
+	if (priv->line_mode == UBER_GRAPH_LINE_STACKED && priv->lines->len) {
+		raw = g_newa(gdouble, priv->lines->len);
+		for (j = priv->stride - 1; j >= 0; j--) {
+			for (i = 0; i < priv->lines->len; i++) {
+				line = &g_array_index(priv->lines, LineInfo, i);
+				raw[i] = uber_buffer_get_index(line->buffer, j);
+			}
+			uber_graph_stack_values(graph, raw, priv->stack_values);
+			for (i = 0; i < priv->lines->len; i++) {
+				line = &g_array_index(priv->lines, LineInfo, i);
+				value = priv->stack_values[i];
+				if (value != -INFINITY &&
+				    !priv->scale(graph, &priv->yrange, &pixel_range, &value)) {
+					value = -INFINITY;
+				}
+				uber_buffer_append(line->stack, value);
+			}
+		}
+	}
 	EXIT;
 }
 
@@ -1766,13 +3072,47 @@ gdk_cairo_rectangle_clean (cairo_t      *cr,   /* IN */
 	cairo_rectangle(cr, x, y, w, h);
 }
 
+/**
+ * uber_graph_get_fps_offset:
+ * @graph: A #UberGraph.
+ *
+ * Calculates the number of pixels that the foreground should be shifted
+ * from the origin based on the time elapsed since the newest values were
+ * sampled, so that they are placed at their timestamp.  The offset is
+ * fractional and never passes the next data point, so a late frame only
+ * costs smoothness.
+ *
+ * Returns: The pixel offset to render the foreground.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_graph_get_fps_offset (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	gdouble offset;
+	gdouble lag;
+
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0.);
+
+	priv = graph->priv;
+	lag = (gdouble)priv->sample_lag / DATA_POINT_USEC * priv->x_each;
+	offset = (gdouble)(g_get_monotonic_time() - priv->dp_time)
+	       / DATA_POINT_USEC
+	       * priv->x_each;
+	return CLAMP(offset, 0., priv->x_each) + lag;
+}
+
 /**
  * uber_graph_expose_event:
  * @widget: A #UberGraph.
  * @expose: A #GdkEventExpose.
  *
- * Handles the "expose-event" for the GtkWidget.  The current server-side
- * pixmaps are blitted as necessary.
+ * Handles the "expose-event" for the GtkWidget.  The background is copied
+ * to the exposed area and the foreground blended over the content area at
+ * its scroll offset.  The offset is fractional and changes every frame, so
+ * the foreground is not merged into a cache first.  When RGBA colormaps
+ * are unavailable, the client-side textures are composited in a scratch
+ * surface and the exposed area is uploaded once.
  *
  * Returns: %TRUE if handler chain should stop; otherwise %FALSE.
  * Side effects: None.
@@ -1784,24 +3124,40 @@ uber_graph_expose_event (GtkWidget      *widget, /* IN */
 	UberGraphPrivate *priv;
 	GdkDrawable *dst;
 	GraphInfo *info;
-	GdkRectangle clip;
 	GdkRectangle area;
 	cairo_t *cr;
 	GtkAllocation alloc;
+	gdouble offset;
+	gint64 begin;
 
 	g_return_val_if_fail(UBER_IS_GRAPH(widget), FALSE);
 	g_return_val_if_fail(expose != NULL, FALSE);
 
+	begin = g_get_monotonic_time();
 	priv = UBER_GRAPH(widget)->priv;
 	gtk_widget_get_allocation(widget, &alloc);
 	dst = expose->window;
 	info = &priv->info[priv->flipped];
-	cr = gdk_cairo_create(dst);
 	/*
-	 * Set the clip region.
+	 * Without RGBA colormaps the textures live client-side.  Composite them
+	 * into a scratch surface so that only one upload of the exposed area is
+	 * sent to the X-server.
 	 */
-	gdk_cairo_rectangle(cr, &expose->area);
-	cairo_clip(cr);
+	if (G_LIKELY(priv->have_rgba)) {
+		cr = gdk_cairo_create(dst);
+	} else {
+		if (!priv->compose ||
+		    cairo_image_surface_get_width(priv->compose) != alloc.width ||
+		    cairo_image_surface_get_height(priv->compose) != alloc.height) {
+			if (priv->compose) {
+				cairo_surface_destroy(priv->compose);
+			}
+			priv->compose = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+			                                           alloc.width,
+			                                           alloc.height);
+		}
+		cr = cairo_create(priv->compose);
+	}
 	/*
 	 * Render the background to the pixmap again if needed.
 	 */
@@ -1811,22 +3167,10 @@ uber_graph_expose_event (GtkWidget      *widget, /* IN */
 		                           &priv->info[!priv->flipped]);
 		priv->bg_dirty = FALSE;
 	}
+	g_assert(info->bg_cairo);
+	g_assert(info->fg_cairo);
 	/*
-	 * Blit the background to the exposure area.
-	 */
-	g_assert(info->bg_pixmap);
-	gdk_cairo_set_source_pixmap(cr, info->bg_pixmap, 0, 0);
-	cairo_rectangle(cr,
-	                expose->area.x, expose->area.y,
-	                expose->area.width, expose->area.height);
-	cairo_paint(cr);
-	/*
-	 * If the foreground is dirty, we need to re-render its entire
-	 * contents.
-	 */
-	g_assert(info->fg_pixmap);
-	/*
-	 * Determine the foreground clipping area.
+	 * Determine the content area.
 	 */
 	area = priv->content_rect;
 	area.x += 1;
@@ -1839,69 +3183,41 @@ uber_graph_expose_event (GtkWidget      *widget, /* IN */
 	if (priv->fg_dirty) {
 		uber_graph_render_fg_task(UBER_GRAPH(widget), info);
 	}
+	if (G_UNLIKELY(priv->fg_dirty)) {
+		offset = 0.;
+	} else {
+		offset = uber_graph_get_fps_offset(UBER_GRAPH(widget));
+	}
 	/*
-	 * Determine the clip region for the foreground.
+	 * Copy the background to the exposed area without blending.
 	 */
-	gdk_rectangle_intersect(&area, &expose->area, &clip);
+	gdk_cairo_region(cr, expose->region);
+	cairo_clip(cr);
+	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_surface(cr, cairo_get_target(info->bg_cairo), 0, 0);
+	cairo_paint(cr);
 	/*
-	 * Render the foreground lines on top of the background.
+	 * Blend the exposed part of the content area of the foreground on top.
+	 * The alpha channel of the foreground keeps the line colors correct
+	 * even if on top of grid lines.
 	 */
-	if (G_UNLIKELY(!priv->have_rgba)) {
-		/*
-		 * Fallback path for systems which do not support RGBA colormaps.
-		 * This is inherently buggy since X11 XOR command will cause content
-		 * overlapping the grid lines to be incorrect.  It's not really all
-		 * that bad though, it just has an effect similar to flicker.
-		 */
-		gdk_gc_set_clip_rectangle(priv->fg_gc, &clip);
-		/*
-		 * Blit the drawable.
-		 */
-		if (G_UNLIKELY(priv->fg_dirty)) {
-			gdk_draw_drawable(dst, priv->fg_gc, GDK_DRAWABLE(info->fg_pixmap),
-			                  priv->content_rect.x,
-			                  priv->content_rect.y,
-			                  priv->content_rect.x,
-			                  priv->content_rect.y,
-			                  priv->content_rect.width,
-			                  priv->content_rect.height);
-		} else {
-			gdk_draw_drawable(dst, priv->fg_gc, GDK_DRAWABLE(info->fg_pixmap),
-			                  priv->content_rect.x,
-			                  priv->content_rect.y,
-			                  priv->content_rect.x - (priv->fps_each * priv->fps_off),
-			                  priv->content_rect.y,
-			                  priv->content_rect.width + priv->x_each,
-			                  priv->content_rect.height);
-		}
-		gdk_gc_set_clip_rectangle(priv->fg_gc, NULL);
-	} else {
-		/*
-		 * Handle the case where we have RGBA colormaps on the system.  This allows
-		 * us to draw with the alpha channel so that the line colors come up correct
-		 * even if on top of grid lines.
-		 */
-		gdk_cairo_reset_clip(cr, expose->window);
-		gdk_cairo_rectangle(cr, &clip);
-		cairo_clip(cr);
-		/*
-		 * Blit the drawable.
-		 */
-		if (G_UNLIKELY(priv->fg_dirty)) {
-			gdk_cairo_set_source_pixmap(cr, info->fg_pixmap, 0, 0);
-		} else {
-			gdk_cairo_set_source_pixmap(cr, info->fg_pixmap,
-			                            -(gint)(priv->fps_each * priv->fps_off),
-			                            0);
-		}
-		cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-		cairo_paint(cr);
-	}
-	priv->fps_off++;
+	gdk_cairo_rectangle(cr, &area);
+	cairo_clip(cr);
+	cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+	cairo_set_source_surface(cr, cairo_get_target(info->fg_cairo), -offset, 0);
+	cairo_paint(cr);
+	cairo_destroy(cr);
 	/*
-	 * Reset the clip region.
+	 * Upload the composited exposure area.
 	 */
-	cairo_destroy(cr);
+	if (G_UNLIKELY(!priv->have_rgba)) {
+		cr = gdk_cairo_create(dst);
+		gdk_cairo_region(cr, expose->region);
+		cairo_set_source_surface(cr, priv->compose, 0, 0);
+		cairo_fill(cr);
+		cairo_destroy(cr);
+	}
+	priv->frame_acc += g_get_monotonic_time() - begin;
 	return FALSE;
 }
 
@@ -1910,7 +3226,7 @@ uber_graph_expose_event (GtkWidget      *widget, /* IN */
  * @widget: A GtkWidget.
  *
  * Callback upon the changing of the active GtkStyle of @widget.  The styling
- * for the various pixmaps are updated.
+ * for the various pixmaps are updated and the text cache is cleared.
  *
  * Returns: None.
  * Side effects: None.
@@ -1926,6 +3242,12 @@ uber_graph_style_set (GtkWidget *widget,     /* IN */
 	ENTRY;
 	priv = UBER_GRAPH(widget)->priv;
 	BASE_CLASS->style_set(widget, old_style);
+	/*
+	 * Cached tick labels were rendered with the previous font settings.
+	 */
+	if (old_style) {
+		uber_text_cache_clear();
+	}
 	if (!gtk_widget_get_window(widget)) {
 		return;
 	}
@@ -1955,11 +3277,18 @@ uber_graph_add_line (UberGraph *graph) /* IN */
 	priv = graph->priv;
 	line.buffer = uber_buffer_new();
 	line.scaled = uber_buffer_new();
+	line.stack = uber_buffer_new();
 	uber_buffer_set_size(line.buffer, priv->stride);
 	uber_buffer_set_size(line.scaled, priv->stride);
+	uber_buffer_set_size(line.stack, priv->stride);
 	gdk_color_parse(priv->colors[priv->color], &line.color);
+	uber_graph_push_bin_reset(&line.push[0]);
+	uber_graph_push_bin_reset(&line.push[1]);
+	line.push_last = -INFINITY;
 	priv->color = (priv->color + 1) % priv->colors_len;
 	g_array_append_val(priv->lines, line);
+	priv->values = g_renew(gdouble, priv->values, priv->lines->len);
+	priv->stack_values = g_renew(gdouble, priv->stack_values, priv->lines->len);
 	RETURN(priv->lines->len);
 }
 
@@ -2038,8 +3367,43 @@ uber_graph_realize (GtkWidget *widget) /* IN */
 	priv = UBER_GRAPH(widget)->priv;
 	dst = GDK_DRAWABLE(gtk_widget_get_window(widget));
 	priv->bg_gc = gdk_gc_new(dst);
-	priv->fg_gc = gdk_gc_new(dst);
-	gdk_gc_set_function(priv->fg_gc, GDK_XOR);
+	EXIT;
+}
+
+/**
+ * uber_graph_viewable_changed:
+ * @widget: A #UberGraph.
+ * @viewable: If the graph can now be seen.
+ * @user_data: Unused.
+ *
+ * #UberViewableFunc called when the graph becomes viewable or stops being
+ * viewable.  If the graph just became viewable, a single full render is
+ * performed to catch up with the data that arrived while it was hidden.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_viewable_changed (GtkWidget *widget,    /* IN */
+                             gboolean   viewable,  /* IN */
+                             gpointer   user_data) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(widget));
+
+	ENTRY;
+	priv = UBER_GRAPH(widget)->priv;
+	priv->viewable = viewable;
+	if (!viewable) {
+		EXIT;
+	}
+	if (priv->scale_dirty) {
+		uber_graph_scale_changed(UBER_GRAPH(widget));
+	} else {
+		priv->fg_dirty = TRUE;
+		gtk_widget_queue_draw(widget);
+	}
 	EXIT;
 }
 
@@ -2110,9 +3474,11 @@ uber_scale_linear (UberGraph       *graph,  /* IN */
 {
 	#define A (values->range)
 	#define B (pixels->range)
-	#define C (*value)
-	if (*value != 0.) {
+	#define C (*value - values->begin)
+	if (C != 0.) {
 		*value = C * B / A;
+	} else {
+		*value = 0.;
 	}
 	#undef A
 	#undef B
@@ -2120,6 +3486,150 @@ uber_scale_linear (UberGraph       *graph,  /* IN */
 	return TRUE;
 }
 
+/**
+ * uber_autoscale_nice_num:
+ * @x: A positive value.
+ * @round: If the value should be rounded rather than raised.
+ *
+ * Finds a "nice" number (1, 2 or 5 x 10^n) approximately equal to @x.  If
+ * @round is %FALSE, the nice number is never smaller than @x.
+ *
+ * Returns: The nice number.
+ * Side effects: None.
+ */
+static gdouble
+uber_autoscale_nice_num (gdouble  x,     /* IN */
+                         gboolean round) /* IN */
+{
+	gdouble expv;
+	gdouble f;
+	gdouble nf;
+
+	if (x <= 0.) {
+		return 0.;
+	}
+	expv = floor(log10(x));
+	f = x / pow(10., expv);
+	if (round) {
+		nf = (f < 1.5) ? 1. : (f < 3.) ? 2. : (f < 7.) ? 5. : 10.;
+	} else {
+		nf = (f <= 1.) ? 1. : (f <= 2.) ? 2. : (f <= 5.) ? 5. : 10.;
+	}
+	return nf * pow(10., expv);
+}
+
+/**
+ * uber_autoscale_nice:
+ * @graph: An #UberGraph.
+ * @policy: An #UberAutoscalePolicy.
+ * @values: The range of raw values that must be visible.
+ * @current: The current y-axis range.
+ * @range: A location for the new range.
+ *
+ * The default #UberAutoscale function.  Each end of the range is handled
+ * the same way: it grows once the data crosses @policy's grow threshold and
+ * shrinks once the padded data fits within its shrink threshold.  New
+ * bounds get @policy's headroom and are optionally snapped to nice numbers
+ * so that small changes in the data do not move the range.
+ *
+ * Returns: %TRUE if @range differs from @current; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_autoscale_nice (UberGraph                 *graph,   /* IN */
+                     const UberAutoscalePolicy *policy,  /* IN */
+                     const UberRange           *values,  /* IN */
+                     const UberRange           *current, /* IN */
+                     UberRange                 *range)   /* OUT */
+{
+	gdouble lo;
+	gdouble hi;
+	gdouble span;
+	gdouble step;
+	gdouble t_lo;
+	gdouble t_hi;
+
+	g_return_val_if_fail(policy != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(current != NULL, FALSE);
+	g_return_val_if_fail(range != NULL, FALSE);
+
+	*range = *current;
+	lo = values->begin;
+	hi = values->end;
+	if (isnan(lo) || isinf(lo) || isnan(hi) || isinf(hi) || (lo > hi)) {
+		return FALSE;
+	}
+	if (policy->include_zero) {
+		lo = MIN(lo, 0.);
+		hi = MAX(hi, 0.);
+	}
+	span = hi - lo;
+	if (span <= 0.) {
+		span = MAX(ABS(hi), 1.);
+	}
+	/*
+	 * Calculate the target range with headroom.  A bound pinned to zero
+	 * does not get any headroom.
+	 */
+	t_lo = (policy->include_zero && lo == 0.) ? 0. : lo - (policy->headroom * span);
+	t_hi = (policy->include_zero && hi == 0.) ? 0. : hi + (policy->headroom * span);
+	if (policy->nice_numbers) {
+		step = uber_autoscale_nice_num(
+			uber_autoscale_nice_num(t_hi - t_lo, FALSE) / 4., TRUE);
+		if (step > 0.) {
+			t_lo = floor(t_lo / step) * step;
+			t_hi = ceil(t_hi / step) * step;
+		}
+	}
+	if (t_hi <= t_lo) {
+		t_hi = t_lo + 1.;
+	}
+	/*
+	 * Grow or shrink the upper bound.
+	 */
+	if (hi >= current->begin + (policy->grow_threshold * current->range)) {
+		range->end = t_hi;
+	} else if (t_hi < current->begin + (policy->shrink_threshold * current->range)) {
+		range->end = t_hi;
+	}
+	/*
+	 * Grow or shrink the lower bound.
+	 */
+	if (lo < current->end - (policy->grow_threshold * current->range)) {
+		range->begin = t_lo;
+	} else if (t_lo > current->end - (policy->shrink_threshold * current->range)) {
+		range->begin = t_lo;
+	}
+	range->range = range->end - range->begin;
+	return ((range->begin != current->begin) || (range->end != current->end));
+}
+
+/**
+ * uber_graph_dispose:
+ * @object: A #UberGraph.
+ *
+ * Unregisters the widget from the frame clock so that no frame runs while
+ * it is being destroyed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_dispose (GObject *object) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	ENTRY;
+	priv = UBER_GRAPH(object)->priv;
+	if (priv->fps_handler) {
+		uber_frame_clock_remove(priv->fps_handler);
+		priv->fps_handler = 0;
+	}
+	G_OBJECT_CLASS(uber_graph_parent_class)->dispose(object);
+	EXIT;
+}
+
 /**
  * uber_graph_finalize:
  * @object: A #UberGraph.
@@ -2141,15 +3651,13 @@ uber_graph_finalize (GObject *object) /* IN */
 	priv = UBER_GRAPH(object)->priv;
 	uber_graph_destroy_graph_info(UBER_GRAPH(object), &priv->info[0]);
 	uber_graph_destroy_graph_info(UBER_GRAPH(object), &priv->info[1]);
-	if (priv->fg_gc) {
-		g_object_unref(priv->fg_gc);
+	if (priv->compose) {
+		cairo_surface_destroy(priv->compose);
 	}
 	if (priv->bg_gc) {
 		g_object_unref(priv->bg_gc);
 	}
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-	}
+	pango_font_description_free(priv->tick_font);
 	if (priv->value_notify) {
 		priv->value_notify(priv->value_user_data);
 	}
@@ -2157,8 +3665,12 @@ uber_graph_finalize (GObject *object) /* IN */
 		line = &g_array_index(priv->lines, LineInfo, i);
 		uber_buffer_unref(line->buffer);
 		uber_buffer_unref(line->scaled);
+		uber_buffer_unref(line->stack);
 	}
+	uber_graph_drain_pushed(UBER_GRAPH(object));
 	g_array_unref(priv->lines);
+	g_free(priv->values);
+	g_free(priv->stack_values);
 	G_OBJECT_CLASS(uber_graph_parent_class)->finalize(object);
 	EXIT;
 }
@@ -2190,6 +3702,9 @@ uber_graph_get_property (GObject    *object,  /* IN */
 		g_value_set_double(value,
 		                   uber_graph_get_line_width(UBER_GRAPH(object)));
 		break;
+	case PROP_QUALITY_TIER:
+		g_value_set_int(value, uber_graph_get_quality(UBER_GRAPH(object)));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 	}
@@ -2210,11 +3725,19 @@ uber_graph_class_init (UberGraphClass *klass) /* IN */
 	GObjectClass *object_class;
 	GtkWidgetClass *widget_class;
 
+	PushNode *block;
+
 	ENTRY;
+	/*
+	 * Preallocate PushNodes so that pushing does not allocate.
+	 */
+	block = uber_graph_alloc_block();
+	uber_graph_stack_push(&push_free, block, &block[PUSH_BLOCK - 1]);
 	/*
 	 * Prepare GObjectClass.
 	 */
 	object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = uber_graph_dispose;
 	object_class->finalize = uber_graph_finalize;
 	object_class->set_property = uber_graph_set_property;
 	object_class->get_property = uber_graph_get_property;
@@ -2243,6 +3766,21 @@ uber_graph_class_init (UberGraphClass *klass) /* IN */
 	                                                    G_MAXDOUBLE,
 	                                                    1.0,
 	                                                    G_PARAM_READWRITE));
+	/**
+	 * UberGraph:quality-tier:
+	 *
+	 * The "quality-tier" property is the #UberGraphQuality the graph is
+	 * currently rendered with, as chosen by the frame budget governor.
+	 */
+	g_object_class_install_property(object_class,
+	                                PROP_QUALITY_TIER,
+	                                g_param_spec_int("quality-tier",
+	                                                 "quality-tier",
+	                                                 "QualityTier",
+	                                                 UBER_GRAPH_QUALITY_FULL,
+	                                                 UBER_GRAPH_QUALITY_DECIMATE,
+	                                                 UBER_GRAPH_QUALITY_FULL,
+	                                                 G_PARAM_READABLE));
 	EXIT;
 }
 
@@ -2273,9 +3811,20 @@ uber_graph_init (UberGraph *graph) /* IN */
 	priv->yrange.end = 1.;
 	priv->yrange.range = 1.;
 	priv->format = UBER_GRAPH_DIRECT;
+	priv->autoscale = uber_autoscale_nice;
+	priv->autoscale_policy.headroom = SCALE_FACTOR - 1.;
+	priv->autoscale_policy.grow_threshold = 1.;
+	priv->autoscale_policy.shrink_threshold = .5;
+	priv->autoscale_policy.min_dwell = 15000;
+	priv->autoscale_policy.nice_numbers = TRUE;
+	priv->autoscale_policy.include_zero = TRUE;
 	priv->lines = g_array_sized_new(FALSE, TRUE, sizeof(LineInfo), 2);
 	priv->colors = g_strdupv((gchar **)default_colors);
 	priv->colors_len = G_N_ELEMENTS(default_colors);
+	priv->tick_font = uber_graph_prepare_font(LAYOUT_TICK);
+	priv->frame_budget = FRAME_BUDGET;
+	uber_frame_clock_watch_viewable(GTK_WIDGET(graph),
+	                                uber_graph_viewable_changed, NULL);
 	uber_graph_set_fps(graph, 20);
 	EXIT;
 }
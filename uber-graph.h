@@ -55,6 +55,53 @@ typedef gboolean (*UberScale) (UberGraph       *graph,
                                const UberRange *pixels,
                                gdouble         *value);
 
+/**
+ * UberAutoscalePolicy:
+ * @headroom: Fraction of the data span to leave above and below the data
+ *   when the range is recalculated.
+ * @grow_threshold: Fraction of the current range a value must reach before
+ *   the range grows.  1.0 grows only once a value touches the edge.
+ * @shrink_threshold: The range only shrinks once the new range would fit
+ *   within this fraction of the current range.
+ * @min_dwell: Minimum number of milliseconds the range must stay unchanged
+ *   before it may shrink.
+ * @nice_numbers: Snap the range to multiples of 1, 2 or 5 x 10^n.
+ * @include_zero: Always keep zero within the range.
+ *
+ * #UberAutoscalePolicy contains the tunables used by an #UberAutoscale
+ * function when the y-axis of the graph is set to autoscale.
+ */
+typedef struct
+{
+	gdouble  headroom;
+	gdouble  grow_threshold;
+	gdouble  shrink_threshold;
+	guint    min_dwell;
+	gboolean nice_numbers;
+	gboolean include_zero;
+} UberAutoscalePolicy;
+
+/**
+ * UberAutoscale:
+ * @graph: An #UberGraph.
+ * @policy: The #UberAutoscalePolicy of the graph.
+ * @values: The range of the raw values that must be visible.
+ * @current: The current y-axis range.
+ * @range: A location for the new y-axis range.
+ *
+ * #UberAutoscale calculates the y-axis range required to display @values.
+ * The graph itself enforces @policy's dwell time and only allows the range
+ * to grow while new values are appended.
+ *
+ * Returns: %TRUE if @range differs from @current; otherwise %FALSE.
+ * Side effects: None.
+ */
+typedef gboolean (*UberAutoscale) (UberGraph                 *graph,
+                                   const UberAutoscalePolicy *policy,
+                                   const UberRange           *values,
+                                   const UberRange           *current,
+                                   UberRange                 *range);
+
 /**
  * UberGraphFunc:
  * @graph: A #UberGraph.
@@ -74,6 +121,30 @@ typedef gboolean (*UberGraphFunc) (UberGraph *graph,
                                    gdouble   *value,
                                    gpointer   user_data);
 
+/**
+ * UberGraphValuesFunc:
+ * @graph: A #UberGraph.
+ * @values: An array to fill with the next value of each line.
+ * @n_values: The number of lines, and therefore elements, in @values.
+ * @timestamp: The monotonic time of the sample in microseconds.  It is set
+ *   to the time of the data point and may be overwritten with the earlier
+ *   time the values were actually sampled, up to one data point before.
+ *   The values are drawn at that time.
+ * @user_data: User data supplied to uber_graph_set_values_func().
+ *
+ * Callback to retrieve the next value of every line of the graph in a single
+ * call.  Elements of @values are initialized to -INFINITY, which is left for
+ * lines without a new value.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: Implementation specific.
+ */
+typedef gboolean (*UberGraphValuesFunc) (UberGraph *graph,
+                                         gdouble   *values,
+                                         guint      n_values,
+                                         gint64    *timestamp,
+                                         gpointer   user_data);
+
 /**
  * UberGraphFormat:
  * @UBER_GRAPH_DIRECT: The raw values should be used.
@@ -92,6 +163,62 @@ typedef enum
 	UBER_GRAPH_INTEGRAL,
 } UberGraphFormat;
 
+/**
+ * UberGraphQuality:
+ * @UBER_GRAPH_QUALITY_FULL: Bezier curves with antialiasing.
+ * @UBER_GRAPH_QUALITY_LINEAR: Straight segments instead of curves.
+ * @UBER_GRAPH_QUALITY_NO_ANTIALIAS: Antialiasing is also disabled.
+ * @UBER_GRAPH_QUALITY_LOW_FPS: The frame rate is also halved.
+ * @UBER_GRAPH_QUALITY_DECIMATE: Full redraws also skip every other point.
+ *
+ * #UberGraphQuality is the rendering quality tier of a graph.  Each tier
+ * includes the reductions of the tiers before it.
+ */
+typedef enum
+{
+	UBER_GRAPH_QUALITY_FULL,
+	UBER_GRAPH_QUALITY_LINEAR,
+	UBER_GRAPH_QUALITY_NO_ANTIALIAS,
+	UBER_GRAPH_QUALITY_LOW_FPS,
+	UBER_GRAPH_QUALITY_DECIMATE,
+} UberGraphQuality;
+
+/**
+ * UberGraphLineMode:
+ * @UBER_GRAPH_LINE_BEZIER: Smooth curves between data points.
+ * @UBER_GRAPH_LINE_LINEAR: Straight segments between data points.
+ * @UBER_GRAPH_LINE_STEP: Horizontal and vertical segments only.
+ * @UBER_GRAPH_LINE_AREA: Straight segments with the area below filled.
+ * @UBER_GRAPH_LINE_STACKED: Each line is filled as a band stacked on top
+ *   of the lines before it.
+ *
+ * #UberGraphLineMode describes how the lines of a graph are drawn.
+ */
+typedef enum
+{
+	UBER_GRAPH_LINE_BEZIER,
+	UBER_GRAPH_LINE_LINEAR,
+	UBER_GRAPH_LINE_STEP,
+	UBER_GRAPH_LINE_AREA,
+	UBER_GRAPH_LINE_STACKED,
+} UberGraphLineMode;
+
+/**
+ * UberGraphMerge:
+ * @UBER_GRAPH_MERGE_LAST: Use the value with the newest timestamp.
+ * @UBER_GRAPH_MERGE_MEAN: Use the mean of the pushed values.
+ * @UBER_GRAPH_MERGE_MAX: Use the largest pushed value.
+ *
+ * #UberGraphMerge describes how values pushed with uber_graph_push() are
+ * merged when more than one has a timestamp within the same data point.
+ */
+typedef enum
+{
+	UBER_GRAPH_MERGE_LAST,
+	UBER_GRAPH_MERGE_MEAN,
+	UBER_GRAPH_MERGE_MAX,
+} UberGraphMerge;
+
 struct _UberGraph
 {
 	GtkDrawingArea parent;
@@ -106,20 +233,51 @@ struct _UberGraphClass
 };
 
 guint           uber_graph_add_line       (UberGraph       *graph);
+void            uber_graph_get_autoscale_policy
+                                          (UberGraph       *graph,
+                                           UberAutoscalePolicy *policy);
 UberGraphFormat uber_graph_get_format     (UberGraph       *graph);
+guint           uber_graph_get_generation (UberGraph       *graph);
+UberGraphLineMode uber_graph_get_line_mode(UberGraph       *graph);
+gdouble         uber_graph_get_line_value (UberGraph       *graph,
+                                           guint            line,
+                                           gint             idx);
 gdouble         uber_graph_get_line_width (UberGraph       *graph);
+UberGraphQuality uber_graph_get_quality   (UberGraph       *graph);
 GType           uber_graph_get_type       (void) G_GNUC_CONST;
 gboolean        uber_graph_get_yautoscale (UberGraph       *graph);
+void            uber_graph_get_yrange     (UberGraph       *graph,
+                                           UberRange       *range);
 GtkWidget*      uber_graph_new            (void);
+void            uber_graph_push           (UberGraph       *graph,
+                                           gint             line,
+                                           gint64           timestamp,
+                                           gdouble          value);
+void            uber_graph_pushv          (UberGraph       *graph,
+                                           gint64           timestamp,
+                                           const gdouble   *values,
+                                           guint            n_values);
+void            uber_graph_set_autoscale  (UberGraph       *graph,
+                                           UberAutoscale    autoscale);
+void            uber_graph_set_autoscale_policy
+                                          (UberGraph       *graph,
+                                           const UberAutoscalePolicy *policy);
 void            uber_graph_set_format     (UberGraph       *graph,
                                            UberGraphFormat  format);
 void            uber_graph_set_fps        (UberGraph       *graph,
                                            gint             fps);
+void            uber_graph_set_frame_budget
+                                          (UberGraph       *graph,
+                                           guint            budget);
 void            uber_graph_set_line_width (UberGraph       *graph,
                                            gdouble          line_width);
 void            uber_graph_set_line_color (UberGraph       *graph,
                                            gint             line,
                                            const GdkColor  *color);
+void            uber_graph_set_line_mode  (UberGraph       *graph,
+                                           UberGraphLineMode mode);
+void            uber_graph_set_merge      (UberGraph       *graph,
+                                           UberGraphMerge   merge);
 void            uber_graph_set_scale      (UberGraph       *graph,
                                            UberScale        scale);
 void            uber_graph_set_show_xlabel(UberGraph       *graph,
@@ -130,10 +288,19 @@ void            uber_graph_set_value_func (UberGraph       *graph,
                                            UberGraphFunc    func,
                                            gpointer         user_data,
                                            GDestroyNotify   notify);
+void            uber_graph_set_values_func(UberGraph       *graph,
+                                           UberGraphValuesFunc func,
+                                           gpointer         user_data,
+                                           GDestroyNotify   notify);
 void            uber_graph_set_yautoscale (UberGraph       *graph,
                                            gboolean         yautoscale);
 void            uber_graph_set_yrange     (UberGraph       *graph,
                                            const UberRange *range);
+gboolean        uber_autoscale_nice       (UberGraph       *graph,
+                                           const UberAutoscalePolicy *policy,
+                                           const UberRange *values,
+                                           const UberRange *current,
+                                           UberRange       *range);
 gboolean        uber_scale_linear         (UberGraph       *graph,
                                            const UberRange *values,
                                            const UberRange *pixels,
@@ -21,11 +21,18 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include "g-ring.h"
+#include "uber-frame-clock.h"
 #include "uber-heat-map.h"
 
 #define WIDGET ((GtkWidgetClass *)uber_heat_map_parent_class)
+#define LUT_SIZE        (256)
+#define NORMALIZE_DECAY (0.95)
+#define N_LEVELS        (8) /* Zoom levels, each merging pairs of the one below. */
+#define COLUMN_USEC     (G_USEC_PER_SEC)
+#define N_BUCKETS       (32)
 
 #define DEBUG_RECT(r)                                       \
     g_debug("GdkRectangle(X=%d, Y=%d, Width=%d, Height=%d", \
@@ -48,18 +55,29 @@ G_DEFINE_TYPE(UberHeatMap, uber_heat_map, GTK_TYPE_DRAWING_AREA)
 
 typedef struct
 {
-	GdkPixmap       *bg_pixmap;
-	GdkPixmap       *fg_pixmap;
-	GdkPixmap       *hl_pixmap;
-	cairo_t         *bg_cairo;
-	cairo_t         *fg_cairo;
-	cairo_t         *hl_cairo;
-} FlipTexture;
+	GArray          *values;
+	gdouble          max;
+	gdouble          norm;
+} Column;
 
 struct _UberHeatMapPrivate
 {
-	FlipTexture      textures[2];
-	gboolean         flipped;
+	GdkPixmap       *bg_pixmap;
+	cairo_t         *bg_cairo;
+	GdkPixmap       *strip_pixmap;
+	cairo_t         *strip_cairo;
+	cairo_surface_t *column_surface;
+	gint             strip_slots;
+	gint             strip_head;
+	gint             strip_width;
+	gdouble          strip_block_width;
+	guint            pending;
+	guint32          fg_lut[LUT_SIZE];
+	gboolean         lut_valid;
+	UberHeatMapPalette palette;
+	GdkColor        *gradient;
+	guint            n_gradient;
+	GdkColor         hl_color;
 	gboolean         bg_dirty;
 	gboolean         fg_dirty;
 	gboolean         full_draw;
@@ -70,7 +88,7 @@ struct _UberHeatMapPrivate
 	gdouble          fps_each;
 	gint             fps_to;
 	guint            fps_handler;
-	gint             fps_off;
+	gint64           dp_time; /* Monotonic time of the last column. */
 	gint             stride;
 	gint             col_count;
 	gint             row_count;
@@ -91,9 +109,41 @@ struct _UberHeatMapPrivate
 	UberHeatMapFunc  value_func;
 	gpointer         value_user_data;
 	GDestroyNotify   value_notify;
-	GRing           *ring;
+	UberHeatMapFormatFunc format_func;
+	gpointer         format_user_data;
+	GDestroyNotify   format_notify;
+	GRing           *levels[N_LEVELS];
+	guint            n_appended[N_LEVELS];
+	guint            zoom;
+	guint            zoom_offset;
+	gboolean         dragging;
+	gdouble          drag_begin;
+	gdouble          drag_end;
+	GRing           *view;
+	gint             agg;
+	gint             view_fill;
+	gboolean         refresh;
+	UberHeatMapAggregate aggregate;
+	UberHeatMapScale scale;
+	UberHeatMapNormalize normalize;
+	gdouble         *edges;
+	guint            n_edges;
+	gdouble          bucket_scale;
+	gdouble          bucket_offset;
+	guint            bucket_count;
+	guint            n_buckets;
+	gdouble         *counts;
+	gdouble          global_max;
+	gdouble          max_value;
+	GArray          *spare;
+	guint           *row_groups;
+	guint            n_row_groups;
+	gboolean         viewable;
 };
 
+static void uber_heat_map_update_aggregation (UberHeatMap *map);
+static void uber_heat_map_destroy_column     (gpointer     data);
+
 /**
  * uber_heat_map_new:
  *
@@ -109,33 +159,18 @@ uber_heat_map_new (void)
 }
 
 /**
- * uber_heat_map_clear_cairo:
+ * uber_heat_map_get_viewable:
  * @map: A #UberHeatMap.
- * @cr: A #cairo_t.
- * @width: The width of the context.
- * @height: The height of the context.
  *
- * Clears the contents of a cairo context.
+ * Checks if any part of the heat map can currently be seen by the user.
  *
- * Returns: None.
+ * Returns: %TRUE if the heat map is viewable; otherwise %FALSE.
  * Side effects: None.
  */
-static void
-uber_heat_map_clear_cairo (UberHeatMap *map,    /* IN */
-                           cairo_t     *cr,     /* IN */
-                           gint         width,  /* IN */
-                           gint         height) /* IN */
+static inline gboolean
+uber_heat_map_get_viewable (UberHeatMap *map) /* IN */
 {
-	UberHeatMapPrivate *priv;
-
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-
-	priv = map->priv;
-	cairo_save(cr);
-	cairo_rectangle(cr, 0, 0, width, height);
-	cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-	cairo_fill(cr);
-	cairo_restore(cr);
+	return map->priv->viewable;
 }
 
 /**
@@ -187,108 +222,189 @@ uber_heat_map_set_value_func (UberHeatMap     *map,
 }
 
 /**
- * uber_heat_map_init_drawables:
+ * uber_heat_map_set_format_func:
+ * @map: A #UberHeatMap.
+ * @func: A #UberHeatMapFormatFunc or %NULL.
+ * @user_data: User data for @func.
+ * @notify: A #GDestroyNotify for @user_data or %NULL.
+ *
+ * Sets the function used to describe the hovered cell in the tooltip.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_format_func (UberHeatMap           *map,       /* IN */
+                               UberHeatMapFormatFunc  func,      /* IN */
+                               gpointer               user_data, /* IN */
+                               GDestroyNotify         notify)    /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (priv->format_notify) {
+		priv->format_notify(priv->format_user_data);
+	}
+	priv->format_func = func;
+	priv->format_user_data = user_data;
+	priv->format_notify = notify;
+}
+
+/**
+ * uber_heat_map_init_texture:
  * @map: A #UberHeatMap.
  *
- * Initializes server-side pixmaps.
+ * Initializes the server-side background pixmap.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_init_texture (UberHeatMap *map,     /* IN */
-                            FlipTexture *texture) /* IN */
+uber_heat_map_init_texture (UberHeatMap *map) /* IN */
 {
 	UberHeatMapPrivate *priv;
 	GdkDrawable *drawable;
 	GtkAllocation alloc;
-	GdkColormap *colormap;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(texture != NULL);
 
 	priv = map->priv;
 	drawable = gtk_widget_get_window(GTK_WIDGET(map));
 	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
-	colormap = gdk_screen_get_rgba_colormap(gdk_drawable_get_screen(drawable));
-	priv->have_rgba = (colormap != NULL);
-	/*
-	 * Create server-side pixmaps.
-	 */
-	texture->bg_pixmap = gdk_pixmap_new(drawable, alloc.width, alloc.height, -1);
-	/*
-	 * If we have RGBA colormaps, we can draw cleanly with cairo.  Otherwise, we
-	 * will need to do more calculation by hand and XOR our content onto the
-	 * surface.
-	 */
-	if (priv->have_rgba) {
-		texture->fg_pixmap = gdk_pixmap_new(NULL, alloc.width, alloc.height, 32);
-		texture->hl_pixmap = gdk_pixmap_new(NULL, alloc.width, alloc.height, 32);
-		gdk_drawable_set_colormap(texture->fg_pixmap, colormap);
-		gdk_drawable_set_colormap(texture->hl_pixmap, colormap);
-	} else {
-		texture->fg_pixmap = gdk_pixmap_new(drawable, alloc.width, alloc.height, -1);
-		texture->hl_pixmap = gdk_pixmap_new(drawable, alloc.width, alloc.height, -1);
-	}
-	/*
-	 * Setup cairo.
-	 */
-	texture->bg_cairo = gdk_cairo_create(texture->bg_pixmap);
-	texture->fg_cairo = gdk_cairo_create(texture->fg_pixmap);
-	texture->hl_cairo = gdk_cairo_create(texture->hl_pixmap);
-	/*
-	 * Clear the content area.
-	 */
-	uber_heat_map_clear_cairo(map, texture->fg_cairo, alloc.width, alloc.height);
-	uber_heat_map_clear_cairo(map, texture->hl_cairo, alloc.width, alloc.height);
+	priv->have_rgba = !!gdk_screen_get_rgba_colormap(gdk_drawable_get_screen(drawable));
+	priv->bg_pixmap = gdk_pixmap_new(drawable, alloc.width, alloc.height, -1);
+	priv->bg_cairo = gdk_cairo_create(priv->bg_pixmap);
 }
 
 /**
  * uber_heat_map_destroy_texture:
  * @map: A #UberHeatMap.
- * @texture: A FlipTexture.
  *
- * Destroys the server-side textures.
+ * Destroys the server-side background pixmap.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_destroy_texture (UberHeatMap *map,     /* IN */
-                               FlipTexture *texture) /* IN */
+uber_heat_map_destroy_texture (UberHeatMap *map) /* IN */
 {
 	UberHeatMapPrivate *priv;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(texture != NULL);
 
 	priv = map->priv;
+	if (priv->bg_pixmap) {
+		g_object_unref(priv->bg_pixmap);
+		priv->bg_pixmap = NULL;
+	}
+	if (priv->bg_cairo) {
+		cairo_destroy(priv->bg_cairo);
+		priv->bg_cairo = NULL;
+	}
+}
 
-	#define UNSET_PIXMAP(p)          \
-	    G_STMT_START {               \
-	        if (p) {                 \
-	            g_object_unref((p)); \
-	            p = NULL;            \
-	        }                        \
-	    } G_STMT_END
+/**
+ * uber_heat_map_init_lut:
+ * @lut: An array of %LUT_SIZE pixels.
+ * @stops: The colors of the gradient, from lowest to highest intensity.
+ * @n_stops: The number of elements in @stops.
+ *
+ * Fills @lut with opaque pixels interpolated along the gradient in @stops
+ * for each level of intensity.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_init_lut (guint32        *lut,     /* OUT */
+                        const GdkColor *stops,   /* IN */
+                        guint           n_stops) /* IN */
+{
+	const GdkColor *a;
+	const GdkColor *b;
+	gdouble t;
+	gdouble f;
+	guint k;
+	guint i;
+
+	for (i = 0; i < LUT_SIZE; i++) {
+		t = (gdouble)i / (LUT_SIZE - 1) * (n_stops - 1);
+		k = MIN((guint)t, n_stops - 1);
+		f = t - k;
+		a = &stops[k];
+		b = &stops[MIN(k + 1, n_stops - 1)];
+		lut[i] = 0xFF000000
+		       | ((guint32)((a->red + (b->red - a->red) * f) / 257. + .5) << 16)
+		       | ((guint32)((a->green + (b->green - a->green) * f) / 257. + .5) << 8)
+		       | ((guint32)((a->blue + (b->blue - a->blue) * f) / 257. + .5));
+	}
+}
 
-	#define UNSET_CAIRO(c)           \
-	    G_STMT_START {               \
-	        if ((c)) {               \
-	            cairo_destroy((c));  \
-	            (c) = NULL;          \
-	        }                        \
-	    } G_STMT_END
+/**
+ * uber_heat_map_update_lut:
+ * @map: A #UberHeatMap.
+ *
+ * Builds the color lookup table for the current palette.  The default
+ * palette runs from the content background to the cell color, which looks
+ * the same as drawing the cell color with the intensity as alpha.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_lut (UberHeatMap *map) /* IN */
+{
+	static const gchar *viridis[] = {
+		"#440154", "#472c7a", "#3b518b", "#2c718e", "#21908d",
+		"#27ad81", "#5cc863", "#aadc32", "#fde725",
+	};
+	static const gchar *magma[] = {
+		"#000004", "#1c1044", "#4f127b", "#812581", "#b5367a",
+		"#e55064", "#fb8761", "#fec287", "#fcfdbf",
+	};
+	static const gchar *grayscale[] = { "#000000", "#ffffff" };
+	UberHeatMapPrivate *priv;
+	const gchar **specs = NULL;
+	GdkColor stops[G_N_ELEMENTS(viridis)];
+	guint n_specs = 0;
+	guint i;
 
-	UNSET_PIXMAP(texture->bg_pixmap);
-	UNSET_PIXMAP(texture->fg_pixmap);
-	UNSET_PIXMAP(texture->hl_pixmap);
-	UNSET_CAIRO(texture->bg_cairo);
-	UNSET_CAIRO(texture->fg_cairo);
-	UNSET_CAIRO(texture->hl_cairo);
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
 
-	#undef UNSET_PIXMAP
-	#undef UNSET_CAIRO
+	priv = map->priv;
+	switch (priv->palette) {
+	case UBER_HEAT_MAP_PALETTE_DEFAULT:
+		stops[0] = gtk_widget_get_style(GTK_WIDGET(map))->light[GTK_STATE_NORMAL];
+		gdk_color_parse("#204a87", &stops[1]);
+		uber_heat_map_init_lut(priv->fg_lut, stops, 2);
+		break;
+	case UBER_HEAT_MAP_PALETTE_VIRIDIS:
+		specs = viridis;
+		n_specs = G_N_ELEMENTS(viridis);
+		break;
+	case UBER_HEAT_MAP_PALETTE_MAGMA:
+		specs = magma;
+		n_specs = G_N_ELEMENTS(magma);
+		break;
+	case UBER_HEAT_MAP_PALETTE_GRAYSCALE:
+		specs = grayscale;
+		n_specs = G_N_ELEMENTS(grayscale);
+		break;
+	case UBER_HEAT_MAP_PALETTE_CUSTOM:
+		uber_heat_map_init_lut(priv->fg_lut, priv->gradient, priv->n_gradient);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	if (specs) {
+		for (i = 0; i < n_specs; i++) {
+			gdk_color_parse(specs[i], &stops[i]);
+		}
+		uber_heat_map_init_lut(priv->fg_lut, stops, n_specs);
+	}
+	priv->lut_valid = TRUE;
 }
 
 /**
@@ -393,585 +509,2519 @@ uber_heat_map_calculate_rects (UberHeatMap *map) /* IN */
 }
 
 /**
- * uber_heat_map_render_fg:
- * @map: A #UberHeatMap.
- * @full_draw: Redraw the entire contents.
+ * uber_heat_map_fill_span:
+ * @data: The pixels of an ARGB32 image surface.
+ * @stride: The stride of @data.
+ * @x0: The first column.
+ * @x1: The column after the last.
+ * @y0: The first row.
+ * @y1: The row after the last.
+ * @pixel: The pixel to store.
  *
- * Renders the foreground.  If @full_draw is %TRUE, then we will draw the
- * entire contents rather than shift the current data and draw just the new
- * content.
+ * Fills a block of pixels.  The first row is filled and then copied into
+ * the remaining rows.
  *
  * Returns: None.
  * Side effects: None.
  */
-static void
-uber_heat_map_render_fg (UberHeatMap *map,       /* IN */
-                         gboolean     full_draw) /* IN */
+static inline void
+uber_heat_map_fill_span (guint8  *data,   /* IN */
+                         gint     stride, /* IN */
+                         gint     x0,     /* IN */
+                         gint     x1,     /* IN */
+                         gint     y0,     /* IN */
+                         gint     y1,     /* IN */
+                         guint32  pixel)  /* IN */
 {
-	UberHeatMapPrivate *priv;
-	FlipTexture *src;
-	FlipTexture *dst;
-	GtkAllocation alloc;
-	GdkRectangle area;
-	gint xcount;
-	gint ycount;
-	gint ix;
-	gint iy;
-	gdouble alpha;
-	gdouble block_width;
-	gdouble block_height;
-	GdkColor color;
-	GdkColor hl_color;
-
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-
-	priv = map->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
-	gdk_color_parse("#204a87", &color);
-	gdk_color_parse("#fce94f", &hl_color);
+	guint32 *row;
+	gint x;
+	gint y;
 
-	src = &priv->textures[priv->flipped];
-	dst = &priv->textures[!priv->flipped];
-	priv->flipped = !priv->flipped;
-
-	cairo_save(dst->fg_cairo);
-	cairo_save(dst->hl_cairo);
-
-	/*
-	 * Calculate content area (without borders).
-	 */
-	area = priv->content_rect;
-	area.x += 1;
-	area.y += 1;
-	area.width -= 2;
-	area.height -= 2;
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+	row = (guint32 *)(data + (y0 * stride)) + x0;
+	for (x = 0; x < x1 - x0; x++) {
+		row[x] = pixel;
+	}
+	for (y = y0 + 1; y < y1; y++) {
+		memcpy((guint32 *)(data + (y * stride)) + x0, row,
+		       (x1 - x0) * sizeof(guint32));
+	}
+}
 
-	/*
-	 * Setup context settings.
-	 */
-	cairo_set_antialias(dst->fg_cairo, CAIRO_ANTIALIAS_NONE);
-	cairo_set_antialias(dst->hl_cairo, CAIRO_ANTIALIAS_NONE);
+/**
+ * uber_heat_map_get_counts:
+ * @map: A #UberHeatMap.
+ * @xcount: A location for the number of columns.
+ * @ycount: A location for the number of rows.
+ *
+ * Calculates the number of blocks along each axis.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_counts (UberHeatMap *map,    /* IN */
+                          gint        *xcount, /* OUT */
+                          gint        *ycount) /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
 
 	/*
 	 * Calculate the number of x-axis blocks.
 	 */
 	if (priv->width_is_count) {
-		xcount = priv->width_block_size;
+		*xcount = priv->width_block_size;
 	} else {
-		xcount = priv->content_rect.width / (gdouble)priv->col_count;
+		*xcount = priv->content_rect.width / (gdouble)priv->col_count;
 	}
-	block_width = priv->cur_block_width;
-
 	/*
 	 * Calculate the number of y-axis blocks.
 	 */
 	if (priv->height_is_count) {
-		ycount = priv->height_block_size;
+		*ycount = priv->height_block_size;
 	} else {
-		ycount = priv->content_rect.height / (gdouble)priv->row_count;
-	}
-	block_height = priv->cur_block_height;
-
-	/*
-	 * Clear the destination foreground.
-	 */
-	cairo_save(dst->fg_cairo);
-	cairo_rectangle(dst->fg_cairo, 0, 0, alloc.width, alloc.height);
-	cairo_set_source_rgb(dst->fg_cairo, 0, 0, 0);
-	cairo_set_operator(dst->fg_cairo, CAIRO_OPERATOR_CLEAR);
-	cairo_fill(dst->fg_cairo);
-	cairo_restore(dst->fg_cairo);
-	/*
-	 * Clear the destination highlight.
-	 */
-	cairo_save(dst->hl_cairo);
-	cairo_rectangle(dst->hl_cairo, 0, 0, alloc.width, alloc.height);
-	cairo_set_source_rgb(dst->hl_cairo, 0, 0, 0);
-	cairo_set_operator(dst->hl_cairo, CAIRO_OPERATOR_CLEAR);
-	cairo_fill(dst->hl_cairo);
-	cairo_restore(dst->hl_cairo);
-
-	/*
-	 * Set clip region.
-	 */
-	//gdk_cairo_rectangle(dst->fg_cairo, &area);
-	//cairo_clip(dst->fg_cairo);
-
-	/*
-	 * Draw data shifted if necessary.
-	 */
-	if (!full_draw) {
-		cairo_rectangle(dst->fg_cairo, 0, 0, alloc.width, alloc.height);
-		gdk_cairo_set_source_pixmap(dst->fg_cairo, src->fg_pixmap, -block_width, 0);
-		cairo_paint(dst->fg_cairo);
-	}
-	/*
-	 * Render the contents for the various blocks.
-	 */
-	for (ix = 0; ix < xcount; ix++) {
-		GArray *col = g_ring_get_index(priv->ring, GArray *, ix);
-
-		/*
-		 * Draw the column content.
-		 */
-		for (iy = 0; iy < ycount; iy++) {
-			if (col && iy < col->len)
-				alpha = g_array_index(col, gint, iy);
-			else
-				alpha = 0;
-			/*
-			 * Set content rectangle path.
-			 */
-			cairo_rectangle(dst->fg_cairo,
-			                GDK_RECTANGLE_RIGHT(area) - (ix * block_width) - block_width,
-			                GDK_RECTANGLE_BOTTOM(area) - (iy * block_height) - block_height,
-			                block_width,
-			                block_height);
-			cairo_rectangle(dst->hl_cairo,
-			                GDK_RECTANGLE_RIGHT(area) - (ix * block_width) - block_width,
-			                GDK_RECTANGLE_BOTTOM(area) - (iy * block_height) - block_height,
-			                block_width,
-			                block_height);
-			/*
-			 * Set the foreground and highlight color.
-			 */
-			cairo_set_source_rgba(dst->fg_cairo,
-			                      color.red / 65535.,
-			                      color.green / 65535.,
-			                      color.blue / 65535.,
-			                      alpha);
-			cairo_set_source_rgba(dst->hl_cairo,
-			                      hl_color.red / 65535.,
-			                      hl_color.green / 65535.,
-			                      hl_color.blue / 65535.,
-			                      alpha);
-			/*
-			 * Render the rectangle.
-			 */
-			cairo_fill(dst->fg_cairo);
-			cairo_fill(dst->hl_cairo);
-		}
-		if (!full_draw) {
-			//g_debug("Most recent column drawn.  No more columns to draw.");
-			break;
-		}
+		*ycount = priv->content_rect.height / (gdouble)priv->row_count;
 	}
-	/*
-	 * Cleanup after resources.
-	 */
-	cairo_restore(dst->fg_cairo);
-	cairo_restore(dst->hl_cairo);
 }
 
 /**
- * uber_heat_map_render_x_axis:
+ * uber_heat_map_update_buckets:
  * @map: A #UberHeatMap.
  *
- * XXX
+ * Recalculates the bucket layout after the y range, scale or the number of
+ * buckets changed.  A bucket index is then a single multiply-add of the
+ * value, or its logarithm, clamped to the valid buckets.  Observations
+ * pushed for the current column no longer fit the new layout and are
+ * dropped.  The layout does not depend on the size of the widget; buckets
+ * are mapped to rows when rendering.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_render_x_axis (UberHeatMap *map) /* IN */
+uber_heat_map_update_buckets (UberHeatMap *map) /* IN */
 {
 	UberHeatMapPrivate *priv;
+	gdouble begin;
+	gdouble end;
+	gdouble base;
+	guint n_buckets;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(map));
 
 	priv = map->priv;
-#if 0
-	cairo_save(priv->bg_cairo);
-	gdk_cairo_rectangle(priv->bg_cairo, &priv->x_tick_rect);
-	cairo_set_source_rgba(priv->bg_cairo, 0, 0, 0, .3);
-	cairo_fill(priv->bg_cairo);
-	cairo_restore(priv->bg_cairo);
-#endif
+	if (priv->scale == UBER_HEAT_MAP_SCALE_CUSTOM) {
+		n_buckets = MAX(1, priv->n_edges) - 1;
+	} else {
+		n_buckets = priv->bucket_count;
+	}
+	if (n_buckets != priv->n_buckets) {
+		priv->counts = g_renew(gdouble, priv->counts, n_buckets);
+		priv->n_buckets = n_buckets;
+	}
+	if (n_buckets) {
+		memset(priv->counts, 0, sizeof(gdouble) * n_buckets);
+	}
+	begin = priv->y_range.begin;
+	end = priv->y_range.end;
+	switch (priv->scale) {
+	case UBER_HEAT_MAP_SCALE_LINEAR:
+		break;
+	case UBER_HEAT_MAP_SCALE_LOG2:
+	case UBER_HEAT_MAP_SCALE_LOG10:
+		/*
+		 * Widen the range to powers of the base so that the bucket edges
+		 * line up with octaves or decades.  Buckets are then computed on
+		 * log2 of the value, whatever the base.
+		 */
+		base = (priv->scale == UBER_HEAT_MAP_SCALE_LOG2) ? 2. : 10.;
+		begin = (begin > 0.) ? begin : 1.;
+		end = MAX(end, begin * base);
+		begin = log2(pow(base, floor(log(begin) / log(base))));
+		end = log2(pow(base, ceil(log(end) / log(base))));
+		break;
+	case UBER_HEAT_MAP_SCALE_CUSTOM:
+		return;
+	default:
+		g_assert_not_reached();
+	}
+	if (end > begin) {
+		priv->bucket_scale = n_buckets / (end - begin);
+		priv->bucket_offset = -begin * priv->bucket_scale;
+	} else {
+		priv->bucket_scale = 0.;
+		priv->bucket_offset = 0.;
+	}
 }
 
 /**
- * uber_heat_map_render_y_axis:
+ * uber_heat_map_get_shown:
  * @map: A #UberHeatMap.
  *
- * XXX
+ * Retrieves the ring of columns which is shown.  This is the ring of
+ * aggregated columns if more columns are retained than there are pixels to
+ * show them in, otherwise the ring of the zoom level.
  *
- * Returns: None.
+ * Returns: A #GRing of columns.
  * Side effects: None.
  */
-static void
-uber_heat_map_render_y_axis (UberHeatMap *map) /* IN */
+static inline GRing*
+uber_heat_map_get_shown (UberHeatMap *map) /* IN */
 {
-	UberHeatMapPrivate *priv;
+	UberHeatMapPrivate *priv = map->priv;
 
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	return (priv->agg > 1) ? priv->view : priv->levels[priv->zoom];
+}
 
-	priv = map->priv;
-#if 0
-	cairo_save(priv->bg_cairo);
-	gdk_cairo_rectangle(priv->bg_cairo, &priv->y_tick_rect);
-	cairo_set_source_rgba(priv->bg_cairo, 0, 0, 0, .3);
-	cairo_fill(priv->bg_cairo);
-	cairo_restore(priv->bg_cairo);
-#endif
+/**
+ * uber_heat_map_get_view_index:
+ * @map: A #UberHeatMap.
+ * @ix: The column counting back from the newest.
+ *
+ * Retrieves the index of a shown column in the ring of shown columns.  The
+ * zoom offset counts columns of the zoom level; the newest aggregated
+ * column holds priv->view_fill of them and the others priv->agg each.
+ *
+ * Returns: The index within uber_heat_map_get_shown().
+ * Side effects: None.
+ */
+static inline gint
+uber_heat_map_get_view_index (UberHeatMap *map, /* IN */
+                              gint         ix)  /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+
+	if (priv->agg > 1) {
+		return ix + (priv->zoom_offset + priv->agg - MAX(1, priv->view_fill))
+		          / priv->agg;
+	}
+	return ix + priv->zoom_offset;
 }
 
 /**
- * uber_heat_map_get_active_rect:
+ * uber_heat_map_get_level_span:
  * @map: A #UberHeatMap.
+ * @ix: The column counting back from the newest.
+ * @newest: A location for the newest column of the zoom level.
+ * @oldest: A location for the oldest column of the zoom level.
  *
- * XXX
+ * Retrieves the columns of the zoom level merged into a shown column,
+ * counting back from the newest column of the level.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_get_active_rect (UberHeatMap  *map,  /* IN */
-                               GdkRectangle *rect) /* OUT */
+uber_heat_map_get_level_span (UberHeatMap *map,    /* IN */
+                              gint         ix,     /* IN */
+                              guint       *newest, /* OUT */
+                              guint       *oldest) /* OUT */
 {
-	UberHeatMapPrivate *priv;
+	UberHeatMapPrivate *priv = map->priv;
+	guint fill;
+	guint v;
+
+	v = uber_heat_map_get_view_index(map, ix);
+	if (priv->agg > 1) {
+		fill = MAX(1, priv->view_fill);
+		*newest = v ? fill + (v - 1) * priv->agg : 0;
+		*oldest = fill + v * priv->agg - 1;
+	} else {
+		*newest = v;
+		*oldest = v;
+	}
+}
 
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(rect != NULL);
+/**
+ * uber_heat_map_get_level_tick:
+ * @map: A #UberHeatMap.
+ * @level: A level of the history.
+ * @offset: A column of @level, counting back from the newest.
+ *
+ * Retrieves the newest tick merged into a column of a level.  Ticks count
+ * back from the newest column of the first level, some of which are not
+ * merged into @level yet.
+ *
+ * Returns: The tick.
+ * Side effects: None.
+ */
+static inline guint
+uber_heat_map_get_level_tick (UberHeatMap *map,    /* IN */
+                              guint        level,  /* IN */
+                              guint        offset) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	guint rest;
 
-	priv = map->priv;
-	rect->x = priv->content_rect.x + 1 + (priv->active_column * priv->cur_block_width);
-	rect->y = priv->content_rect.y + 1 + (priv->active_row * priv->cur_block_height);
-	rect->width = priv->cur_block_width;
-	rect->height = priv->cur_block_height;
+	rest = priv->n_appended[0] - (priv->n_appended[level] << level);
+	return rest + (offset << level);
 }
 
 /**
- * uber_heat_map_render_bg:
+ * uber_heat_map_get_level_offset:
  * @map: A #UberHeatMap.
+ * @level: A level of the history.
+ * @tick: A tick, counting back from the newest.
  *
- * XXX
+ * Retrieves the column of a level which @tick is merged into; the inverse
+ * of uber_heat_map_get_level_tick().  Ticks not merged into @level yet map
+ * to its newest column.
  *
- * Returns: None.
+ * Returns: The column of @level, counting back from the newest.
  * Side effects: None.
  */
-static void
-uber_heat_map_render_bg (UberHeatMap *map) /* IN */
+static inline guint
+uber_heat_map_get_level_offset (UberHeatMap *map,   /* IN */
+                                guint        level, /* IN */
+                                guint        tick)  /* IN */
 {
-	static const gdouble dashes[] = { 1., 2. };
-	UberHeatMapPrivate *priv;
-	FlipTexture *first;
-	FlipTexture *other;
-	GtkAllocation alloc;
-	GtkStyle *style;
+	UberHeatMapPrivate *priv = map->priv;
+	guint rest;
 
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	rest = priv->n_appended[0] - (priv->n_appended[level] << level);
+	return (tick > rest) ? (tick - rest) >> level : 0;
+}
 
-	priv = map->priv;
-	style = gtk_widget_get_style(GTK_WIDGET(map));
-	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
-	first = &priv->textures[0];
-	other = &priv->textures[1];
-	/*
-	 * Draw the background onto the first pixmap.
-	 */
-	cairo_save(first->bg_cairo);
-	/*
-	 * Set the background to the default widget bg color.
-	 */
-	cairo_rectangle(first->bg_cairo, 0, 0, alloc.width, alloc.height);
-	gdk_cairo_set_source_color(first->bg_cairo, &style->bg[GTK_STATE_NORMAL]);
-	cairo_fill(first->bg_cairo);
-	/*
-	 * Clear the background.
-	 */
-	cairo_rectangle(first->bg_cairo,
-	                priv->content_rect.x + .5,
-	                priv->content_rect.y + .5,
-	                priv->content_rect.width - 1.,
-	                priv->content_rect.height - 1.);
-	gdk_cairo_set_source_color(first->bg_cairo, &style->light[GTK_STATE_NORMAL]);
-	cairo_fill_preserve(first->bg_cairo);
-	/*
-	 * Render the content border.
-	 */
-	gdk_cairo_set_source_color(first->bg_cairo, &style->fg[GTK_STATE_NORMAL]);
-	cairo_set_dash(first->bg_cairo, dashes, G_N_ELEMENTS(dashes), .5);
-	cairo_set_line_width(first->bg_cairo, 1.0);
-	cairo_stroke(first->bg_cairo);
-	/*
-	 * Render the axis labels.
-	 */
-	uber_heat_map_render_x_axis(map);
-	uber_heat_map_render_y_axis(map);
-	/*
-	 * Cleanup after drawing.
-	 */
-	cairo_restore(first->bg_cairo);
-	/*
-	 * Copy the background to the other texture.
-	 */
-	cairo_save(other->bg_cairo);
-	gdk_cairo_set_source_pixmap(other->bg_cairo, first->bg_pixmap, 0, 0);
-	cairo_rectangle(other->bg_cairo, 0, 0, alloc.width, alloc.height);
-	cairo_paint(other->bg_cairo);
-	cairo_restore(other->bg_cairo);
+/**
+ * uber_heat_map_get_column:
+ * @map: A #UberHeatMap.
+ * @ix: The column counting back from the newest.
+ * @scale: A location for the factor turning values into intensities.
+ *
+ * Retrieves a shown column along with the factor to normalize its values
+ * by for the current normalization mode.
+ *
+ * Returns: The column or %NULL.
+ * Side effects: None.
+ */
+static inline Column*
+uber_heat_map_get_column (UberHeatMap *map,   /* IN */
+                          gint         ix,    /* IN */
+                          gdouble     *scale) /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	GRing *shown = uber_heat_map_get_shown(map);
+	Column *col;
+	gdouble max = 0.;
+
+	*scale = 0.;
+	ix = uber_heat_map_get_view_index(map, ix);
+	if (ix >= shown->len) {
+		return NULL;
+	}
+	col = &g_ring_get_index(shown, Column, ix);
+	switch (priv->normalize) {
+	case UBER_HEAT_MAP_NORMALIZE_PER_COLUMN:
+		max = col->max;
+		break;
+	case UBER_HEAT_MAP_NORMALIZE_GLOBAL:
+		max = priv->global_max;
+		break;
+	case UBER_HEAT_MAP_NORMALIZE_DECAY:
+		max = col->norm;
+		break;
+	case UBER_HEAT_MAP_NORMALIZE_FIXED:
+		max = priv->max_value;
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	if (max > 0.) {
+		*scale = 1. / max;
+	}
+	return col->values ? col : NULL;
 }
 
 /**
- * uber_heat_map_expose_event:
- * @widget: A #GtkWidget.
- * @expose: A #GdkEventExpose.
+ * uber_heat_map_get_row_buckets:
+ * @n_buckets: The number of buckets.
+ * @row: The row counting up from the bottom.
+ * @ycount: The number of rows.
+ * @first: A location for the first bucket of @row.
+ * @last: A location for the bucket after the last.
  *
- * Handles the exposure event.
+ * Maps a row to the buckets it shows.  Buckets are spread evenly across
+ * the rows; if there are more buckets than rows, neighbouring buckets
+ * share a row, otherwise a bucket spans several rows.
  *
  * Returns: None.
  * Side effects: None.
  */
-static gboolean
-uber_heat_map_expose_event (GtkWidget      *widget, /* IN */
-                            GdkEventExpose *expose) /* IN */
+static inline void
+uber_heat_map_get_row_buckets (guint  n_buckets, /* IN */
+                               gint   row,       /* IN */
+                               gint   ycount,    /* IN */
+                               guint *first,     /* OUT */
+                               guint *last)      /* OUT */
 {
-	UberHeatMapPrivate *priv;
-	FlipTexture *texture;
-	GtkAllocation alloc;
-	GdkRectangle area;
-	cairo_t *cr;
+	*first = (guint64)row * n_buckets / ycount;
+	*last = (guint64)(row + 1) * n_buckets / ycount;
+	*last = MIN(MAX(*first + 1, *last), n_buckets);
+}
 
-	g_return_val_if_fail(UBER_IS_HEAT_MAP(widget), FALSE);
+/**
+ * uber_heat_map_get_row_value:
+ * @col: A column from uber_heat_map_get_column() or %NULL.
+ * @row: The row counting up from the bottom.
+ * @ycount: The number of rows.
+ *
+ * Retrieves the value shown in a row of a column, which is the largest of
+ * the buckets mapped to the row.
+ *
+ * Returns: The value of the row.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_heat_map_get_row_value (Column *col,    /* IN */
+                             gint    row,    /* IN */
+                             gint    ycount) /* IN */
+{
+	gdouble value = 0.;
+	guint first;
+	guint last;
+	guint i;
 
-	priv = UBER_HEAT_MAP(widget)->priv;
-	gtk_widget_get_allocation(widget, &alloc);
-	/*
-	 * Draw the foreground and background if needed.
-	 */
-	if (priv->bg_dirty) {
-		uber_heat_map_render_bg(UBER_HEAT_MAP(widget));
-		priv->bg_dirty = FALSE;
+	if (!col || ycount <= 0) {
+		return 0.;
 	}
-	if (priv->fg_dirty) {
-		uber_heat_map_render_fg(UBER_HEAT_MAP(widget), priv->full_draw);
-		priv->fg_dirty = FALSE;
-		priv->full_draw = FALSE;
+	uber_heat_map_get_row_buckets(col->values->len, row, ycount,
+	                              &first, &last);
+	for (i = first; i < last; i++) {
+		value = MAX(value, g_array_index(col->values, gdouble, i));
 	}
+	return value;
+}
+
+/**
+ * uber_heat_map_get_intensity:
+ * @col: A column from uber_heat_map_get_column() or %NULL.
+ * @row: The row counting up from the bottom.
+ * @ycount: The number of rows.
+ * @scale: The factor from uber_heat_map_get_column().
+ *
+ * Retrieves the intensity of a cell.
+ *
+ * Returns: The intensity between 0 and 1.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_heat_map_get_intensity (Column  *col,    /* IN */
+                             gint     row,    /* IN */
+                             gint     ycount, /* IN */
+                             gdouble  scale)  /* IN */
+{
+	return CLAMP(uber_heat_map_get_row_value(col, row, ycount) * scale, 0., 1.);
+}
+
+/**
+ * uber_heat_map_destroy_strip:
+ * @map: A #UberHeatMap.
+ *
+ * Destroys the server-side column strip and its client-side column.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_destroy_strip (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (priv->strip_cairo) {
+		cairo_destroy(priv->strip_cairo);
+		priv->strip_cairo = NULL;
+	}
+	if (priv->strip_pixmap) {
+		g_object_unref(priv->strip_pixmap);
+		priv->strip_pixmap = NULL;
+	}
+	if (priv->column_surface) {
+		cairo_surface_destroy(priv->column_surface);
+		priv->column_surface = NULL;
+	}
+}
+
+/**
+ * uber_heat_map_ensure_strip:
+ * @map: A #UberHeatMap.
+ *
+ * Makes sure the column strip matches the current block layout.  The strip
+ * is a server-side pixmap holding a ring of one slot per shown column; new
+ * columns are rasterized client-side one at a time and uploaded over the
+ * oldest slot in place, and the expose handler copies the two segments on
+ * either side of the newest slot.  Aggregated columns are as wide as the
+ * columns they were merged from together.
+ *
+ * Returns: %TRUE if the strip was recreated and must be fully drawn.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_ensure_strip (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	GdkDrawable *drawable;
+	gdouble block_width;
+	gint xcount;
+	gint ycount;
+	gint width;
+	gint height;
+	gint cur_width;
+	gint cur_height;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), FALSE);
+
+	priv = map->priv;
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	block_width = priv->cur_block_width;
+	if (priv->agg > 1) {
+		xcount = priv->view->len;
+		block_width *= priv->agg;
+	}
+	xcount = MAX(0, xcount);
+	width = MAX(1, (gint)rint(xcount * block_width));
+	height = MAX(1, priv->content_rect.height - 2);
+	if (priv->strip_pixmap) {
+		gdk_drawable_get_size(priv->strip_pixmap, &cur_width, &cur_height);
+		if (priv->strip_slots == xcount &&
+		    priv->strip_block_width == block_width &&
+		    cur_width == width &&
+		    cur_height == height) {
+			return FALSE;
+		}
+	}
+	uber_heat_map_destroy_strip(map);
+	drawable = gtk_widget_get_window(GTK_WIDGET(map));
+	priv->strip_pixmap = gdk_pixmap_new(drawable, width, height, -1);
+	priv->strip_cairo = gdk_cairo_create(priv->strip_pixmap);
+	cairo_set_operator(priv->strip_cairo, CAIRO_OPERATOR_SOURCE);
 	/*
-	 * Get the current texture.  Make sure we draw first as priv->flipped
-	 * may have changed.
-	 */
-	texture = &priv->textures[priv->flipped];
-	/*
-	 * Draw contents to widget surface using cairo.
-	 */
-	cr = gdk_cairo_create(expose->window);
-	gdk_cairo_rectangle(cr, &expose->area);
-	cairo_clip(cr);
-	/*
-	 * Draw the background.
+	 * A slot spans at most the block width rounded up, plus a pixel for
+	 * the rounding of its edges.
 	 */
-	gdk_cairo_set_source_pixmap(cr, texture->bg_pixmap, 0, 0);
-	cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-	cairo_paint(cr);
+	priv->column_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24,
+	                                                  (gint)ceil(block_width) + 1,
+	                                                  height);
+	priv->strip_slots = xcount;
+	priv->strip_head = 0;
+	priv->strip_width = width;
+	priv->strip_block_width = block_width;
+	return TRUE;
+}
+
+/**
+ * uber_heat_map_get_slot_span:
+ * @map: A #UberHeatMap.
+ * @slot: A slot of the column strip.
+ * @x0: A location for the first pixel column of the slot.
+ * @x1: A location for the pixel column after the slot.
+ *
+ * Retrieves the pixels of the strip covered by @slot.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_heat_map_get_slot_span (UberHeatMap *map,  /* IN */
+                             gint         slot, /* IN */
+                             gint        *x0,   /* OUT */
+                             gint        *x1)   /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+
+	*x0 = rint(slot * priv->strip_block_width);
+	*x1 = rint((slot + 1) * priv->strip_block_width);
+}
+
+/**
+ * uber_heat_map_get_split:
+ * @map: A #UberHeatMap.
+ * @offset: A location for the offset of the newest segment.
+ *
+ * Calculates where the strip wraps.  Pixels of the strip before the
+ * returned split hold the newest columns and are shown at @offset from
+ * the left of the content area; the rest are shown before them.
+ *
+ * Returns: The pixel column after the newest slot.
+ * Side effects: None.
+ */
+static inline gint
+uber_heat_map_get_split (UberHeatMap *map,    /* IN */
+                         gint        *offset) /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint split;
+
+	split = rint((priv->strip_head + 1) * priv->strip_block_width);
+	*offset = (priv->content_rect.width - 2) - split;
+	return split;
+}
+
+/**
+ * uber_heat_map_get_column_span:
+ * @map: A #UberHeatMap.
+ * @ix: The column counting back from the newest.
+ * @x0: A location for the first pixel column.
+ * @x1: A location for the pixel column after the last.
+ *
+ * Retrieves where column @ix is shown, relative to the content area
+ * without its border.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_column_span (UberHeatMap *map, /* IN */
+                               gint         ix,  /* IN */
+                               gint        *x0,  /* OUT */
+                               gint        *x1)  /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint offset;
+	gint slot;
+
+	slot = (priv->strip_head - (ix % priv->strip_slots) + priv->strip_slots)
+	     % priv->strip_slots;
+	uber_heat_map_get_slot_span(map, slot, x0, x1);
+	uber_heat_map_get_split(map, &offset);
+	if (slot > priv->strip_head) {
+		offset -= priv->strip_width;
+	}
+	*x0 += offset;
+	*x1 += offset;
+}
+
+/**
+ * uber_heat_map_render_fg:
+ * @map: A #UberHeatMap.
+ * @full_draw: Redraw the entire contents.
+ *
+ * Renders the foreground.  If @full_draw is %TRUE, then we will draw the
+ * entire contents rather than just the columns appended since the last
+ * render.
+ *
+ * Each column is rasterized client-side using the color lookup table and
+ * only its pixels are uploaded into its slot of the server-side column
+ * strip.  The strip is opaque; empty cells take the first color of the
+ * table.  Appending a column advances the head of the strip and overwrites
+ * the oldest slot, so nothing else is touched or sent to the X-server.
+ * When columns are aggregated, the newest column is redrawn in place as
+ * further columns are merged into it.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_fg (UberHeatMap *map,       /* IN */
+                         gboolean     full_draw) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	Column *col;
+	guint8 *fg_data;
+	gdouble scale;
+	gint stride;
+	gint width;
+	gint height;
+	gint xcount;
+	gint ycount;
+	gint ncols;
+	gint slot;
+	gint x0;
+	gint x1;
+	gint y0;
+	gint y1;
+	gint ix;
+	gint iy;
+	guint idx;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (uber_heat_map_ensure_strip(map)) {
+		full_draw = TRUE;
+	}
+	if (!priv->lut_valid) {
+		uber_heat_map_update_lut(map);
+		full_draw = TRUE;
+	}
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	if (!priv->strip_slots) {
+		priv->pending = 0;
+		return;
+	}
+	if (priv->pending >= priv->strip_slots) {
+		full_draw = TRUE;
+	}
 	/*
-	 * Draw the foreground.
+	 * Access the pixels of the column.
 	 */
-	gdk_cairo_set_source_pixmap(cr, texture->fg_pixmap, 0, 0);
-	cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-	cairo_paint(cr);
+	fg_data = cairo_image_surface_get_data(priv->column_surface);
+	stride = cairo_image_surface_get_stride(priv->column_surface);
+	width = cairo_image_surface_get_width(priv->column_surface);
+	height = cairo_image_surface_get_height(priv->column_surface);
+	if (full_draw) {
+		ncols = priv->strip_slots;
+	} else {
+		priv->strip_head = (priv->strip_head + priv->pending)
+		                 % priv->strip_slots;
+		ncols = MAX(priv->pending, priv->refresh ? 1 : 0);
+	}
+	priv->pending = 0;
+	priv->refresh = FALSE;
 	/*
-	 * Draw the highlight rectangle if needed.
+	 * Render the contents for the various blocks.
 	 */
-	if (priv->in_hover) {
-		if (priv->active_column > -1 && priv->active_row > -1) {
-			uber_heat_map_get_active_rect(UBER_HEAT_MAP(widget), &area);
-			DEBUG_RECT(area);
-			gdk_cairo_set_source_pixmap(cr, texture->hl_pixmap, 0, 0);
-			gdk_cairo_rectangle(cr, &area);
-			cairo_paint(cr);
+	for (ix = 0; ix < ncols; ix++) {
+		slot = (priv->strip_head - ix + priv->strip_slots) % priv->strip_slots;
+		uber_heat_map_get_slot_span(map, slot, &x0, &x1);
+		x1 = MIN(MIN(x1, priv->strip_width), x0 + width);
+		if (x0 >= x1) {
+			continue;
+		}
+		/*
+		 * Rasterize the column at the left edge of the scratch column.
+		 */
+		cairo_surface_flush(priv->column_surface);
+		uber_heat_map_fill_span(fg_data, stride, 0, x1 - x0, 0, height,
+		                        priv->fg_lut[0]);
+		if ((col = uber_heat_map_get_column(map, ix, &scale))) {
+			for (iy = 0; iy < ycount; iy++) {
+				idx = uber_heat_map_get_intensity(col, iy, ycount, scale)
+				    * (LUT_SIZE - 1) + .5;
+				if (!idx) {
+					continue;
+				}
+				y0 = CLAMP(height - (gint)rint((iy + 1) * priv->cur_block_height), 0, height);
+				y1 = CLAMP(height - (gint)rint(iy * priv->cur_block_height), 0, height);
+				uber_heat_map_fill_span(fg_data, stride, 0, x1 - x0, y0, y1,
+				                        priv->fg_lut[idx]);
+			}
 		}
+		cairo_surface_mark_dirty(priv->column_surface);
+		/*
+		 * Upload just the pixels of the slot.
+		 */
+		cairo_set_source_surface(priv->strip_cairo, priv->column_surface,
+		                         x0, 0);
+		cairo_rectangle(priv->strip_cairo, x0, 0, x1 - x0, height);
+		cairo_fill(priv->strip_cairo);
 	}
-	/*
-	 * Cleanup after drawing.
-	 */
-	cairo_destroy(cr);
-	return FALSE;
 }
 
 /**
- * uber_heat_map_set_x_range:
+ * uber_heat_map_render_x_axis:
  * @map: A #UberHeatMap.
- * @x_range: An #UberRange.
  *
- * Sets the range of valid inputs for the X axis.  Values outside of this range
- * will not show up on the heat map.
+ * XXX
  *
  * Returns: None.
  * Side effects: None.
  */
-void
-uber_heat_map_set_x_range (UberHeatMap     *map,     /* IN */
-                           const UberRange *x_range) /* IN */
+static void
+uber_heat_map_render_x_axis (UberHeatMap *map) /* IN */
 {
 	UberHeatMapPrivate *priv;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(x_range != NULL);
 
 	priv = map->priv;
+#if 0
+	cairo_save(priv->bg_cairo);
+	gdk_cairo_rectangle(priv->bg_cairo, &priv->x_tick_rect);
+	cairo_set_source_rgba(priv->bg_cairo, 0, 0, 0, .3);
+	cairo_fill(priv->bg_cairo);
+	cairo_restore(priv->bg_cairo);
+#endif
+}
+
+/**
+ * uber_heat_map_render_y_axis:
+ * @map: A #UberHeatMap.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_y_axis (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+#if 0
+	cairo_save(priv->bg_cairo);
+	gdk_cairo_rectangle(priv->bg_cairo, &priv->y_tick_rect);
+	cairo_set_source_rgba(priv->bg_cairo, 0, 0, 0, .3);
+	cairo_fill(priv->bg_cairo);
+	cairo_restore(priv->bg_cairo);
+#endif
+}
+
+/**
+ * uber_heat_map_get_cell_rect:
+ * @map: A #UberHeatMap.
+ * @ix: The column counting back from the newest.
+ * @iy: The row counting up from the bottom.
+ * @rect: A location for the rectangle.
+ *
+ * Retrieves the area of the widget covered by a cell, clipped to the
+ * content area.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_cell_rect (UberHeatMap  *map,  /* IN */
+                             gint          ix,   /* IN */
+                             gint          iy,   /* IN */
+                             GdkRectangle *rect) /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint width;
+	gint height;
+	gint x0;
+	gint x1;
+	gint y0;
+	gint y1;
+
+	width = MAX(0, priv->content_rect.width - 2);
+	height = MAX(0, priv->content_rect.height - 2);
+	uber_heat_map_get_column_span(map, ix, &x0, &x1);
+	x0 = CLAMP(x0, 0, width);
+	x1 = CLAMP(x1, 0, width);
+	y0 = CLAMP(height - (gint)rint((iy + 1) * priv->cur_block_height), 0, height);
+	y1 = CLAMP(height - (gint)rint(iy * priv->cur_block_height), 0, height);
+	rect->x = priv->content_rect.x + 1 + x0;
+	rect->y = priv->content_rect.y + 1 + y0;
+	rect->width = x1 - x0;
+	rect->height = y1 - y0;
+}
+
+/**
+ * uber_heat_map_get_active_rect:
+ * @map: A #UberHeatMap.
+ * @rect: A location for the rectangle.
+ *
+ * Retrieves the area of the widget covered by the hovered cell.
+ *
+ * Returns: %TRUE if a cell is hovered; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_get_active_rect (UberHeatMap  *map,  /* IN */
+                               GdkRectangle *rect) /* OUT */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), FALSE);
+	g_return_val_if_fail(rect != NULL, FALSE);
+
+	priv = map->priv;
+	if (priv->active_column < 0 || priv->active_row < 0 ||
+	    !priv->strip_slots) {
+		return FALSE;
+	}
+	uber_heat_map_get_cell_rect(map, priv->active_column, priv->active_row,
+	                            rect);
+	return TRUE;
+}
+
+/**
+ * uber_heat_map_hit_test:
+ * @map: A #UberHeatMap.
+ * @x: The x coordinate within the widget.
+ * @y: The y coordinate within the widget.
+ * @column: A location for the column counting back from the newest.
+ * @row: A location for the row counting up from the bottom.
+ *
+ * Finds the cell at a point.  The cell is estimated from the block size
+ * and corrected by one if the rounding of the cell edges moved the point
+ * into a neighbour, so the cost does not depend on the number of cells.
+ *
+ * Returns: %TRUE if there is a cell at the point; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_hit_test (UberHeatMap *map,    /* IN */
+                        gdouble      x,      /* IN */
+                        gdouble      y,      /* IN */
+                        gint        *column, /* OUT */
+                        gint        *row)    /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint width;
+	gint height;
+	gint xcount;
+	gint ycount;
+	gint px;
+	gint py;
+	gint ix;
+	gint iy;
+	gint x0;
+	gint x1;
+	gint y0;
+	gint y1;
+
+	*column = -1;
+	*row = -1;
+	if (!priv->strip_slots ||
+	    priv->strip_block_width <= 0. ||
+	    priv->cur_block_height <= 0.) {
+		return FALSE;
+	}
+	width = priv->content_rect.width - 2;
+	height = priv->content_rect.height - 2;
+	px = (gint)floor(x) - (priv->content_rect.x + 1);
+	py = (gint)floor(y) - (priv->content_rect.y + 1);
+	if (px < 0 || py < 0 || px >= width || py >= height) {
+		return FALSE;
+	}
 	/*
-	 * Store and recalculate range.
+	 * Columns are laid out from the right and rows from the bottom.
+	 */
+	ix = (width - px - 1) / priv->strip_block_width;
+	uber_heat_map_get_column_span(map, ix, &x0, &x1);
+	if (px < x0) {
+		ix++;
+	} else if (px >= x1) {
+		ix--;
+	}
+	iy = (height - py - 1) / priv->cur_block_height;
+	y0 = height - (gint)rint((iy + 1) * priv->cur_block_height);
+	y1 = height - (gint)rint(iy * priv->cur_block_height);
+	if (py < y0) {
+		iy++;
+	} else if (py >= y1) {
+		iy--;
+	}
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	if (ix < 0 || ix >= priv->strip_slots || iy < 0 || iy >= ycount) {
+		return FALSE;
+	}
+	*column = ix;
+	*row = iy;
+	return TRUE;
+}
+
+/**
+ * uber_heat_map_get_bucket_range:
+ * @map: A #UberHeatMap.
+ * @bucket: The bucket counting up from the bottom.
+ * @range: A location for the range.
+ *
+ * Retrieves the range of values counted in @bucket.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_bucket_range (UberHeatMap *map,    /* IN */
+                                guint        bucket, /* IN */
+                                UberRange   *range)  /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gdouble s = priv->bucket_scale;
+	gdouble o = priv->bucket_offset;
+
+	*range = priv->y_range;
+	switch (priv->scale) {
+	case UBER_HEAT_MAP_SCALE_LINEAR:
+		if (s > 0.) {
+			range->begin = (bucket - o) / s;
+			range->end = (bucket + 1 - o) / s;
+		}
+		break;
+	case UBER_HEAT_MAP_SCALE_LOG2:
+	case UBER_HEAT_MAP_SCALE_LOG10:
+		if (s > 0.) {
+			range->begin = pow(2., (bucket - o) / s);
+			range->end = pow(2., (bucket + 1 - o) / s);
+		}
+		break;
+	case UBER_HEAT_MAP_SCALE_CUSTOM:
+		if (bucket + 1 < priv->n_edges) {
+			range->begin = priv->edges[bucket];
+			range->end = priv->edges[bucket + 1];
+		}
+		break;
+	default:
+		g_assert_not_reached();
+	}
+	range->range = range->end - range->begin;
+}
+
+/**
+ * uber_heat_map_update_tooltip:
+ * @map: A #UberHeatMap.
+ *
+ * Sets the tooltip to the value of the hovered cell, formatted with the
+ * function set with uber_heat_map_set_format_func() if there is one.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_tooltip (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	UberRange range;
+	UberRange end;
+	Column *col;
+	gdouble scale;
+	gdouble value;
+	gchar *tooltip;
+	guint first;
+	guint last;
+	gint xcount;
+	gint ycount;
+
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	if (priv->active_column < 0 || priv->active_row < 0 ||
+	    ycount <= 0 || !priv->n_buckets) {
+		gtk_widget_set_tooltip_text(GTK_WIDGET(map), "");
+		return;
+	}
+	col = uber_heat_map_get_column(map, priv->active_column, &scale);
+	value = uber_heat_map_get_row_value(col, priv->active_row, ycount);
+	/*
+	 * Describe every bucket shown in the row.
+	 */
+	uber_heat_map_get_row_buckets(priv->n_buckets, priv->active_row, ycount,
+	                              &first, &last);
+	uber_heat_map_get_bucket_range(map, first, &range);
+	uber_heat_map_get_bucket_range(map, last - 1, &end);
+	range.end = end.end;
+	range.range = range.end - range.begin;
+	if (priv->format_func) {
+		tooltip = priv->format_func(map, priv->active_column, first,
+		                            &range, value, priv->format_user_data);
+	} else {
+		tooltip = g_strdup_printf("%g - %g: %g", range.begin, range.end, value);
+	}
+	gtk_widget_set_tooltip_text(GTK_WIDGET(map), tooltip);
+	g_free(tooltip);
+}
+
+/**
+ * uber_heat_map_invalidate_active:
+ * @map: A #UberHeatMap.
+ *
+ * Invalidates the area of the hovered cell so its highlight is redrawn.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_invalidate_active (UberHeatMap *map) /* IN */
+{
+	GdkRectangle rect;
+	GdkWindow *window;
+
+	window = gtk_widget_get_window(GTK_WIDGET(map));
+	if (window && uber_heat_map_get_active_rect(map, &rect)) {
+		gdk_window_invalidate_rect(window, &rect, FALSE);
+	}
+}
+
+/**
+ * uber_heat_map_clamp_x:
+ * @map: A #UberHeatMap.
+ * @x: The x coordinate within the widget.
+ *
+ * Clamps @x to the content area without its border.
+ *
+ * Returns: The clamped coordinate.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_heat_map_clamp_x (UberHeatMap *map, /* IN */
+                       gdouble      x)   /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+
+	return CLAMP(x, priv->content_rect.x + 1,
+	             GDK_RECTANGLE_RIGHT(priv->content_rect) - 1);
+}
+
+/**
+ * uber_heat_map_get_drag_rect:
+ * @map: A #UberHeatMap.
+ * @rect: A location for the rectangle.
+ *
+ * Retrieves the area of the widget covered by the selection being dragged.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_drag_rect (UberHeatMap  *map,  /* IN */
+                             GdkRectangle *rect) /* OUT */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint x0;
+	gint x1;
+
+	x0 = floor(MIN(priv->drag_begin, priv->drag_end));
+	x1 = ceil(MAX(priv->drag_begin, priv->drag_end));
+	rect->x = x0;
+	rect->y = priv->content_rect.y + 1;
+	rect->width = MAX(1, x1 - x0);
+	rect->height = MAX(0, priv->content_rect.height - 2);
+}
+
+/**
+ * uber_heat_map_invalidate_drag:
+ * @map: A #UberHeatMap.
+ *
+ * Invalidates the area of the selection being dragged.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_invalidate_drag (UberHeatMap *map) /* IN */
+{
+	GdkRectangle rect;
+	GdkWindow *window;
+
+	if ((window = gtk_widget_get_window(GTK_WIDGET(map)))) {
+		uber_heat_map_get_drag_rect(map, &rect);
+		gdk_window_invalidate_rect(window, &rect, FALSE);
+	}
+}
+
+/**
+ * uber_heat_map_render_highlight:
+ * @map: A #UberHeatMap.
+ * @cr: A cairo context for the widget window.
+ *
+ * Renders the highlight of the hovered cell from the data.  The cell is
+ * filled in the highlight color with its intensity.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_highlight (UberHeatMap *map, /* IN */
+                                cairo_t     *cr)  /* IN */
+{
+	UberHeatMapPrivate *priv;
+	GdkRectangle active;
+	Column *col;
+	gdouble scale;
+	gdouble alpha;
+	gint xcount;
+	gint ycount;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (!uber_heat_map_get_active_rect(map, &active)) {
+		return;
+	}
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	col = uber_heat_map_get_column(map, priv->active_column, &scale);
+	alpha = uber_heat_map_get_intensity(col, priv->active_row, ycount, scale);
+	if (alpha > 0.) {
+		gdk_cairo_rectangle(cr, &active);
+		cairo_set_source_rgba(cr,
+		                      priv->hl_color.red / 65535.,
+		                      priv->hl_color.green / 65535.,
+		                      priv->hl_color.blue / 65535.,
+		                      alpha);
+		cairo_fill(cr);
+	}
+}
+
+/**
+ * uber_heat_map_render_row_groups:
+ * @map: A #UberHeatMap.
+ * @cr: A cairo context for the widget window.
+ * @area: The content area without its border.
+ *
+ * Renders a line between each group of rows set with
+ * uber_heat_map_set_row_groups().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_row_groups (UberHeatMap  *map,  /* IN */
+                                 cairo_t      *cr,   /* IN */
+                                 GdkRectangle *area) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	GtkStyle *style;
+	gdouble y;
+	guint64 bucket = 0;
+	gint xcount;
+	gint ycount;
+	gint row;
+	gint i;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (priv->n_row_groups < 2 || !priv->n_buckets) {
+		return;
+	}
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	style = gtk_widget_get_style(GTK_WIDGET(map));
+	for (i = 0; i < priv->n_row_groups - 1; i++) {
+		/*
+		 * The line goes below the first row showing the next group.
+		 */
+		bucket += priv->row_groups[i];
+		row = (bucket * ycount + priv->n_buckets - 1) / priv->n_buckets;
+		y = area->y + area->height - rint(row * priv->cur_block_height) - .5;
+		cairo_move_to(cr, area->x, y);
+		cairo_line_to(cr, area->x + area->width, y);
+	}
+	gdk_cairo_set_source_color(cr, &style->fg[GTK_STATE_NORMAL]);
+	cairo_set_line_width(cr, 1.0);
+	cairo_stroke(cr);
+}
+
+/**
+ * uber_heat_map_render_bg:
+ * @map: A #UberHeatMap.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_bg (UberHeatMap *map) /* IN */
+{
+	static const gdouble dashes[] = { 1., 2. };
+	UberHeatMapPrivate *priv;
+	GtkAllocation alloc;
+	GtkStyle *style;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	style = gtk_widget_get_style(GTK_WIDGET(map));
+	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
+	/*
+	 * Draw the background onto the pixmap.
+	 */
+	cairo_save(priv->bg_cairo);
+	/*
+	 * Set the background to the default widget bg color.
+	 */
+	cairo_rectangle(priv->bg_cairo, 0, 0, alloc.width, alloc.height);
+	gdk_cairo_set_source_color(priv->bg_cairo, &style->bg[GTK_STATE_NORMAL]);
+	cairo_fill(priv->bg_cairo);
+	/*
+	 * Clear the background.
+	 */
+	cairo_rectangle(priv->bg_cairo,
+	                priv->content_rect.x + .5,
+	                priv->content_rect.y + .5,
+	                priv->content_rect.width - 1.,
+	                priv->content_rect.height - 1.);
+	gdk_cairo_set_source_color(priv->bg_cairo, &style->light[GTK_STATE_NORMAL]);
+	cairo_fill_preserve(priv->bg_cairo);
+	/*
+	 * Render the content border.
+	 */
+	gdk_cairo_set_source_color(priv->bg_cairo, &style->fg[GTK_STATE_NORMAL]);
+	cairo_set_dash(priv->bg_cairo, dashes, G_N_ELEMENTS(dashes), .5);
+	cairo_set_line_width(priv->bg_cairo, 1.0);
+	cairo_stroke(priv->bg_cairo);
+	/*
+	 * Render the axis labels.
+	 */
+	uber_heat_map_render_x_axis(map);
+	uber_heat_map_render_y_axis(map);
+	/*
+	 * Cleanup after drawing.
+	 */
+	cairo_restore(priv->bg_cairo);
+}
+
+/**
+ * uber_heat_map_expose_event:
+ * @widget: A #GtkWidget.
+ * @expose: A #GdkEventExpose.
+ *
+ * Handles the exposure event.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_expose_event (GtkWidget      *widget, /* IN */
+                            GdkEventExpose *expose) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	GdkRectangle area;
+	GdkRectangle covered;
+	GdkRegion *region;
+	GdkRegion *strip;
+	cairo_t *cr;
+	gint offset;
+	gint split;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(widget), FALSE);
+
+	priv = UBER_HEAT_MAP(widget)->priv;
+	/*
+	 * Draw the foreground and background if needed.
+	 */
+	if (priv->bg_dirty) {
+		uber_heat_map_render_bg(UBER_HEAT_MAP(widget));
+		priv->bg_dirty = FALSE;
+	}
+	if (priv->fg_dirty) {
+		uber_heat_map_render_fg(UBER_HEAT_MAP(widget), priv->full_draw);
+		priv->fg_dirty = FALSE;
+		priv->full_draw = FALSE;
+	}
+	/*
+	 * The strip is opaque, so the background is only needed where the
+	 * strip does not cover the content area.  The background pixmap holds
+	 * the static parts of the widget already merged together.
+	 */
+	area = priv->content_rect;
+	area.x += 1;
+	area.y += 1;
+	area.width -= 2;
+	area.height -= 2;
+	covered = area;
+	covered.width = 0;
+	if (priv->strip_slots) {
+		covered.width = MIN(area.width, priv->strip_width);
+		covered.x = area.x + area.width - covered.width;
+	}
+	/*
+	 * Draw contents to widget surface using cairo.
+	 */
+	cr = gdk_cairo_create(expose->window);
+	/*
+	 * Draw the background.
+	 */
+	region = gdk_region_copy(expose->region);
+	if (covered.width > 0) {
+		strip = gdk_region_rectangle(&covered);
+		gdk_region_subtract(region, strip);
+		gdk_region_destroy(strip);
+	}
+	if (!gdk_region_empty(region)) {
+		cairo_save(cr);
+		gdk_cairo_region(cr, region);
+		cairo_clip(cr);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		gdk_cairo_set_source_pixmap(cr, priv->bg_pixmap, 0, 0);
+		cairo_paint(cr);
+		cairo_restore(cr);
+	}
+	gdk_region_destroy(region);
+	gdk_cairo_region(cr, expose->region);
+	cairo_clip(cr);
+	/*
+	 * Draw the foreground.  The newest columns are at the start of the
+	 * strip and shown on the right; the older columns after them wrap
+	 * around to the left.  Nothing is blended; both segments are copied
+	 * server-side from the strip pixmap.
+	 */
+	if (covered.width > 0) {
+		cairo_save(cr);
+		gdk_cairo_rectangle(cr, &covered);
+		cairo_clip(cr);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		split = uber_heat_map_get_split(UBER_HEAT_MAP(widget), &offset);
+		gdk_cairo_set_source_pixmap(cr, priv->strip_pixmap,
+		                            area.x + offset, area.y);
+		cairo_rectangle(cr, area.x + offset, area.y, split, area.height);
+		cairo_fill(cr);
+		gdk_cairo_set_source_pixmap(cr, priv->strip_pixmap,
+		                            area.x + offset - priv->strip_width,
+		                            area.y);
+		cairo_rectangle(cr, area.x + offset - priv->strip_width + split,
+		                area.y, priv->strip_width - split, area.height);
+		cairo_fill(cr);
+		cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+		uber_heat_map_render_row_groups(UBER_HEAT_MAP(widget), cr, &area);
+		cairo_restore(cr);
+	}
+	/*
+	 * Draw the highlight rectangle if needed.
+	 */
+	if (priv->in_hover) {
+		uber_heat_map_render_highlight(UBER_HEAT_MAP(widget), cr);
+	}
+	/*
+	 * Draw the selection being dragged.
+	 */
+	if (priv->dragging) {
+		uber_heat_map_get_drag_rect(UBER_HEAT_MAP(widget), &area);
+		gdk_cairo_rectangle(cr, &area);
+		cairo_set_source_rgba(cr,
+		                      priv->hl_color.red / 65535.,
+		                      priv->hl_color.green / 65535.,
+		                      priv->hl_color.blue / 65535.,
+		                      .3);
+		cairo_fill(cr);
+	}
+	/*
+	 * Cleanup after drawing.
+	 */
+	cairo_destroy(cr);
+	return FALSE;
+}
+
+/**
+ * uber_heat_map_set_x_range:
+ * @map: A #UberHeatMap.
+ * @x_range: An #UberRange.
+ *
+ * Sets the range of valid inputs for the X axis.  Values outside of this range
+ * will not show up on the heat map.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_x_range (UberHeatMap     *map,     /* IN */
+                           const UberRange *x_range) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(x_range != NULL);
+
+	priv = map->priv;
+	/*
+	 * Store and recalculate range.
 	 */
 	priv->x_range = *x_range;
 	priv->x_range.range = priv->x_range.end - priv->x_range.begin;
 	/*
-	 * Force full draw of entire widget.
+	 * Force full draw of entire widget.
+	 */
+	priv->fg_dirty = TRUE;
+	priv->bg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_y_range:
+ * @map: A #UberHeatMap.
+ * @y_range: An #UberRange.
+ *
+ * Sets the range of values for the Y axis.  Pushed observations are
+ * bucketed across this range; see uber_heat_map_set_scale().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_y_range (UberHeatMap     *map,     /* IN */
+                           const UberRange *y_range) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(y_range != NULL);
+
+	priv = map->priv;
+	/*
+	 * Store and recalculate range.
+	 */
+	priv->y_range = *y_range;
+	priv->y_range.range = priv->y_range.end - priv->y_range.begin;
+	uber_heat_map_update_buckets(map);
+	uber_heat_map_update_aggregation(map);
+	/*
+	 * Force full draw of entire widget.
+	 */
+	priv->fg_dirty = TRUE;
+	priv->bg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_block_size:
+ * @map: A #UberHeatMap.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_block_size (UberHeatMap *map,             /* IN */
+                              gint         width,           /* IN */
+                              gboolean     width_is_count,  /* IN */
+                              gint         height,          /* IN */
+                              gboolean     height_is_count) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	GtkAllocation alloc;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(width > 0);
+	g_return_if_fail(height > 0);
+
+	priv = map->priv;
+	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
+	/*
+	 * A fixed number of rows changes the requested height.
+	 */
+	if (height != priv->height_block_size ||
+	    height_is_count != priv->height_is_count) {
+		gtk_widget_queue_resize(GTK_WIDGET(map));
+	}
+	/*
+	 * Store new width/height block size settings.
+	 */
+	priv->width_block_size = width;
+	priv->width_is_count = width_is_count;
+	priv->height_block_size = height;
+	priv->height_is_count = height_is_count;
+	/*
+	 * Recalculate the real block sizes.
+	 */
+	if (width_is_count) {
+		priv->cur_block_width = (priv->content_rect.width - 2) / (gdouble)width;
+	} else {
+		priv->cur_block_width = width;
+		priv->col_count = width;
+	}
+	if (height_is_count) {
+		priv->cur_block_height = (priv->content_rect.height - 2) / (gdouble)height;
+	} else {
+		priv->cur_block_height = height;
+		priv->row_count = height;
+	}
+	/*
+	 * Force full draw of entire widget.
+	 */
+	priv->fg_dirty = TRUE;
+	priv->bg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_scale:
+ * @map: A #UberHeatMap.
+ * @scale: An #UberHeatMapScale.
+ *
+ * Sets how pushed observations are binned into the buckets of a column.
+ * The buckets span the range set with uber_heat_map_set_y_range(), or the
+ * edges set with uber_heat_map_set_bucket_edges() for
+ * %UBER_HEAT_MAP_SCALE_CUSTOM.  Values outside of the range are counted in
+ * the first or last bucket.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_scale (UberHeatMap      *map,   /* IN */
+                         UberHeatMapScale  scale) /* IN */
+{
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(scale <= UBER_HEAT_MAP_SCALE_CUSTOM);
+
+	map->priv->scale = scale;
+	uber_heat_map_update_buckets(map);
+}
+
+/**
+ * uber_heat_map_set_bucket_edges:
+ * @map: A #UberHeatMap.
+ * @edges: An ascending array of bucket edges.
+ * @n_edges: The number of elements in @edges.
+ *
+ * Sets custom bucket edges and switches to %UBER_HEAT_MAP_SCALE_CUSTOM.
+ * Bucket i holds the values between @edges[i] and @edges[i + 1].
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_bucket_edges (UberHeatMap   *map,     /* IN */
+                                const gdouble *edges,   /* IN */
+                                guint          n_edges) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(edges != NULL);
+	g_return_if_fail(n_edges > 1);
+
+	priv = map->priv;
+	g_free(priv->edges);
+	priv->edges = g_memdup(edges, sizeof(gdouble) * n_edges);
+	priv->n_edges = n_edges;
+	uber_heat_map_set_scale(map, UBER_HEAT_MAP_SCALE_CUSTOM);
+}
+
+/**
+ * uber_heat_map_set_n_buckets:
+ * @map: A #UberHeatMap.
+ * @n_buckets: The number of buckets.
+ *
+ * Sets the number of buckets pushed observations are binned into across
+ * the y range.  The buckets are spread across the rows of the heat map
+ * when rendering, so the count does not change with the size of the
+ * widget.  It is ignored for %UBER_HEAT_MAP_SCALE_CUSTOM, which has a
+ * bucket between each pair of edges.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_n_buckets (UberHeatMap *map,       /* IN */
+                             guint        n_buckets) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(n_buckets > 0);
+
+	priv = map->priv;
+	if (priv->bucket_count == n_buckets) {
+		return;
+	}
+	priv->bucket_count = n_buckets;
+	uber_heat_map_update_buckets(map);
+}
+
+/**
+ * uber_heat_map_set_palette:
+ * @map: A #UberHeatMap.
+ * @palette: An #UberHeatMapPalette.
+ *
+ * Sets the colors used for cell intensities.  The colors are looked up in
+ * a table which is built once for the palette.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_palette (UberHeatMap        *map,     /* IN */
+                           UberHeatMapPalette  palette) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(palette <= UBER_HEAT_MAP_PALETTE_CUSTOM);
+	g_return_if_fail(palette != UBER_HEAT_MAP_PALETTE_CUSTOM ||
+	                 map->priv->gradient != NULL);
+
+	priv = map->priv;
+	priv->palette = palette;
+	priv->lut_valid = FALSE;
+	priv->fg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_gradient:
+ * @map: A #UberHeatMap.
+ * @colors: The colors of the gradient, from lowest to highest intensity.
+ * @n_colors: The number of elements in @colors.
+ *
+ * Sets a custom gradient and switches to %UBER_HEAT_MAP_PALETTE_CUSTOM.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_gradient (UberHeatMap    *map,      /* IN */
+                            const GdkColor *colors,   /* IN */
+                            guint           n_colors) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(colors != NULL);
+	g_return_if_fail(n_colors > 0);
+
+	priv = map->priv;
+	g_free(priv->gradient);
+	priv->gradient = g_memdup(colors, sizeof(GdkColor) * n_colors);
+	priv->n_gradient = n_colors;
+	uber_heat_map_set_palette(map, UBER_HEAT_MAP_PALETTE_CUSTOM);
+}
+
+/**
+ * uber_heat_map_set_normalize:
+ * @map: A #UberHeatMap.
+ * @normalize: An #UberHeatMapNormalize.
+ *
+ * Sets how bucket counts are turned into intensities.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_normalize (UberHeatMap          *map,       /* IN */
+                             UberHeatMapNormalize  normalize) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(normalize <= UBER_HEAT_MAP_NORMALIZE_FIXED);
+
+	priv = map->priv;
+	priv->normalize = normalize;
+	priv->fg_dirty = TRUE;
+	priv->full_draw = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_max_value:
+ * @map: A #UberHeatMap.
+ * @max_value: The value shown at full intensity.
+ *
+ * Sets the value columns are scaled to in %UBER_HEAT_MAP_NORMALIZE_FIXED
+ * mode, such as 100 for a percentage.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_max_value (UberHeatMap *map,       /* IN */
+                             gdouble      max_value) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(max_value > 0.);
+
+	priv = map->priv;
+	priv->max_value = max_value;
+	priv->fg_dirty = TRUE;
+	priv->full_draw = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_row_groups:
+ * @map: A #UberHeatMap.
+ * @sizes: The number of buckets in each group, starting at the bottom.
+ * @n_sizes: The number of elements in @sizes.
+ *
+ * Groups adjacent buckets, such as the processors of each NUMA node.  A
+ * line is drawn between groups.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_row_groups (UberHeatMap *map,     /* IN */
+                              const guint *sizes,   /* IN */
+                              guint        n_sizes) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(sizes != NULL || !n_sizes);
+
+	priv = map->priv;
+	g_free(priv->row_groups);
+	priv->row_groups = g_memdup(sizes, sizeof(guint) * n_sizes);
+	priv->n_row_groups = n_sizes;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_set_zoom:
+ * @map: A #UberHeatMap.
+ * @level: The zoom level.
+ * @offset: The number of columns of @level to skip, counting back from the
+ *   newest.
+ *
+ * Sets which part of the history is shown.  Each column of level 0 is a
+ * tick of the heat map; each column of a higher level merges a pair of
+ * columns of the level below, so every level up shows twice as much
+ * history.  The levels are kept up to date as columns are appended, so
+ * zooming only switches to another level.  Dragging over the heat map
+ * zooms into the selected columns and a right click zooms out a level.
+ *
+ * If @offset is zero the newest columns are shown as they are appended.
+ * Otherwise the heat map stays on the same columns, and @offset grows as
+ * columns are appended to @level.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_zoom (UberHeatMap *map,    /* IN */
+                        guint        level,  /* IN */
+                        guint        offset) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	priv->zoom = MIN(level, N_LEVELS - 1);
+	priv->zoom_offset = offset;
+	/*
+	 * Show the columns of the new level.
 	 */
+	priv->agg = 0;
+	uber_heat_map_update_aggregation(map);
+	priv->fg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(map));
+}
+
+/**
+ * uber_heat_map_zoom_to_columns:
+ * @map: A #UberHeatMap.
+ * @first: The newest selected column.
+ * @last: The oldest selected column.
+ *
+ * Zooms into the shown columns from @first to @last.  The finest level is
+ * shown at which the selection is no more columns than fit the heat map
+ * and is still retained, starting at @first.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_zoom_to_columns (UberHeatMap *map,   /* IN */
+                               gint         first, /* IN */
+                               gint         last)  /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gint xcount;
+	gint ycount;
+	guint newest;
+	guint oldest;
+	guint begin;
+	guint end;
+	guint offset;
+	guint level;
+
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	xcount = MAX(1, xcount);
+	/*
+	 * Work out the selection in ticks.
+	 */
+	uber_heat_map_get_level_span(map, first, &newest, &oldest);
+	begin = uber_heat_map_get_level_tick(map, priv->zoom, newest);
+	uber_heat_map_get_level_span(map, last, &newest, &oldest);
+	end = uber_heat_map_get_level_tick(map, priv->zoom, oldest)
+	    + (1 << priv->zoom) - 1;
+	for (level = 0; level + 1 < N_LEVELS; level++) {
+		offset = uber_heat_map_get_level_offset(map, level, begin);
+		oldest = uber_heat_map_get_level_offset(map, level, end);
+		if (oldest - offset < (guint)xcount &&
+		    oldest < MIN(priv->levels[level]->len, priv->n_appended[level])) {
+			break;
+		}
+	}
+	uber_heat_map_set_zoom(map, level,
+	                       uber_heat_map_get_level_offset(map, level, begin));
+}
+
+/**
+ * uber_heat_map_set_aggregate:
+ * @map: A #UberHeatMap.
+ * @aggregate: An #UberHeatMapAggregate.
+ *
+ * Sets how the buckets of adjacent columns are merged when there are more
+ * columns than pixels to show them in, and into the levels of the history.
+ * Only columns appended from now on are merged with the new function into
+ * the levels above the first.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_aggregate (UberHeatMap          *map,       /* IN */
+                             UberHeatMapAggregate  aggregate) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(aggregate <= UBER_HEAT_MAP_AGGREGATE_MEAN);
+
+	priv = map->priv;
+	if (priv->aggregate == aggregate) {
+		return;
+	}
+	priv->aggregate = aggregate;
+	/*
+	 * Rebuild the aggregated columns with the new function.
+	 */
+	if (priv->agg > 1) {
+		priv->agg = 0;
+		uber_heat_map_update_aggregation(map);
+	}
 	priv->fg_dirty = TRUE;
-	priv->bg_dirty = TRUE;
 	gtk_widget_queue_draw(GTK_WIDGET(map));
 }
 
 /**
- * uber_heat_map_set_y_range:
+ * uber_heat_map_push_many:
+ * @map: A #UberHeatMap.
+ * @values: An array of observations.
+ * @n_values: The number of elements in @values.
+ *
+ * Counts @values in the buckets of the column being collected.  The column
+ * is appended on the next tick of the heat map.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_push_many (UberHeatMap   *map,      /* IN */
+                         const gdouble *values,   /* IN */
+                         guint          n_values) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	const gdouble *edges;
+	gdouble last;
+	gdouble s;
+	gdouble o;
+	guint base;
+	guint half;
+	guint n;
+	guint i;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(values != NULL || n_values == 0);
+
+	priv = map->priv;
+	if (!priv->n_buckets) {
+		return;
+	}
+	last = priv->n_buckets - 1;
+	s = priv->bucket_scale;
+	o = priv->bucket_offset;
+	/*
+	 * fmin()/fmax() clamp without branching and map NaN to the first
+	 * bucket.
+	 */
+	switch (priv->scale) {
+	case UBER_HEAT_MAP_SCALE_LINEAR:
+		for (i = 0; i < n_values; i++) {
+			priv->counts[(guint)fmin(fmax(values[i] * s + o, 0.), last)] += 1.;
+		}
+		break;
+	case UBER_HEAT_MAP_SCALE_LOG2:
+	case UBER_HEAT_MAP_SCALE_LOG10:
+		for (i = 0; i < n_values; i++) {
+			priv->counts[(guint)fmin(fmax(log2(values[i]) * s + o, 0.), last)] += 1.;
+		}
+		break;
+	case UBER_HEAT_MAP_SCALE_CUSTOM:
+		/*
+		 * Binary search for the last edge not above the value.  The step
+		 * is added with a multiply rather than a branch.
+		 */
+		edges = priv->edges;
+		for (i = 0; i < n_values; i++) {
+			base = 0;
+			for (n = priv->n_buckets; n > 1; n -= half) {
+				half = n / 2;
+				base += (edges[base + half] <= values[i]) * half;
+			}
+			priv->counts[base] += 1.;
+		}
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+/**
+ * uber_heat_map_set_column:
+ * @map: A #UberHeatMap.
+ * @values: The value of each bucket, starting at the bottom.
+ * @n_values: The number of elements in @values.
+ *
+ * Sets the buckets of the column being collected to @values rather than
+ * counting observations in them.  This suits heat maps whose rows are not
+ * ranges of values, such as one bucket per processor; see
+ * uber_heat_map_set_n_buckets().  Buckets past @n_values are cleared.  The
+ * column is appended on the next tick of the heat map.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_column (UberHeatMap   *map,      /* IN */
+                          const gdouble *values,   /* IN */
+                          guint          n_values) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(values != NULL || !n_values);
+
+	priv = map->priv;
+	n_values = MIN(n_values, priv->n_buckets);
+	if (n_values) {
+		memcpy(priv->counts, values, sizeof(gdouble) * n_values);
+	}
+	if (n_values < priv->n_buckets) {
+		memset(priv->counts + n_values, 0,
+		       sizeof(gdouble) * (priv->n_buckets - n_values));
+	}
+}
+
+/**
+ * uber_heat_map_push:
+ * @map: A #UberHeatMap.
+ * @value: An observation.
+ *
+ * Counts @value in its bucket of the column being collected.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_push (UberHeatMap *map,   /* IN */
+                    gdouble      value) /* IN */
+{
+	uber_heat_map_push_many(map, &value, 1);
+}
+
+/**
+ * uber_heat_map_take_column:
+ * @map: A #UberHeatMap.
+ *
+ * Finishes the column being collected from pushed observations.  The array
+ * of the last column evicted from the history is reused if there is one,
+ * so a full heat map appends columns without allocating.
+ *
+ * Returns: A #GArray of bucket counts.
+ * Side effects: The bucket counts are reset.
+ */
+static GArray*
+uber_heat_map_take_column (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	GArray *values;
+
+	if (priv->spare) {
+		values = priv->spare;
+		priv->spare = NULL;
+		g_array_set_size(values, 0);
+	} else {
+		values = g_array_sized_new(FALSE, FALSE, sizeof(gdouble),
+		                           priv->n_buckets);
+	}
+	if (priv->n_buckets) {
+		g_array_append_vals(values, priv->counts, priv->n_buckets);
+		memset(priv->counts, 0, sizeof(gdouble) * priv->n_buckets);
+	}
+	return values;
+}
+
+/**
+ * uber_heat_map_update_global_max:
+ * @map: A #UberHeatMap.
+ *
+ * Recalculates the largest value of the shown columns.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_global_max (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	GRing *shown = uber_heat_map_get_shown(map);
+	Column *col;
+	gint i;
+
+	priv->global_max = 0.;
+	for (i = 0; i < shown->len; i++) {
+		col = &g_ring_get_index(shown, Column, i);
+		priv->global_max = MAX(priv->global_max, col->max);
+	}
+}
+
+/**
+ * uber_heat_map_update_column:
+ * @column: A column.
+ * @prev: The column before @column within its ring.
+ *
+ * Recalculates the largest value of @column and the running maximum it is
+ * normalized to in %UBER_HEAT_MAP_NORMALIZE_DECAY mode.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_column (Column *column, /* IN */
+                             Column *prev)   /* IN */
+{
+	gint i;
+
+	column->max = 0.;
+	for (i = 0; i < column->values->len; i++) {
+		column->max = MAX(column->max, g_array_index(column->values, gdouble, i));
+	}
+	column->norm = MAX(column->max, prev->norm * NORMALIZE_DECAY);
+}
+
+/**
+ * uber_heat_map_show_column:
+ * @map: A #UberHeatMap.
+ * @column: A column.
+ *
+ * Appends @column to the ring of shown columns.  If the global maximum
+ * changes while it is in use, the whole foreground is redrawn.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_show_column (UberHeatMap *map,    /* IN */
+                           Column      *column) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	GRing *shown = uber_heat_map_get_shown(map);
+	Column *oldest;
+	gdouble global_max;
+	gboolean evict_max;
+
+	oldest = &g_ring_get_index(shown, Column, shown->len - 1);
+	evict_max = (oldest->values && oldest->max >= priv->global_max);
+	global_max = priv->global_max;
+	g_ring_append_val(shown, *column);
+	if (evict_max) {
+		uber_heat_map_update_global_max(map);
+	} else {
+		priv->global_max = MAX(priv->global_max, column->max);
+	}
+	if (priv->normalize == UBER_HEAT_MAP_NORMALIZE_GLOBAL &&
+	    priv->global_max != global_max) {
+		priv->full_draw = TRUE;
+	}
+	priv->pending++;
+}
+
+/**
+ * uber_heat_map_merge_column:
+ * @map: A #UberHeatMap.
+ * @dst: An aggregated column.
+ * @src: The column to merge into @dst.
+ *
+ * Merges the buckets of @src into @dst using the aggregate function of
+ * @map.  @dst already holds priv->view_fill columns.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_merge_column (UberHeatMap *map, /* IN */
+                            Column      *dst, /* IN */
+                            Column      *src) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gdouble *d;
+	gdouble *s;
+	gdouble n;
+	gint i;
+
+	if (dst->values->len < src->values->len) {
+		g_array_set_size(dst->values, src->values->len);
+	}
+	d = (gdouble *)dst->values->data;
+	s = (gdouble *)src->values->data;
+	n = priv->view_fill + 1;
+	switch (priv->aggregate) {
+	case UBER_HEAT_MAP_AGGREGATE_SUM:
+		for (i = 0; i < src->values->len; i++) {
+			d[i] += s[i];
+		}
+		break;
+	case UBER_HEAT_MAP_AGGREGATE_MAX:
+		for (i = 0; i < src->values->len; i++) {
+			d[i] = MAX(d[i], s[i]);
+		}
+		break;
+	case UBER_HEAT_MAP_AGGREGATE_MEAN:
+		for (i = 0; i < dst->values->len; i++) {
+			d[i] += ((i < src->values->len ? s[i] : 0.) - d[i]) / n;
+		}
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+/**
+ * uber_heat_map_view_append:
+ * @map: A #UberHeatMap.
+ * @column: A column appended to the history.
+ *
+ * Adds @column to the ring of aggregated columns.  A new aggregated column
+ * is started for every priv->agg columns; otherwise @column is merged
+ * into the newest one, which is then redrawn in place.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_view_append (UberHeatMap *map,    /* IN */
+                           Column      *column) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	Column view = { NULL, 0., 0. };
+	Column *newest;
+	gdouble global_max;
+	gdouble max;
+
+	newest = &g_ring_get_index(priv->view, Column, 0);
+	if (!priv->view_fill || priv->view_fill >= priv->agg) {
+		view.values = g_array_sized_new(FALSE, FALSE, sizeof(gdouble),
+		                                column->values->len);
+		g_array_append_vals(view.values, column->values->data,
+		                    column->values->len);
+		uber_heat_map_update_column(&view, newest);
+		uber_heat_map_show_column(map, &view);
+		priv->view_fill = 1;
+		return;
+	}
+	max = newest->max;
+	global_max = priv->global_max;
+	uber_heat_map_merge_column(map, newest, column);
+	uber_heat_map_update_column(newest,
+	                            &g_ring_get_index(priv->view, Column, 1));
+	priv->view_fill++;
+	if (max >= priv->global_max && newest->max < max) {
+		uber_heat_map_update_global_max(map);
+	} else {
+		priv->global_max = MAX(priv->global_max, newest->max);
+	}
+	if (priv->normalize == UBER_HEAT_MAP_NORMALIZE_GLOBAL &&
+	    priv->global_max != global_max) {
+		priv->full_draw = TRUE;
+	}
+	priv->refresh = TRUE;
+}
+
+/**
+ * uber_heat_map_merge_pair:
+ * @map: A #UberHeatMap.
+ * @older: A column.
+ * @newer: The column appended after @older.
+ * @values: An array to reuse for the merged column or %NULL.
+ *
+ * Merges two adjacent columns of a level into a column of the next level
+ * using the aggregate function of @map.
+ *
+ * Returns: The values of the merged column.
+ * Side effects: None.
+ */
+static GArray*
+uber_heat_map_merge_pair (UberHeatMap *map,    /* IN */
+                          Column      *older,  /* IN */
+                          Column      *newer,  /* IN */
+                          GArray      *values) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	gdouble *d;
+	gdouble a;
+	gdouble b;
+	guint len;
+	guint i;
+
+	len = MAX(older->values->len, newer->values->len);
+	if (!values) {
+		values = g_array_sized_new(FALSE, TRUE, sizeof(gdouble), len);
+	}
+	g_array_set_size(values, len);
+	d = (gdouble *)values->data;
+	for (i = 0; i < len; i++) {
+		a = (i < older->values->len) ? g_array_index(older->values, gdouble, i) : 0.;
+		b = (i < newer->values->len) ? g_array_index(newer->values, gdouble, i) : 0.;
+		switch (priv->aggregate) {
+		case UBER_HEAT_MAP_AGGREGATE_SUM:
+			d[i] = a + b;
+			break;
+		case UBER_HEAT_MAP_AGGREGATE_MAX:
+			d[i] = MAX(a, b);
+			break;
+		case UBER_HEAT_MAP_AGGREGATE_MEAN:
+			d[i] = (a + b) / 2.;
+			break;
+		default:
+			g_assert_not_reached();
+		}
+	}
+	return values;
+}
+
+/**
+ * uber_heat_map_append_level:
  * @map: A #UberHeatMap.
- * @x_range: An #UberRange.
+ * @level: The level of the history.
+ * @column: A column.
  *
- * Sets the range of valid inputs for the X axis.  Values outside of this range
- * will not show up on the heat map.
+ * Adds @column to a level of the history.  If it is the shown level, the
+ * column is also shown.  Every second column of a level completes a pair,
+ * which is merged and added to the next level.
  *
  * Returns: None.
  * Side effects: None.
  */
-void
-uber_heat_map_set_y_range (UberHeatMap     *map,     /* IN */
-                           const UberRange *x_range) /* IN */
+static void
+uber_heat_map_append_level (UberHeatMap *map,    /* IN */
+                            guint        level,  /* IN */
+                            Column      *column) /* IN */
 {
-	UberHeatMapPrivate *priv;
-
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(x_range != NULL);
-
-	priv = map->priv;
-	/*
-	 * Store and recalculate range.
-	 */
-	priv->x_range = *x_range;
-	priv->x_range.range = priv->x_range.end - priv->x_range.begin;
-	/*
-	 * Force full draw of entire widget.
-	 */
-	priv->fg_dirty = TRUE;
-	priv->bg_dirty = TRUE;
-	gtk_widget_queue_draw(GTK_WIDGET(map));
+	UberHeatMapPrivate *priv = map->priv;
+	GRing *ring = priv->levels[level];
+	Column merged = { NULL, 0., 0. };
+	Column *oldest;
+
+	uber_heat_map_update_column(column, &g_ring_get_index(ring, Column, 0));
+	if (level == priv->zoom && priv->agg == 1) {
+		uber_heat_map_show_column(map, column);
+	} else {
+		g_ring_append_val(ring, *column);
+		if (level == priv->zoom) {
+			uber_heat_map_view_append(map, column);
+		}
+	}
+	if (level == priv->zoom && priv->zoom_offset) {
+		/*
+		 * Zoomed into the past.  Stay on the same columns rather than
+		 * scrolling; they are only redrawn once they start to fall out of
+		 * the history.
+		 */
+		priv->zoom_offset++;
+		priv->pending = 0;
+		priv->refresh = FALSE;
+		if (uber_heat_map_get_view_index(map, priv->strip_slots - 1) >=
+		    uber_heat_map_get_shown(map)->len) {
+			priv->full_draw = TRUE;
+		}
+	}
+	priv->n_appended[level]++;
+	if (level + 1 < N_LEVELS && !(priv->n_appended[level] % 2)) {
+		/*
+		 * Reuse the array of the column the merged one evicts.  It is
+		 * released by the ring as the merged column is appended.
+		 */
+		oldest = &g_ring_get_index(priv->levels[level + 1], Column,
+		                           priv->levels[level + 1]->len - 1);
+		if (oldest->values) {
+			merged.values = g_array_ref(oldest->values);
+		}
+		merged.values = uber_heat_map_merge_pair(map,
+		                                         &g_ring_get_index(ring, Column, 1),
+		                                         &g_ring_get_index(ring, Column, 0),
+		                                         merged.values);
+		uber_heat_map_append_level(map, level + 1, &merged);
+	}
 }
 
 /**
- * uber_heat_map_set_block_size:
+ * uber_heat_map_append:
  * @map: A #UberHeatMap.
+ * @values: (element-type double): A #GAarray.
  *
- * XXX
+ * Adds the column of raw values to the history.  Each level of the history
+ * holds as many columns as the first, but each column merges a pair of the
+ * level below, so zooming out only switches to another level rather than
+ * binning the columns again.  The content area is invalidated by the
+ * frame clock.
  *
  * Returns: None.
  * Side effects: None.
  */
-void
-uber_heat_map_set_block_size (UberHeatMap *map,             /* IN */
-                              gint         width,           /* IN */
-                              gboolean     width_is_count,  /* IN */
-                              gint         height,          /* IN */
-                              gboolean     height_is_count) /* IN */
+static void
+uber_heat_map_append (UberHeatMap *map,    /* IN */
+                      GArray      *values) /* IN */
 {
 	UberHeatMapPrivate *priv;
-	GtkAllocation alloc;
+	Column column = { values, 0., 0. };
+	Column *oldest;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(map));
-	g_return_if_fail(width > 0);
-	g_return_if_fail(height > 0);
+	g_return_if_fail(values != NULL);
 
 	priv = map->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(map), &alloc);
-	/*
-	 * Store new width/height block size settings.
-	 */
-	priv->width_block_size = width;
-	priv->width_is_count = width_is_count;
-	priv->height_block_size = height;
-	priv->height_is_count = height_is_count;
 	/*
-	 * Recalculate the real block sizes.
+	 * Keep the array of the column about to be evicted for the next one.
 	 */
-	if (width_is_count) {
-		priv->cur_block_width = (priv->content_rect.width - 2) / (gdouble)width;
-	} else {
-		priv->cur_block_width = width;
-		priv->col_count = width;
-	}
-	if (height_is_count) {
-		priv->cur_block_height = (priv->content_rect.height - 2) / (gdouble)height;
-	} else {
-		priv->cur_block_height = height;
-		priv->row_count = height;
+	oldest = &g_ring_get_index(priv->levels[0], Column,
+	                           priv->levels[0]->len - 1);
+	if (oldest->values && !priv->spare) {
+		priv->spare = g_array_ref(oldest->values);
 	}
-	/*
-	 * TODO: Recalculate buckets.
-	 */
-	/*
-	 * Force full draw of entire widget.
-	 */
+	uber_heat_map_append_level(map, 0, &column);
 	priv->fg_dirty = TRUE;
-	priv->bg_dirty = TRUE;
-	gtk_widget_queue_draw(GTK_WIDGET(map));
 }
 
 /**
- * uber_heat_map_append:
- * @map: A #UberHeatMap.
- * @values: (element-type double): A #GAarray.
+ * uber_heat_map_free_ring:
+ * @ring: A #GRing of columns.
  *
- * Adds the set of values to the circular buffer.  The values are
- * calculated and inserted into the proper buckets.
+ * Frees the values of the columns in @ring and then @ring itself.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_append (UberHeatMap *map,    /* IN */
-                      GArray      *values) /* IN */
+uber_heat_map_free_ring (GRing *ring) /* IN */
 {
-	UberHeatMapPrivate *priv;
+	gint i;
 
-	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	for (i = 0; i < ring->len; i++) {
+		uber_heat_map_destroy_column(&g_ring_get_index(ring, Column, i));
+	}
+	g_ring_unref(ring);
+}
 
-	priv = map->priv;
-	g_ring_append_val(priv->ring, values);
-	priv->fg_dirty = TRUE;
-	gtk_widget_queue_draw_area(GTK_WIDGET(map),
-	                           priv->content_rect.x,
-	                           priv->content_rect.y,
-	                           priv->content_rect.width,
-	                           priv->content_rect.height);
+/**
+ * uber_heat_map_update_aggregation:
+ * @map: A #UberHeatMap.
+ *
+ * Recalculates how many columns are merged into each shown column after
+ * the block layout changed.  Columns are aggregated when there are more of
+ * them than pixels in the content area, so a full render never draws more
+ * columns than the content area is wide.  The history grows to hold every
+ * column and the aggregated columns are rebuilt from the zoom level.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_aggregation (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv = map->priv;
+	GRing *ring;
+	Column *col;
+	gint xcount;
+	gint ycount;
+	gint width;
+	gint agg = 1;
+	gint n_view;
+	gint level;
+	gint i;
+
+	uber_heat_map_get_counts(map, &xcount, &ycount);
+	xcount = MAX(1, xcount);
+	width = priv->content_rect.width - 2;
+	if (width > 0 && xcount > width) {
+		agg = (xcount + width - 1) / width;
+	}
+	n_view = (xcount + agg - 1) / agg;
+	/*
+	 * Grow each level of the history to hold every column, oldest first.
+	 */
+	for (level = 0; level < N_LEVELS; level++) {
+		if (priv->levels[level]->len >= xcount) {
+			continue;
+		}
+		ring = g_ring_sized_new(sizeof(Column), xcount,
+		                        uber_heat_map_destroy_column);
+		for (i = priv->levels[level]->len - 1; i >= 0; i--) {
+			col = &g_ring_get_index(priv->levels[level], Column, i);
+			if (col->values) {
+				g_ring_append_val(ring, *col);
+				col->values = NULL;
+			}
+		}
+		g_ring_unref(priv->levels[level]);
+		priv->levels[level] = ring;
+	}
+	if (agg == priv->agg && (agg == 1 || priv->view->len == n_view)) {
+		return;
+	}
+	/*
+	 * Rebuild the aggregated columns from the history.
+	 */
+	if (priv->view) {
+		uber_heat_map_free_ring(priv->view);
+		priv->view = NULL;
+	}
+	priv->agg = agg;
+	priv->view_fill = 0;
+	if (agg > 1) {
+		priv->view = g_ring_sized_new(sizeof(Column), n_view,
+		                              uber_heat_map_destroy_column);
+		ring = priv->levels[priv->zoom];
+		for (i = ring->len - 1; i >= 0; i--) {
+			col = &g_ring_get_index(ring, Column, i);
+			if (col->values) {
+				uber_heat_map_view_append(map, col);
+			}
+		}
+	}
+	uber_heat_map_update_global_max(map);
+	priv->pending = 0;
+	priv->refresh = FALSE;
+	priv->full_draw = TRUE;
 }
 
 /**
  * uber_heat_map_fps_timeout:
- * @map: A #UberHeatMap.
+ * @widget: A #UberHeatMap.
+ * @damage: A location for the area to invalidate.
+ * @user_data: Unused.
  *
- * Timeout to tick the graph to the next frame.
+ * #UberFrameFunc to tick the graph to the next frame.
  *
- * Returns: %TRUE always.
+ * Returns: %TRUE if the content area should be redrawn; otherwise %FALSE.
  * Side effects: None.
  */
 static gboolean
-uber_heat_map_fps_timeout (UberHeatMap *map) /* IN */
+uber_heat_map_fps_timeout (GtkWidget    *widget,    /* IN */
+                           GdkRectangle *damage,    /* OUT */
+                           gpointer      user_data) /* IN */
 {
 	UberHeatMapPrivate *priv;
+	UberHeatMap *map = UBER_HEAT_MAP(widget);
 	GArray *values = NULL;
+	gint64 now;
 
 	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), FALSE);
 
 	priv = map->priv;
-	priv->fps_off++;
-	if (G_UNLIKELY(priv->fps_off >= priv->fps_calc)) {
-		if (!uber_heat_map_get_next_values(map, &values)) {
-			values = NULL;
+	now = g_get_monotonic_time();
+	if (G_UNLIKELY(now - priv->dp_time >= COLUMN_USEC)) {
+		if (!uber_heat_map_get_next_values(map, &values) || !values) {
+			values = uber_heat_map_take_column(map);
 		}
 		uber_heat_map_append(map, values);
-		priv->fps_off = 0;
+		/*
+		 * Advance by whole columns so that a late tick does not drift from
+		 * wall-clock time, unless we have fallen a full column behind.
+		 */
+		priv->dp_time += COLUMN_USEC;
+		if (now - priv->dp_time >= COLUMN_USEC) {
+			priv->dp_time = now;
+		}
+		/*
+		 * While hidden, only collect the values.  A full render happens
+		 * once the heat map is viewable again.
+		 */
+		if (!uber_heat_map_get_viewable(map)) {
+			priv->full_draw = TRUE;
+			return FALSE;
+		}
+		if (priv->in_hover) {
+			uber_heat_map_update_tooltip(map);
+		}
+		*damage = priv->content_rect;
+		return TRUE;
 	}
-	return TRUE;
+	return FALSE;
 }
 
 /**
@@ -1001,9 +3051,6 @@ uber_heat_map_set_fps (UberHeatMap *map, /* IN */
 	priv->fps_each = (gfloat)priv->content_rect.width /
 	                 (gfloat)priv->stride /
 	                 (gfloat)priv->fps;
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-	}
 	/*
 	 * If we are moving less than one pixel per frame, then go ahead and lower
 	 * the actual framerate and move 1 pixel at a time.
@@ -1011,11 +3058,19 @@ uber_heat_map_set_fps (UberHeatMap *map, /* IN */
 	if (priv->fps_each < 1.) {
 		priv->fps_each = 1.;
 		priv->fps_calc = (gfloat)priv->content_rect.width / (gfloat)priv->stride;
-		priv->fps_to = 1000. / priv->fps_calc;
+		priv->fps_to = 1000. / MAX(1, priv->fps_calc);
+	}
+	/*
+	 * Ticks come from the shared frame clock.
+	 */
+	if (priv->fps_handler) {
+		uber_frame_clock_set_fps(priv->fps_handler, priv->fps_calc);
+	} else {
+		priv->fps_handler = uber_frame_clock_add(GTK_WIDGET(map),
+		                                         priv->fps_calc,
+		                                         uber_heat_map_fps_timeout,
+		                                         NULL);
 	}
-	priv->fps_handler = g_timeout_add(priv->fps_to,
-	                                  (GSourceFunc)uber_heat_map_fps_timeout,
-	                                  map);
 }
 
 /**
@@ -1038,6 +3093,64 @@ uber_heat_map_realize (GtkWidget *widget) /* IN */
 	WIDGET->realize(widget);
 }
 
+/**
+ * uber_heat_map_style_set:
+ * @widget: A #UberHeatMap.
+ * @old_style: The previous #GtkStyle or %NULL.
+ *
+ * Handles the "style-set" event.  The background and the default palette
+ * follow the style, so both are rebuilt.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_style_set (GtkWidget *widget,    /* IN */
+                         GtkStyle  *old_style) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(widget));
+
+	priv = UBER_HEAT_MAP(widget)->priv;
+	WIDGET->style_set(widget, old_style);
+	priv->lut_valid = FALSE;
+	priv->bg_dirty = TRUE;
+	priv->fg_dirty = TRUE;
+	gtk_widget_queue_draw(widget);
+}
+
+/**
+ * uber_heat_map_viewable_changed:
+ * @widget: A #UberHeatMap.
+ * @viewable: If the heat map can now be seen.
+ * @user_data: Unused.
+ *
+ * #UberViewableFunc called when the heat map becomes viewable or stops
+ * being viewable.  If the heat map just became viewable, the contents are
+ * fully redrawn to catch up with values collected while hidden.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_viewable_changed (GtkWidget *widget,    /* IN */
+                                gboolean   viewable,  /* IN */
+                                gpointer   user_data) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(widget));
+
+	priv = UBER_HEAT_MAP(widget)->priv;
+	priv->viewable = viewable;
+	if (viewable) {
+		priv->fg_dirty = TRUE;
+		priv->full_draw = TRUE;
+		gtk_widget_queue_draw(widget);
+	}
+}
+
 /**
  * uber_heat_map_size_allocate:
  * @map: A #UberHeatMap.
@@ -1062,19 +3175,11 @@ uber_heat_map_size_allocate (GtkWidget     *widget, /* IN */
 	 */
 	uber_heat_map_calculate_rects(UBER_HEAT_MAP(widget));
 	/*
-	 * Destroy existing textures.
-	 */
-	uber_heat_map_destroy_texture(UBER_HEAT_MAP(widget),
-	                              &priv->textures[0]);
-	uber_heat_map_destroy_texture(UBER_HEAT_MAP(widget),
-	                              &priv->textures[1]);
-	/*
-	 * Initialize new textures.
+	 * Recreate the background texture.  The column strip is recreated on
+	 * the next render if the block layout changed.
 	 */
-	uber_heat_map_init_texture(UBER_HEAT_MAP(widget),
-	                           &priv->textures[0]);
-	uber_heat_map_init_texture(UBER_HEAT_MAP(widget),
-	                           &priv->textures[1]);
+	uber_heat_map_destroy_texture(UBER_HEAT_MAP(widget));
+	uber_heat_map_init_texture(UBER_HEAT_MAP(widget));
 	/*
 	 * Update how we draw blocks based on the configured settings.
 	 */
@@ -1115,9 +3220,7 @@ uber_heat_map_enter_notify_event (GtkWidget        *widget,   /* IN */
 
 	priv = UBER_HEAT_MAP(widget)->priv;
 	priv->in_hover = TRUE;
-	gdk_window_invalidate_rect(gtk_widget_get_window(widget),
-	                           &priv->content_rect,
-	                           FALSE);
+	uber_heat_map_invalidate_active(UBER_HEAT_MAP(widget));
 	return FALSE;
 }
 
@@ -1141,9 +3244,9 @@ uber_heat_map_leave_notify_event (GtkWidget        *widget,   /* IN */
 
 	priv = UBER_HEAT_MAP(widget)->priv;
 	priv->in_hover = FALSE;
-	gdk_window_invalidate_rect(gtk_widget_get_window(widget),
-	                           &priv->content_rect,
-	                           FALSE);
+	uber_heat_map_invalidate_active(UBER_HEAT_MAP(widget));
+	priv->active_column = -1;
+	priv->active_row = -1;
 	return FALSE;
 }
 
@@ -1153,7 +3256,7 @@ uber_heat_map_leave_notify_event (GtkWidget        *widget,   /* IN */
  * @motion: A #GdkEventMotion.
  *
  * Handles the motion event within the widget.  This is used to determine
- * the currently hovered block that is active.
+ * the currently hovered cell that is active.
  *
  * Returns: %FALSE always.
  * Side effects: None.
@@ -1162,59 +3265,133 @@ static gboolean
 uber_heat_map_motion_notify_event (GtkWidget      *widget, /* IN */
                                    GdkEventMotion *motion) /* IN */
 {
+	UberHeatMap *map = (UberHeatMap *)widget;
 	UberHeatMapPrivate *priv;
-	gdouble x_offset;
-	gdouble y_offset;
-	gint active_column = -1;
-	gint active_row = -1;
-	gchar *tooltip;
+	gint active_column;
+	gint active_row;
 
 	g_return_val_if_fail(UBER_IS_HEAT_MAP(widget), FALSE);
 
-	priv = UBER_HEAT_MAP(widget)->priv;
-	/*
-	 * Check if we are hovering a box in the view.
-	 */
-	if (GDK_RECTANGLE_CONTAINS(priv->content_rect, motion->x, motion->y)) {
-		/*
-		 * Get relative coordinate within the content area.
-		 */
-		x_offset = motion->x - priv->content_rect.x;
-		y_offset = motion->y - priv->content_rect.y;
-		/*
-		 * Set the active row and column.
-		 */
-		active_column = x_offset / priv->cur_block_width;
-		active_row = y_offset / priv->cur_block_height;
+	priv = map->priv;
+	if (priv->dragging) {
+		uber_heat_map_invalidate_drag(map);
+		priv->drag_end = uber_heat_map_clamp_x(map, motion->x);
+		uber_heat_map_invalidate_drag(map);
 	}
+	uber_heat_map_hit_test(map, motion->x, motion->y,
+	                       &active_column, &active_row);
 	/*
-	 * Update the highlight box if necessary.
+	 * Only the cells losing and gaining the highlight are redrawn.
 	 */
 	if ((active_column != priv->active_column) ||
 	    (active_row != priv->active_row)) {
-	    if (active_column > -1 && active_row > -1) {
-			/*
-			 * TODO: Add format callback to determine tooltip contents.
-			 */
-			tooltip = g_strdup_printf("Row %d\nColumn %d", active_row, active_column);
-			gtk_widget_set_tooltip_text(widget, tooltip);
-			g_free(tooltip);
-		} else {
-			gtk_widget_set_tooltip_text(widget, "");
+		uber_heat_map_invalidate_active(map);
+		priv->active_column = active_column;
+		priv->active_row = active_row;
+		uber_heat_map_invalidate_active(map);
+		uber_heat_map_update_tooltip(map);
+	}
+	return FALSE;
+}
+
+/**
+ * uber_heat_map_button_press_event:
+ * @widget: A #GtkWidget.
+ * @button: A #GdkEventButton.
+ *
+ * Starts selecting a range of columns to zoom into with the first button,
+ * or zooms out a level with the third.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_button_press_event (GtkWidget      *widget, /* IN */
+                                  GdkEventButton *button) /* IN */
+{
+	UberHeatMap *map = (UberHeatMap *)widget;
+	UberHeatMapPrivate *priv;
+	guint tick;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(widget), FALSE);
+
+	priv = map->priv;
+	if (!GDK_RECTANGLE_CONTAINS(priv->content_rect, button->x, button->y)) {
+		return FALSE;
+	}
+	switch (button->button) {
+	case 1:
+		priv->dragging = TRUE;
+		priv->drag_begin = uber_heat_map_clamp_x(map, button->x);
+		priv->drag_end = priv->drag_begin;
+		uber_heat_map_invalidate_drag(map);
+		break;
+	case 3:
+		if (priv->zoom + 1 < N_LEVELS) {
+			tick = uber_heat_map_get_level_tick(map, priv->zoom,
+			                                    priv->zoom_offset);
+			uber_heat_map_set_zoom(map, priv->zoom + 1,
+			                       uber_heat_map_get_level_offset(map, priv->zoom + 1,
+			                                                      tick));
 		}
-		gdk_window_invalidate_rect(gtk_widget_get_window(widget),
-		                           &priv->content_rect, FALSE);
+		break;
+	default:
+		break;
+	}
+	return FALSE;
+}
+
+/**
+ * uber_heat_map_button_release_event:
+ * @widget: A #GtkWidget.
+ * @button: A #GdkEventButton.
+ *
+ * Zooms into the columns selected since the first button was pressed.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_heat_map_button_release_event (GtkWidget      *widget, /* IN */
+                                    GdkEventButton *button) /* IN */
+{
+	UberHeatMap *map = (UberHeatMap *)widget;
+	UberHeatMapPrivate *priv;
+	gdouble y;
+	gint first;
+	gint last;
+	gint row;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(widget), FALSE);
+
+	priv = map->priv;
+	if (button->button != 1 || !priv->dragging) {
+		return FALSE;
+	}
+	uber_heat_map_invalidate_drag(map);
+	priv->dragging = FALSE;
+	priv->drag_end = uber_heat_map_clamp_x(map, button->x);
+	/*
+	 * Columns are laid out from the right, so the right edge of the
+	 * selection is the newest column.
+	 */
+	y = priv->content_rect.y + priv->content_rect.height / 2;
+	if (uber_heat_map_hit_test(map, MAX(priv->drag_begin, priv->drag_end),
+	                           y, &first, &row) &&
+	    uber_heat_map_hit_test(map, MIN(priv->drag_begin, priv->drag_end),
+	                           y, &last, &row)) {
+		uber_heat_map_zoom_to_columns(map, first, MAX(first, last));
 	}
-	priv->active_column = active_column;
-	priv->active_row = active_row;
 	return FALSE;
 }
 
 /**
  * uber_heat_map_size_request:
  * @widget: A #GtkWidget.
+ * @req: A #GtkRequisition.
  *
- * XXX
+ * Requests the default size of the heat map, or enough height for a pixel
+ * per row if the number of rows is fixed.
  *
  * Returns: None.
  * Side effects: None.
@@ -1224,33 +3401,84 @@ uber_heat_map_size_request (GtkWidget      *widget, /* IN */
                             GtkRequisition *req)    /* OUT */
 {
 	UberHeatMapPrivate *priv;
+	PangoLayout *layout;
+	PangoFontDescription *font_desc;
+	gint label_height;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(widget));
 
 	priv = UBER_HEAT_MAP(widget)->priv;
 	req->width = 150;
 	req->height = 50;
+	if (!priv->height_is_count) {
+		return;
+	}
+	/*
+	 * Leave at least a pixel for each row, besides the labels and ticks
+	 * around the content area; see uber_heat_map_calculate_rects().
+	 */
+	layout = gtk_widget_create_pango_layout(widget, "XXXXXXXX");
+	font_desc = pango_font_description_new();
+	pango_font_description_set_family_static(font_desc, "Monospace");
+	pango_font_description_set_size(font_desc, PANGO_SCALE * 8);
+	pango_layout_set_font_description(layout, font_desc);
+	pango_layout_get_pixel_size(layout, NULL, &label_height);
+	pango_font_description_free(font_desc);
+	g_object_unref(layout);
+	req->height = MAX(req->height,
+	                  priv->height_block_size
+	                  + 2
+	                  + 1 + (label_height / 2)
+	                  + priv->tick_len
+	                  + 3
+	                  + label_height);
 }
 
 /**
- * uber_heat_map_destroy_array:
- * @data: A pointer to a #GArray.
+ * uber_heat_map_destroy_column:
+ * @data: A pointer to a Column.
  *
- * Frees a GArray after it has been released from the #GRing.
+ * Frees the values of a column after it has been released from the #GRing.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_destroy_array (gpointer data) /* IN */
+uber_heat_map_destroy_column (gpointer data) /* IN */
 {
-	GArray **ar = data;
+	Column *col = data;
 
 	g_return_if_fail(data != NULL);
 
-	if (*ar) {
-		g_array_unref(*ar);
+	if (col->values) {
+		g_array_unref(col->values);
+		col->values = NULL;
+	}
+}
+
+/**
+ * uber_heat_map_dispose:
+ * @object: A #UberHeatMap.
+ *
+ * Unregisters the widget from the frame clock so that no frame runs while
+ * it is being destroyed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_dispose (GObject *object) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(object));
+
+	priv = UBER_HEAT_MAP(object)->priv;
+	if (priv->fps_handler) {
+		uber_frame_clock_remove(priv->fps_handler);
+		priv->fps_handler = 0;
 	}
+	G_OBJECT_CLASS(uber_heat_map_parent_class)->dispose(object);
 }
 
 /**
@@ -1267,17 +3495,29 @@ static void
 uber_heat_map_finalize (GObject *object) /* IN */
 {
 	UberHeatMapPrivate *priv;
+	gint i;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(object));
 
 	priv = UBER_HEAT_MAP(object)->priv;
-	uber_heat_map_destroy_texture(UBER_HEAT_MAP(object),
-	                              &priv->textures[priv->flipped]);
-	uber_heat_map_destroy_texture(UBER_HEAT_MAP(object),
-	                              &priv->textures[!priv->flipped]);
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
+	uber_heat_map_destroy_texture(UBER_HEAT_MAP(object));
+	g_free(priv->edges);
+	g_free(priv->counts);
+	g_free(priv->gradient);
+	g_free(priv->row_groups);
+	if (priv->format_notify) {
+		priv->format_notify(priv->format_user_data);
 	}
+	if (priv->spare) {
+		g_array_unref(priv->spare);
+	}
+	for (i = 0; i < N_LEVELS; i++) {
+		uber_heat_map_free_ring(priv->levels[i]);
+	}
+	if (priv->view) {
+		uber_heat_map_free_ring(priv->view);
+	}
+	uber_heat_map_destroy_strip(UBER_HEAT_MAP(object));
 	G_OBJECT_CLASS(uber_heat_map_parent_class)->finalize(object);
 }
 
@@ -1297,16 +3537,20 @@ uber_heat_map_class_init (UberHeatMapClass *klass) /* IN */
 	GtkWidgetClass *widget_class;
 
 	object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = uber_heat_map_dispose;
 	object_class->finalize = uber_heat_map_finalize;
 	g_type_class_add_private(object_class, sizeof(UberHeatMapPrivate));
 
 	widget_class = GTK_WIDGET_CLASS(klass);
 	widget_class->realize = uber_heat_map_realize;
+	widget_class->style_set = uber_heat_map_style_set;
 	widget_class->expose_event = uber_heat_map_expose_event;
 	widget_class->size_allocate = uber_heat_map_size_allocate;
 	widget_class->enter_notify_event = uber_heat_map_enter_notify_event;
 	widget_class->leave_notify_event = uber_heat_map_leave_notify_event;
 	widget_class->motion_notify_event = uber_heat_map_motion_notify_event;
+	widget_class->button_press_event = uber_heat_map_button_press_event;
+	widget_class->button_release_event = uber_heat_map_button_release_event;
 	widget_class->size_request = uber_heat_map_size_request;
 }
 
@@ -1324,6 +3568,7 @@ uber_heat_map_init (UberHeatMap *map) /* IN */
 {
 	UberHeatMapPrivate *priv;
 	GdkEventMask mask = 0;
+	gint i;
 
 	map->priv = G_TYPE_INSTANCE_GET_PRIVATE(map,
 	                                        UBER_TYPE_HEAT_MAP,
@@ -1336,16 +3581,29 @@ uber_heat_map_init (UberHeatMap *map) /* IN */
 	priv->active_column = -1;
 	priv->active_row = -1;
 	priv->stride = 60; /* TODO: Allow to be changed */
-	priv->ring = g_ring_sized_new(sizeof(GArray*), priv->stride,
-	                              uber_heat_map_destroy_array);
+	for (i = 0; i < N_LEVELS; i++) {
+		priv->levels[i] = g_ring_sized_new(sizeof(Column), priv->stride,
+		                                   uber_heat_map_destroy_column);
+	}
+	priv->normalize = UBER_HEAT_MAP_NORMALIZE_GLOBAL;
+	priv->aggregate = UBER_HEAT_MAP_AGGREGATE_SUM;
+	priv->max_value = 1.;
+	priv->bucket_count = N_BUCKETS;
+	priv->agg = 1;
+	uber_heat_map_update_buckets(map);
 	uber_heat_map_set_block_size(map, 20, TRUE, 10, TRUE);
+	gdk_color_parse("#fce94f", &priv->hl_color);
 	/*
 	 * Enable required GdkEvents.
 	 */
 	mask |= GDK_ENTER_NOTIFY_MASK;
 	mask |= GDK_LEAVE_NOTIFY_MASK;
 	mask |= GDK_POINTER_MOTION_MASK;
+	mask |= GDK_BUTTON_PRESS_MASK;
+	mask |= GDK_BUTTON_RELEASE_MASK;
 	gtk_widget_set_events(GTK_WIDGET(map), mask);
+	uber_frame_clock_watch_viewable(GTK_WIDGET(map),
+	                                uber_heat_map_viewable_changed, NULL);
 	/*
 	 * Setup callback to retrieve next set of values.
 	 */
@@ -37,21 +37,124 @@ typedef struct _UberHeatMap        UberHeatMap;
 typedef struct _UberHeatMapClass   UberHeatMapClass;
 typedef struct _UberHeatMapPrivate UberHeatMapPrivate;
 
+/**
+ * UberHeatMapScale:
+ * @UBER_HEAT_MAP_SCALE_LINEAR: Buckets of equal width across the y range.
+ * @UBER_HEAT_MAP_SCALE_LOG2: Logarithmic buckets; the y range is widened
+ *   to powers of two.
+ * @UBER_HEAT_MAP_SCALE_LOG10: Logarithmic buckets; the y range is widened
+ *   to powers of ten.
+ * @UBER_HEAT_MAP_SCALE_CUSTOM: Buckets between the edges supplied to
+ *   uber_heat_map_set_bucket_edges().
+ *
+ * How pushed observations are binned into the buckets of a column.
+ */
+typedef enum
+{
+	UBER_HEAT_MAP_SCALE_LINEAR,
+	UBER_HEAT_MAP_SCALE_LOG2,
+	UBER_HEAT_MAP_SCALE_LOG10,
+	UBER_HEAT_MAP_SCALE_CUSTOM,
+} UberHeatMapScale;
+
+/**
+ * UberHeatMapNormalize:
+ * @UBER_HEAT_MAP_NORMALIZE_PER_COLUMN: Each column is scaled to its own
+ *   largest bucket.
+ * @UBER_HEAT_MAP_NORMALIZE_GLOBAL: Columns are scaled to the largest
+ *   bucket currently shown.
+ * @UBER_HEAT_MAP_NORMALIZE_DECAY: Columns are scaled to a running maximum
+ *   which decays with every column.
+ * @UBER_HEAT_MAP_NORMALIZE_FIXED: Columns are scaled to the value set with
+ *   uber_heat_map_set_max_value().
+ *
+ * How bucket counts are turned into intensities.
+ */
+typedef enum
+{
+	UBER_HEAT_MAP_NORMALIZE_PER_COLUMN,
+	UBER_HEAT_MAP_NORMALIZE_GLOBAL,
+	UBER_HEAT_MAP_NORMALIZE_DECAY,
+	UBER_HEAT_MAP_NORMALIZE_FIXED,
+} UberHeatMapNormalize;
+
+/**
+ * UberHeatMapAggregate:
+ * @UBER_HEAT_MAP_AGGREGATE_SUM: Buckets of merged columns are added up.
+ * @UBER_HEAT_MAP_AGGREGATE_MAX: The largest of the merged buckets is kept.
+ * @UBER_HEAT_MAP_AGGREGATE_MEAN: Buckets of merged columns are averaged.
+ *
+ * How adjacent columns are merged when there are more columns than pixels
+ * to show them in.
+ */
+typedef enum
+{
+	UBER_HEAT_MAP_AGGREGATE_SUM,
+	UBER_HEAT_MAP_AGGREGATE_MAX,
+	UBER_HEAT_MAP_AGGREGATE_MEAN,
+} UberHeatMapAggregate;
+
+/**
+ * UberHeatMapPalette:
+ * @UBER_HEAT_MAP_PALETTE_DEFAULT: From the content background to blue.
+ * @UBER_HEAT_MAP_PALETTE_VIRIDIS: The perceptually uniform viridis map.
+ * @UBER_HEAT_MAP_PALETTE_MAGMA: The perceptually uniform magma map.
+ * @UBER_HEAT_MAP_PALETTE_GRAYSCALE: From black to white.
+ * @UBER_HEAT_MAP_PALETTE_CUSTOM: The gradient supplied to
+ *   uber_heat_map_set_gradient().
+ *
+ * The colors used for cell intensities.
+ */
+typedef enum
+{
+	UBER_HEAT_MAP_PALETTE_DEFAULT,
+	UBER_HEAT_MAP_PALETTE_VIRIDIS,
+	UBER_HEAT_MAP_PALETTE_MAGMA,
+	UBER_HEAT_MAP_PALETTE_GRAYSCALE,
+	UBER_HEAT_MAP_PALETTE_CUSTOM,
+} UberHeatMapPalette;
+
 /**
  * UberHeatMapFunc:
  * @map: A #UberHeatMap.
  * @values: A location to store an array of #gdouble<!-- -->'s.
  * @user_data: User data supplied to uber_heat_map_set_value_func().
  *
- * A callback to retrieve the next set of data for the graph.
+ * A callback to retrieve the next set of data for the graph.  @values
+ * holds the raw value of each bucket, starting at the bottom.  Alternatively
+ * the callback may push observations with uber_heat_map_push() and return
+ * %FALSE, in which case the column is built from the pushed observations
+ * or the buckets set with uber_heat_map_set_column().  The heat map takes
+ * ownership of @values and may reuse it for later columns.
  *
- * Returns: %TRUE if successful; otherwise %FALSE.
+ * Returns: %TRUE if @values was set; otherwise %FALSE.
  * Side effects: None.
  */
 typedef gboolean (*UberHeatMapFunc) (UberHeatMap  *map,
                                      GArray      **values,
                                      gpointer      user_data);
 
+/**
+ * UberHeatMapFormatFunc:
+ * @map: A #UberHeatMap.
+ * @column: The hovered column, counting back from the newest.
+ * @row: The first bucket of the hovered row, counting up from the bottom.
+ * @range: The range of values counted in the buckets of the hovered row.
+ * @value: The value of the hovered cell, the largest of its buckets.
+ * @user_data: User data supplied to uber_heat_map_set_format_func().
+ *
+ * A callback to describe the hovered cell in the tooltip.
+ *
+ * Returns: A newly allocated string.
+ * Side effects: None.
+ */
+typedef gchar* (*UberHeatMapFormatFunc) (UberHeatMap     *map,
+                                         gint             column,
+                                         gint             row,
+                                         const UberRange *range,
+                                         gdouble          value,
+                                         gpointer         user_data);
+
 struct _UberHeatMap
 {
 	GtkDrawingArea parent;
@@ -65,21 +168,57 @@ struct _UberHeatMapClass
 	GtkDrawingAreaClass parent_class;
 };
 
-GType      uber_heat_map_get_type       (void) G_GNUC_CONST;
-GtkWidget* uber_heat_map_new            (void);
-void       uber_heat_map_set_x_range    (UberHeatMap     *map,
-                                         const UberRange *x_range);
-void       uber_heat_map_set_y_range    (UberHeatMap     *map,
-                                         const UberRange *y_range);
-void       uber_heat_map_set_block_size (UberHeatMap     *map,
-                                         gint             width,
-                                         gboolean         width_is_count,
-                                         gint             height,
-                                         gboolean         height_is_count);
-void       uber_heat_map_set_value_func (UberHeatMap     *map,
-                                         UberHeatMapFunc  func,
-                                         gpointer         user_data,
-                                         GDestroyNotify   notify);
+GType      uber_heat_map_get_type         (void) G_GNUC_CONST;
+GtkWidget* uber_heat_map_new              (void);
+void       uber_heat_map_set_x_range      (UberHeatMap          *map,
+                                           const UberRange      *x_range);
+void       uber_heat_map_set_y_range      (UberHeatMap          *map,
+                                           const UberRange      *y_range);
+void       uber_heat_map_set_block_size   (UberHeatMap          *map,
+                                           gint                  width,
+                                           gboolean              width_is_count,
+                                           gint                  height,
+                                           gboolean              height_is_count);
+void       uber_heat_map_set_value_func   (UberHeatMap          *map,
+                                           UberHeatMapFunc       func,
+                                           gpointer              user_data,
+                                           GDestroyNotify        notify);
+void       uber_heat_map_set_format_func  (UberHeatMap          *map,
+                                           UberHeatMapFormatFunc func,
+                                           gpointer              user_data,
+                                           GDestroyNotify        notify);
+void       uber_heat_map_set_scale        (UberHeatMap          *map,
+                                           UberHeatMapScale      scale);
+void       uber_heat_map_set_bucket_edges (UberHeatMap          *map,
+                                           const gdouble        *edges,
+                                           guint                 n_edges);
+void       uber_heat_map_set_n_buckets    (UberHeatMap          *map,
+                                           guint                 n_buckets);
+void       uber_heat_map_set_normalize    (UberHeatMap          *map,
+                                           UberHeatMapNormalize  normalize);
+void       uber_heat_map_set_max_value    (UberHeatMap          *map,
+                                           gdouble               max_value);
+void       uber_heat_map_set_row_groups   (UberHeatMap          *map,
+                                           const guint          *sizes,
+                                           guint                 n_sizes);
+void       uber_heat_map_set_zoom         (UberHeatMap          *map,
+                                           guint                 level,
+                                           guint                 offset);
+void       uber_heat_map_set_aggregate    (UberHeatMap          *map,
+                                           UberHeatMapAggregate  aggregate);
+void       uber_heat_map_set_palette      (UberHeatMap          *map,
+                                           UberHeatMapPalette    palette);
+void       uber_heat_map_set_gradient     (UberHeatMap          *map,
+                                           const GdkColor       *colors,
+                                           guint                 n_colors);
+void       uber_heat_map_set_column       (UberHeatMap          *map,
+                                           const gdouble        *values,
+                                           guint                 n_values);
+void       uber_heat_map_push             (UberHeatMap          *map,
+                                           gdouble               value);
+void       uber_heat_map_push_many        (UberHeatMap          *map,
+                                           const gdouble        *values,
+                                           guint                 n_values);
 
 G_END_DECLS
 
@@ -21,9 +21,16 @@
 #endif
 
 #include <glib/gi18n.h>
+#include <math.h>
 
+#include "uber-frame-clock.h"
 #include "uber-label.h"
 
+#define SPARK_WIDTH  48 /* Width of the sparkline in pixels. */
+#define SPARK_HEIGHT 17 /* Height of the sparkline in pixels. */
+#define SPARK_STEP   2  /* Pixels between data points. */
+#define SPARK_FPS    2  /* Rate at which the graph is polled for new data. */
+
 #ifdef UBER_TRACE
 #define TRACE(_f,...) \
     G_STMT_START { \
@@ -70,11 +77,27 @@ struct _UberLabelPrivate
 {
 	GtkWidget *hbox;
 	GtkWidget *block;
-	GtkWidget *label;
+	GtkWidget *label;            /* Fixed size text slot. */
+	PangoLayout *layout;         /* Layout for the label text. */
+	gchar     *text;             /* Text currently displayed. */
+	gchar     *pending;          /* Newest text held back by max rate. */
+	gint       text_width;       /* Largest text width displayed. */
+	gint       text_height;      /* Largest text height displayed. */
+	gint64     last_update;      /* Monotonic time of the last update. */
+	gint64     min_interval;     /* Microseconds between updates. */
+	guint      flush_handler;    /* Timeout to display pending. */
 	GdkColor   color;
 	gboolean   in_block;
 	UberGraph *graph;
 	gint       graph_line;
+	GtkWidget *spark;            /* Sparkline drawing area. */
+	GdkPixmap *spark_pixmap;     /* Cached sparkline contents. */
+	cairo_t   *spark_cairo;      /* Context for spark_pixmap. */
+	GdkGC     *spark_gc;         /* GC to scroll spark_pixmap. */
+	guint      spark_generation; /* Graph generation last drawn. */
+	UberRange  spark_range;      /* Graph range last drawn. */
+	gboolean   spark_full;       /* Sparkline needs a full render. */
+	guint      spark_handler;    /* Frame clock handler. */
 };
 
 /**
@@ -95,12 +118,104 @@ uber_label_new (void)
 	RETURN(GTK_WIDGET(label));
 }
 
+/**
+ * uber_label_apply_text:
+ * @label: A #UberLabel.
+ * @text: The label text.
+ *
+ * Displays @text in the text slot.  The slot only requests a new size
+ * when @text is larger than anything displayed before, so most updates
+ * are a redraw of the slot alone.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_apply_text (UberLabel   *label, /* IN */
+                       const gchar *text)  /* IN */
+{
+	UberLabelPrivate *priv;
+	gint width;
+	gint height;
+
+	ENTRY;
+	priv = label->priv;
+	g_free(priv->text);
+	priv->text = g_strdup(text);
+	priv->last_update = g_get_monotonic_time();
+	pango_layout_set_text(priv->layout, text ? text : "", -1);
+	pango_layout_get_pixel_size(priv->layout, &width, &height);
+	if (width > priv->text_width || height > priv->text_height) {
+		priv->text_width = MAX(width, priv->text_width);
+		priv->text_height = MAX(height, priv->text_height);
+		gtk_widget_set_size_request(priv->label, priv->text_width,
+		                            priv->text_height);
+	}
+	gtk_widget_queue_draw(priv->label);
+	EXIT;
+}
+
+/**
+ * uber_label_clear_pending:
+ * @label: A #UberLabel.
+ *
+ * Drops any throttled text which has not been displayed yet.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_clear_pending (UberLabel *label) /* IN */
+{
+	UberLabelPrivate *priv;
+
+	ENTRY;
+	priv = label->priv;
+	if (priv->flush_handler) {
+		g_source_remove(priv->flush_handler);
+		priv->flush_handler = 0;
+	}
+	g_free(priv->pending);
+	priv->pending = NULL;
+	EXIT;
+}
+
+/**
+ * uber_label_flush_timeout:
+ * @data: An #UberLabel.
+ *
+ * Displays the most recent text which was held back by the maximum
+ * update rate.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_label_flush_timeout (gpointer data) /* IN */
+{
+	UberLabel *label = data;
+	UberLabelPrivate *priv;
+
+	g_return_val_if_fail(UBER_IS_LABEL(label), FALSE);
+
+	ENTRY;
+	priv = label->priv;
+	priv->flush_handler = 0;
+	uber_label_apply_text(label, priv->pending);
+	g_free(priv->pending);
+	priv->pending = NULL;
+	RETURN(FALSE);
+}
+
 /**
  * uber_label_set_text:
  * @label: A #UberLabel.
  * @text: The label text.
  *
- * Sets the text for the label.
+ * Sets the text for the label.  Nothing is done if @text matches the
+ * current text.  If a maximum update rate is set, updates arriving too
+ * quickly are held back and only the most recent one is displayed once
+ * the interval has passed.
  *
  * Returns: None.
  * Side effects: None.
@@ -110,12 +225,128 @@ uber_label_set_text (UberLabel   *label, /* IN */
                      const gchar *text)  /* IN */
 {
 	UberLabelPrivate *priv;
+	gint64 elapsed;
+
+	g_return_if_fail(UBER_IS_LABEL(label));
+
+	ENTRY;
+	priv = label->priv;
+	if (!g_strcmp0(text, priv->text)) {
+		uber_label_clear_pending(label);
+		EXIT;
+	}
+	elapsed = g_get_monotonic_time() - priv->last_update;
+	if (priv->min_interval && elapsed < priv->min_interval) {
+		if (g_strcmp0(text, priv->pending)) {
+			g_free(priv->pending);
+			priv->pending = g_strdup(text);
+		}
+		if (!priv->flush_handler) {
+			priv->flush_handler =
+				g_timeout_add((priv->min_interval - elapsed) / 1000 + 1,
+				              uber_label_flush_timeout, label);
+		}
+		EXIT;
+	}
+	uber_label_clear_pending(label);
+	uber_label_apply_text(label, text);
+	EXIT;
+}
+
+/**
+ * uber_label_set_max_rate:
+ * @label: A #UberLabel.
+ * @max_rate: The maximum number of text updates per second or 0.
+ *
+ * Limits how often the displayed text may change.  A @max_rate of 0
+ * displays every change immediately.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_label_set_max_rate (UberLabel *label,    /* IN */
+                         guint      max_rate) /* IN */
+{
+	UberLabelPrivate *priv;
 
 	g_return_if_fail(UBER_IS_LABEL(label));
 
 	ENTRY;
 	priv = label->priv;
-	gtk_label_set_text(GTK_LABEL(priv->label), text);
+	priv->min_interval = max_rate ? G_USEC_PER_SEC / max_rate : 0;
+	EXIT;
+}
+
+/**
+ * uber_label_text_expose_event:
+ * @widget: The text slot.
+ * @event: A #GdkEventExpose.
+ * @label: An #UberLabel.
+ *
+ * Draws the current text left aligned and vertically centered in the
+ * text slot.
+ *
+ * Returns: %FALSE to allow further callbacks.
+ * Side effects: None.
+ */
+static gboolean
+uber_label_text_expose_event (GtkWidget      *widget, /* IN */
+                              GdkEventExpose *event,  /* IN */
+                              UberLabel      *label)  /* IN */
+{
+	UberLabelPrivate *priv;
+	GtkAllocation alloc;
+	gint height;
+
+	g_return_val_if_fail(UBER_IS_LABEL(label), FALSE);
+
+	ENTRY;
+	priv = label->priv;
+	gtk_widget_get_allocation(widget, &alloc);
+	pango_layout_get_pixel_size(priv->layout, NULL, &height);
+	gtk_paint_layout(gtk_widget_get_style(widget),
+	                 event->window,
+	                 gtk_widget_get_state(widget),
+	                 FALSE,
+	                 &event->area,
+	                 widget,
+	                 "label",
+	                 0,
+	                 (alloc.height - height) / 2,
+	                 priv->layout);
+	RETURN(FALSE);
+}
+
+/**
+ * uber_label_text_style_set:
+ * @widget: The text slot.
+ * @old_style: The previous #GtkStyle or %NULL.
+ * @label: An #UberLabel.
+ *
+ * Updates the layout for a new font.  The slot is allowed to shrink to
+ * fit the new font.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_text_style_set (GtkWidget *widget,    /* IN */
+                           GtkStyle  *old_style, /* IN */
+                           UberLabel *label)     /* IN */
+{
+	UberLabelPrivate *priv;
+	gchar *text;
+
+	ENTRY;
+	priv = label->priv;
+	pango_layout_context_changed(priv->layout);
+	priv->text_width = 0;
+	priv->text_height = 0;
+	text = priv->text;
+	priv->text = NULL;
+	uber_label_apply_text(label, text);
+	g_free(text);
 	EXIT;
 }
 
@@ -140,6 +371,8 @@ uber_label_set_color (UberLabel      *label, /* IN */
 	ENTRY;
 	priv = label->priv;
 	priv->color = *color;
+	priv->spark_full = TRUE;
+	gtk_widget_queue_draw(priv->spark);
 	EXIT;
 }
 
@@ -170,6 +403,7 @@ uber_label_bind_graph (UberLabel *label, /* IN */
 	priv->graph_line = line;
 	g_object_add_weak_pointer(G_OBJECT(graph), (gpointer *)&priv->graph);
 	uber_graph_set_line_color(graph, line, &priv->color);
+	priv->spark_full = TRUE;
 	EXIT;
 }
 
@@ -221,6 +455,354 @@ uber_label_block_expose_event (GtkWidget      *block, /* IN */
 	EXIT;
 }
 
+/**
+ * uber_label_spark_destroy:
+ * @label: A #UberLabel.
+ *
+ * Releases the cached sparkline pixmap.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_spark_destroy (UberLabel *label) /* IN */
+{
+	UberLabelPrivate *priv;
+
+	ENTRY;
+	priv = label->priv;
+	if (priv->spark_cairo) {
+		cairo_destroy(priv->spark_cairo);
+		priv->spark_cairo = NULL;
+	}
+	if (priv->spark_gc) {
+		g_object_unref(priv->spark_gc);
+		priv->spark_gc = NULL;
+	}
+	if (priv->spark_pixmap) {
+		g_object_unref(priv->spark_pixmap);
+		priv->spark_pixmap = NULL;
+	}
+	EXIT;
+}
+
+/**
+ * uber_label_spark_get_y:
+ * @label: A #UberLabel.
+ * @value: A raw value from the graph.
+ *
+ * Translates @value into a y coordinate of the sparkline.
+ *
+ * Returns: The y coordinate.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_label_spark_get_y (UberLabel *label, /* IN */
+                        gdouble    value) /* IN */
+{
+	UberLabelPrivate *priv = label->priv;
+	gdouble y = 0.;
+
+	if (priv->spark_range.range > 0.) {
+		y = (value - priv->spark_range.begin) / priv->spark_range.range;
+	}
+	y = CLAMP(y, 0., 1.);
+	return SPARK_HEIGHT - 1.5 - (y * (SPARK_HEIGHT - 3));
+}
+
+/**
+ * uber_label_spark_render:
+ * @label: A #UberLabel.
+ * @count: The number of new data points or -1 to render every point.
+ *
+ * Renders the sparkline into the cached pixmap.  When only a few data
+ * points are new, the cached contents are scrolled and just the new
+ * columns are drawn.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_spark_render (UberLabel *label, /* IN */
+                         gint       count) /* IN */
+{
+	UberLabelPrivate *priv;
+	GtkStyle *style;
+	gboolean drawing = FALSE;
+	gdouble value;
+	gdouble x;
+	gint shift;
+	gint i;
+
+	ENTRY;
+	priv = label->priv;
+	style = gtk_widget_get_style(priv->spark);
+	if (count < 0 || count * SPARK_STEP >= SPARK_WIDTH) {
+		count = SPARK_WIDTH / SPARK_STEP + 1;
+		shift = SPARK_WIDTH;
+	} else {
+		shift = count * SPARK_STEP;
+		cairo_surface_flush(cairo_get_target(priv->spark_cairo));
+		gdk_draw_drawable(priv->spark_pixmap, priv->spark_gc,
+		                  priv->spark_pixmap, shift, 0, 0, 0,
+		                  SPARK_WIDTH - shift, SPARK_HEIGHT);
+		cairo_surface_mark_dirty(cairo_get_target(priv->spark_cairo));
+	}
+	/*
+	 * Clear the new columns and draw the segments which end in them.  A
+	 * pixel more is cleared and the segment before them drawn again, as
+	 * its butt end stops half a pixel short of the new columns.
+	 */
+	if (shift < SPARK_WIDTH) {
+		shift++;
+		count++;
+	}
+	cairo_save(priv->spark_cairo);
+	cairo_rectangle(priv->spark_cairo, SPARK_WIDTH - shift, 0,
+	                shift, SPARK_HEIGHT);
+	gdk_cairo_set_source_color(priv->spark_cairo,
+	                           &style->base[GTK_STATE_NORMAL]);
+	cairo_fill_preserve(priv->spark_cairo);
+	cairo_clip(priv->spark_cairo);
+	for (i = 0; priv->graph && i <= count; i++) {
+		value = uber_graph_get_line_value(priv->graph, priv->graph_line, i);
+		if (isnan(value) || isinf(value)) {
+			drawing = FALSE;
+			continue;
+		}
+		x = SPARK_WIDTH - .5 - (i * SPARK_STEP);
+		if (drawing) {
+			cairo_line_to(priv->spark_cairo, x,
+			              uber_label_spark_get_y(label, value));
+		} else {
+			cairo_move_to(priv->spark_cairo, x,
+			              uber_label_spark_get_y(label, value));
+			drawing = TRUE;
+		}
+	}
+	gdk_cairo_set_source_color(priv->spark_cairo, &priv->color);
+	cairo_set_line_width(priv->spark_cairo, 1.);
+	cairo_stroke(priv->spark_cairo);
+	cairo_restore(priv->spark_cairo);
+	EXIT;
+}
+
+/**
+ * uber_label_spark_update:
+ * @label: A #UberLabel.
+ *
+ * Checks the bound graph for new data points and renders them to the
+ * cached sparkline.
+ *
+ * Returns: %TRUE if the sparkline changed; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_label_spark_update (UberLabel *label) /* IN */
+{
+	UberLabelPrivate *priv;
+	UberRange range;
+	guint generation;
+
+	ENTRY;
+	priv = label->priv;
+	if (!priv->spark_pixmap) {
+		RETURN(FALSE);
+	}
+	if (!priv->graph) {
+		if (priv->spark_full) {
+			uber_label_spark_render(label, -1);
+			priv->spark_full = FALSE;
+			RETURN(TRUE);
+		}
+		RETURN(FALSE);
+	}
+	generation = uber_graph_get_generation(priv->graph);
+	if (generation == priv->spark_generation && !priv->spark_full) {
+		RETURN(FALSE);
+	}
+	/*
+	 * A change in scale moves every point, so start over.
+	 */
+	uber_graph_get_yrange(priv->graph, &range);
+	if (range.begin != priv->spark_range.begin ||
+	    range.end != priv->spark_range.end) {
+		priv->spark_range = range;
+		priv->spark_range.range = range.end - range.begin;
+		priv->spark_full = TRUE;
+	}
+	uber_label_spark_render(label, priv->spark_full ? -1 :
+	                        (gint)(generation - priv->spark_generation));
+	priv->spark_generation = generation;
+	priv->spark_full = FALSE;
+	RETURN(TRUE);
+}
+
+/**
+ * uber_label_spark_timeout:
+ * @widget: The sparkline drawing area.
+ * @damage: A location for the area to invalidate.
+ * @user_data: An #UberLabel.
+ *
+ * #UberFrameFunc to update the sparkline while it is mapped.
+ *
+ * Returns: %TRUE if the sparkline changed; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_label_spark_timeout (GtkWidget    *widget,    /* IN */
+                          GdkRectangle *damage,    /* OUT */
+                          gpointer      user_data) /* IN */
+{
+	UberLabel *label = user_data;
+
+	g_return_val_if_fail(UBER_IS_LABEL(label), FALSE);
+
+	ENTRY;
+	if (!gtk_widget_get_mapped(widget) || !uber_label_spark_update(label)) {
+		RETURN(FALSE);
+	}
+	damage->x = 0;
+	damage->y = 0;
+	damage->width = SPARK_WIDTH;
+	damage->height = SPARK_HEIGHT;
+	RETURN(TRUE);
+}
+
+/**
+ * uber_label_spark_expose_event:
+ * @widget: The sparkline drawing area.
+ * @event: A #GdkEventExpose.
+ * @label: An #UberLabel.
+ *
+ * Draws the cached sparkline.  The pixmap is created on first use.
+ *
+ * Returns: %FALSE to allow further callbacks.
+ * Side effects: None.
+ */
+static gboolean
+uber_label_spark_expose_event (GtkWidget      *widget, /* IN */
+                               GdkEventExpose *event,  /* IN */
+                               UberLabel      *label)  /* IN */
+{
+	UberLabelPrivate *priv;
+
+	g_return_val_if_fail(UBER_IS_LABEL(label), FALSE);
+
+	ENTRY;
+	priv = label->priv;
+	if (!priv->spark_pixmap) {
+		priv->spark_pixmap = gdk_pixmap_new(event->window, SPARK_WIDTH,
+		                                    SPARK_HEIGHT, -1);
+		priv->spark_gc = gdk_gc_new(priv->spark_pixmap);
+		priv->spark_cairo = gdk_cairo_create(priv->spark_pixmap);
+		priv->spark_full = TRUE;
+	}
+	if (priv->spark_full) {
+		uber_label_spark_update(label);
+	}
+	gdk_draw_drawable(event->window, priv->spark_gc, priv->spark_pixmap,
+	                  event->area.x, event->area.y,
+	                  event->area.x, event->area.y,
+	                  event->area.width, event->area.height);
+	RETURN(FALSE);
+}
+
+/**
+ * uber_label_spark_unrealize:
+ * @widget: The sparkline drawing area.
+ * @label: An #UberLabel.
+ *
+ * Releases the cached sparkline when its window goes away.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_spark_unrealize (GtkWidget *widget, /* IN */
+                            UberLabel *label)  /* IN */
+{
+	ENTRY;
+	uber_label_spark_destroy(label);
+	EXIT;
+}
+
+/**
+ * uber_label_spark_remove_handler:
+ * @label: An #UberLabel.
+ *
+ * Unregisters the sparkline from the frame clock.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_spark_remove_handler (UberLabel *label) /* IN */
+{
+	UberLabelPrivate *priv;
+
+	ENTRY;
+	priv = label->priv;
+	if (priv->spark_handler) {
+		uber_frame_clock_remove(priv->spark_handler);
+		priv->spark_handler = 0;
+	}
+	EXIT;
+}
+
+/**
+ * uber_label_spark_destroyed:
+ * @object: The sparkline drawing area.
+ * @label: An #UberLabel.
+ *
+ * Stops the frame clock from ticking the sparkline once it is destroyed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_spark_destroyed (GtkObject *object, /* IN */
+                            UberLabel *label)  /* IN */
+{
+	ENTRY;
+	uber_label_spark_remove_handler(label);
+	EXIT;
+}
+
+/**
+ * uber_label_set_show_sparkline:
+ * @label: A #UberLabel.
+ * @show_sparkline: If the sparkline should be shown.
+ *
+ * Shows a small trend of the bound graph line next to the label.  The
+ * sparkline reads the values of the line directly from the graph and
+ * only draws the columns for new data points.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_label_set_show_sparkline (UberLabel *label,          /* IN */
+                               gboolean   show_sparkline) /* IN */
+{
+	UberLabelPrivate *priv;
+
+	g_return_if_fail(UBER_IS_LABEL(label));
+
+	ENTRY;
+	priv = label->priv;
+	gtk_widget_set_visible(priv->spark, show_sparkline);
+	if (show_sparkline && !priv->spark_handler) {
+		priv->spark_full = TRUE;
+		priv->spark_handler = uber_frame_clock_add(priv->spark, SPARK_FPS,
+		                                           uber_label_spark_timeout,
+		                                           label);
+	} else if (!show_sparkline) {
+		uber_label_spark_remove_handler(label);
+	}
+	EXIT;
+}
+
 /**
  * uber_label_block_enter_notify_event:
  * @label: A #UberLabel.
@@ -297,6 +879,8 @@ uber_label_block_button_press_event (GtkWidget      *widget, /* IN */
 	if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_OK) {
 		gtk_color_selection_get_current_color(GTK_COLOR_SELECTION(selection), &priv->color);
 		gtk_widget_queue_draw(widget);
+		priv->spark_full = TRUE;
+		gtk_widget_queue_draw(priv->spark);
 		if (priv->graph) {
 			uber_graph_set_line_color(priv->graph, priv->graph_line, &priv->color);
 		}
@@ -305,6 +889,24 @@ uber_label_block_button_press_event (GtkWidget      *widget, /* IN */
 	RETURN(FALSE);
 }
 
+/**
+ * uber_label_dispose:
+ * @object: A #UberLabel.
+ *
+ * Unregisters the sparkline from the frame clock while it is still alive.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_label_dispose (GObject *object) /* IN */
+{
+	ENTRY;
+	uber_label_spark_remove_handler(UBER_LABEL(object));
+	G_OBJECT_CLASS(uber_label_parent_class)->dispose(object);
+	EXIT;
+}
+
 /**
  * uber_label_finalize:
  * @object: A #UberLabel.
@@ -318,7 +920,18 @@ uber_label_block_button_press_event (GtkWidget      *widget, /* IN */
 static void
 uber_label_finalize (GObject *object) /* IN */
 {
+	UberLabelPrivate *priv;
+
 	ENTRY;
+	priv = UBER_LABEL(object)->priv;
+	uber_label_spark_destroy(UBER_LABEL(object));
+	uber_label_clear_pending(UBER_LABEL(object));
+	g_object_unref(priv->layout);
+	g_free(priv->text);
+	if (priv->graph) {
+		g_object_remove_weak_pointer(G_OBJECT(priv->graph),
+		                             (gpointer *)&priv->graph);
+	}
 	G_OBJECT_CLASS(uber_label_parent_class)->finalize(object);
 	EXIT;
 }
@@ -339,6 +952,7 @@ uber_label_class_init (UberLabelClass *klass) /* IN */
 
 	ENTRY;
 	object_class = G_OBJECT_CLASS(klass);
+	object_class->dispose = uber_label_dispose;
 	object_class->finalize = uber_label_finalize;
 	g_type_class_add_private(object_class, sizeof(UberLabelPrivate));
 	EXIT;
@@ -365,12 +979,15 @@ uber_label_init (UberLabel *label) /* IN */
 	priv = label->priv;
 	priv->hbox = gtk_hbox_new(FALSE, 6);
 	priv->block = gtk_drawing_area_new();
-	priv->label = gtk_label_new(NULL);
+	priv->label = gtk_drawing_area_new();
+	priv->layout = gtk_widget_create_pango_layout(priv->label, NULL);
+	priv->spark = gtk_drawing_area_new();
 	gdk_color_parse("#cc0000", &priv->color);
-	gtk_misc_set_alignment(GTK_MISC(priv->label), .0, .5);
 	gtk_widget_set_size_request(priv->block, 32, 17);
+	gtk_widget_set_size_request(priv->spark, SPARK_WIDTH, SPARK_HEIGHT);
 	gtk_container_add(GTK_CONTAINER(label), priv->hbox);
 	gtk_box_pack_start(GTK_BOX(priv->hbox), priv->block, FALSE, TRUE, 0);
+	gtk_box_pack_start(GTK_BOX(priv->hbox), priv->spark, FALSE, FALSE, 0);
 	gtk_box_pack_start(GTK_BOX(priv->hbox), priv->label, TRUE, TRUE, 0);
 	gtk_widget_add_events(priv->block,
 	                      GDK_ENTER_NOTIFY_MASK |
@@ -392,6 +1009,26 @@ uber_label_init (UberLabel *label) /* IN */
 	                 "button-press-event",
 	                 G_CALLBACK(uber_label_block_button_press_event),
 	                 label);
+	g_signal_connect(priv->label,
+	                 "expose-event",
+	                 G_CALLBACK(uber_label_text_expose_event),
+	                 label);
+	g_signal_connect(priv->label,
+	                 "style-set",
+	                 G_CALLBACK(uber_label_text_style_set),
+	                 label);
+	g_signal_connect(priv->spark,
+	                 "expose-event",
+	                 G_CALLBACK(uber_label_spark_expose_event),
+	                 label);
+	g_signal_connect(priv->spark,
+	                 "unrealize",
+	                 G_CALLBACK(uber_label_spark_unrealize),
+	                 label);
+	g_signal_connect(priv->spark,
+	                 "destroy",
+	                 G_CALLBACK(uber_label_spark_destroyed),
+	                 label);
 	gtk_widget_set_tooltip_text(GTK_WIDGET(priv->block),
 	                            _("Click to select color"));
 	gtk_widget_show(priv->hbox);
@@ -55,8 +55,14 @@ GType      uber_label_get_type   (void) G_GNUC_CONST;
 GtkWidget* uber_label_new        (void);
 void       uber_label_set_color  (UberLabel      *label,
                                   const GdkColor *color);
+void       uber_label_set_max_rate
+                                 (UberLabel      *label,
+                                  guint           max_rate);
 void       uber_label_set_text   (UberLabel      *label,
                                   const gchar    *markup);
+void       uber_label_set_show_sparkline
+                                 (UberLabel      *label,
+                                  gboolean        show_sparkline);
 
 G_END_DECLS
 
@@ -0,0 +1,328 @@
+/* uber-surface-pool.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "uber-surface-pool.h"
+
+#define BUCKET_SIZE (64)               /* Granularity of pooled surface sizes. */
+#define MAX_FREE    (8)                /* Released surfaces kept for reuse. */
+#define MAX_BYTES   (16 * 1024 * 1024) /* Memory held by released surfaces. */
+#define MAX_AGE     (5)                /* Seconds a released surface is kept. */
+
+/**
+ * SECTION:uber-surface-pool
+ * @title: UberSurfacePool
+ * @short_description: Process-wide pool of server-side pixmaps.
+ *
+ * Widgets recreate their pixmaps on every size allocation, which means
+ * several pixmap allocations per configure event while a window is being
+ * resized.  The surface pool rounds requested sizes up to a bucket so that
+ * a widget can keep its pixmaps while the size stays within the bucket,
+ * only updating its clip and extents.  Pixmaps which are released are kept
+ * for a later request of the same bucket.  Released pixmaps are freed once
+ * they have not been reused for a few seconds, when they would hold too
+ * much memory, or when their display is closed.
+ *
+ * The pool is only to be used from the GUI thread.
+ */
+
+typedef struct
+{
+	GdkPixmap *pixmap;   /* The released pixmap. */
+	gsize      bytes;    /* Approximate size of pixmap. */
+	gint64     released; /* Monotonic time the pixmap was released. */
+} PoolEntry;
+
+static GSList *free_list  = NULL; /* PoolEntry, most recently released first. */
+static gsize   free_bytes = 0;    /* Sum of bytes in free_list. */
+static guint   expire_id  = 0;    /* Timeout to expire old entries. */
+
+/**
+ * uber_surface_pool_round:
+ * @size: A size in pixels.
+ *
+ * Rounds @size up to the next bucket.
+ *
+ * Returns: The bucket size.
+ * Side effects: None.
+ */
+static inline gint
+uber_surface_pool_round (gint size) /* IN */
+{
+	size = MAX(1, size);
+	return ((size + BUCKET_SIZE - 1) / BUCKET_SIZE) * BUCKET_SIZE;
+}
+
+/**
+ * uber_surface_pool_free_entry:
+ * @entry: A PoolEntry.
+ *
+ * Frees @entry and its pixmap.  @entry must already be removed from
+ * free_list.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_surface_pool_free_entry (PoolEntry *entry) /* IN */
+{
+	free_bytes -= entry->bytes;
+	g_object_unref(entry->pixmap);
+	g_slice_free(PoolEntry, entry);
+}
+
+/**
+ * uber_surface_pool_trim:
+ * @now: The current monotonic time, or 0 to keep entries of any age.
+ *
+ * Frees the oldest released pixmaps until at most MAX_FREE entries and
+ * MAX_BYTES bytes remain, along with any entry released more than MAX_AGE
+ * seconds before @now.  Since free_list is sorted by release time, only its
+ * tail is ever freed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_surface_pool_trim (gint64 now) /* IN */
+{
+	PoolEntry *entry;
+	GSList *tail;
+	guint len;
+
+	len = g_slist_length(free_list);
+	while ((tail = g_slist_last(free_list))) {
+		entry = tail->data;
+		if (len <= MAX_FREE && free_bytes <= MAX_BYTES &&
+		    (!now || now - entry->released < MAX_AGE * G_USEC_PER_SEC)) {
+			break;
+		}
+		free_list = g_slist_delete_link(free_list, tail);
+		uber_surface_pool_free_entry(entry);
+		len--;
+	}
+}
+
+/**
+ * uber_surface_pool_expire:
+ * @data: Unused.
+ *
+ * Timeout which frees released pixmaps that have not been reused.  It is
+ * only installed while the pool holds pixmaps.
+ *
+ * Returns: %TRUE while pixmaps remain in the pool; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_surface_pool_expire (gpointer data) /* IN */
+{
+	uber_surface_pool_trim(g_get_monotonic_time());
+	if (!free_list) {
+		expire_id = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * uber_surface_pool_display_closed:
+ * @display: The #GdkDisplay being closed.
+ * @is_error: If the display was closed because of an error.
+ * @data: Unused.
+ *
+ * Frees the released pixmaps before the connection they live on goes away.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_surface_pool_display_closed (GdkDisplay *display,  /* IN */
+                                  gboolean    is_error, /* IN */
+                                  gpointer    data)     /* IN */
+{
+	uber_surface_pool_clear();
+}
+
+/**
+ * uber_surface_pool_watch_display:
+ * @screen: A #GdkScreen.
+ *
+ * Makes sure the pool is cleared when the display of @screen is closed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_surface_pool_watch_display (GdkScreen *screen) /* IN */
+{
+	static GQuark quark = 0;
+	GdkDisplay *display;
+
+	if (!quark) {
+		quark = g_quark_from_static_string("uber-surface-pool-watched");
+	}
+	display = gdk_screen_get_display(screen);
+	if (!g_object_get_qdata(G_OBJECT(display), quark)) {
+		g_object_set_qdata(G_OBJECT(display), quark, GINT_TO_POINTER(TRUE));
+		g_signal_connect(display, "closed",
+		                 G_CALLBACK(uber_surface_pool_display_closed),
+		                 NULL);
+	}
+}
+
+/**
+ * uber_surface_pool_pixmap_fits:
+ * @pixmap: A #GdkPixmap from uber_surface_pool_acquire_pixmap().
+ * @width: The width required.
+ * @height: The height required.
+ * @rgba: If an alpha channel is required.
+ *
+ * Checks if @pixmap is the pixmap the pool would hand out for a request
+ * of @width by @height.  If so, the caller can keep using it.
+ *
+ * Returns: %TRUE if @pixmap is in the right bucket; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_surface_pool_pixmap_fits (GdkPixmap *pixmap, /* IN */
+                               gint       width,  /* IN */
+                               gint       height, /* IN */
+                               gboolean   rgba)   /* IN */
+{
+	gint p_width;
+	gint p_height;
+
+	g_return_val_if_fail(GDK_IS_PIXMAP(pixmap), FALSE);
+
+	gdk_drawable_get_size(GDK_DRAWABLE(pixmap), &p_width, &p_height);
+	return (p_width == uber_surface_pool_round(width) &&
+	        p_height == uber_surface_pool_round(height) &&
+	        (gdk_drawable_get_depth(GDK_DRAWABLE(pixmap)) == 32) == !!rgba);
+}
+
+/**
+ * uber_surface_pool_acquire_pixmap:
+ * @drawable: A #GdkDrawable on the target screen.
+ * @width: The width required.
+ * @height: The height required.
+ * @rgba: If a 32-bit pixmap with an RGBA colormap is required.
+ *
+ * Retrieves a pixmap of at least @width by @height.  The size is rounded
+ * up to a bucket and a released pixmap of the same bucket is reused when
+ * possible.  The contents of the pixmap are undefined.
+ *
+ * Returns: A #GdkPixmap to be released with
+ *   uber_surface_pool_release_pixmap().
+ * Side effects: None.
+ */
+GdkPixmap*
+uber_surface_pool_acquire_pixmap (GdkDrawable *drawable, /* IN */
+                                  gint         width,    /* IN */
+                                  gint         height,   /* IN */
+                                  gboolean     rgba)     /* IN */
+{
+	GdkColormap *colormap;
+	GdkPixmap *pixmap;
+	GdkScreen *screen;
+	PoolEntry *entry;
+	GSList *iter;
+
+	g_return_val_if_fail(GDK_IS_DRAWABLE(drawable), NULL);
+
+	screen = gdk_drawable_get_screen(drawable);
+	for (iter = free_list; iter; iter = iter->next) {
+		entry = iter->data;
+		pixmap = entry->pixmap;
+		if (gdk_drawable_get_screen(GDK_DRAWABLE(pixmap)) == screen &&
+		    uber_surface_pool_pixmap_fits(pixmap, width, height, rgba)) {
+			free_list = g_slist_delete_link(free_list, iter);
+			free_bytes -= entry->bytes;
+			g_slice_free(PoolEntry, entry);
+			return pixmap;
+		}
+	}
+	uber_surface_pool_watch_display(screen);
+	width = uber_surface_pool_round(width);
+	height = uber_surface_pool_round(height);
+	colormap = rgba ? gdk_screen_get_rgba_colormap(screen) : NULL;
+	if (colormap) {
+		pixmap = gdk_pixmap_new(NULL, width, height, 32);
+		gdk_drawable_set_colormap(GDK_DRAWABLE(pixmap), colormap);
+	} else {
+		pixmap = gdk_pixmap_new(drawable, width, height, -1);
+	}
+	return pixmap;
+}
+
+/**
+ * uber_surface_pool_release_pixmap:
+ * @pixmap: A #GdkPixmap from uber_surface_pool_acquire_pixmap().
+ *
+ * Returns @pixmap to the pool.  Only the most recently released pixmaps
+ * are kept, up to MAX_BYTES, and only for MAX_AGE seconds; older ones are
+ * freed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_surface_pool_release_pixmap (GdkPixmap *pixmap) /* IN */
+{
+	PoolEntry *entry;
+	gint width;
+	gint height;
+
+	g_return_if_fail(GDK_IS_PIXMAP(pixmap));
+
+	gdk_drawable_get_size(GDK_DRAWABLE(pixmap), &width, &height);
+	entry = g_slice_new(PoolEntry);
+	entry->pixmap = pixmap;
+	entry->bytes = (gsize)width * height
+	             * MAX(1, gdk_drawable_get_depth(GDK_DRAWABLE(pixmap)) / 8);
+	entry->released = g_get_monotonic_time();
+	free_list = g_slist_prepend(free_list, entry);
+	free_bytes += entry->bytes;
+	uber_surface_pool_trim(0);
+	if (free_list && !expire_id) {
+		expire_id = g_timeout_add_seconds(1, uber_surface_pool_expire, NULL);
+	}
+}
+
+/**
+ * uber_surface_pool_clear:
+ *
+ * Frees all of the pixmaps waiting to be reused.  This is done
+ * automatically when a display the pool allocated pixmaps on is closed.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_surface_pool_clear (void)
+{
+	g_slist_foreach(free_list, (GFunc)uber_surface_pool_free_entry, NULL);
+	g_slist_free(free_list);
+	free_list = NULL;
+	if (expire_id) {
+		g_source_remove(expire_id);
+		expire_id = 0;
+	}
+}
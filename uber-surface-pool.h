@@ -0,0 +1,39 @@
+/* uber-surface-pool.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_SURFACE_POOL_H__
+#define __UBER_SURFACE_POOL_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+GdkPixmap* uber_surface_pool_acquire_pixmap (GdkDrawable *drawable,
+                                             gint         width,
+                                             gint         height,
+                                             gboolean     rgba);
+void       uber_surface_pool_release_pixmap (GdkPixmap   *pixmap);
+gboolean   uber_surface_pool_pixmap_fits    (GdkPixmap   *pixmap,
+                                             gint         width,
+                                             gint         height,
+                                             gboolean     rgba);
+void       uber_surface_pool_clear          (void);
+
+G_END_DECLS
+
+#endif /* __UBER_SURFACE_POOL_H__ */
@@ -0,0 +1,260 @@
+/* uber-text-cache.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-text-cache.h"
+
+#define MAX_ENTRIES (512)
+
+/**
+ * SECTION:uber-text-cache
+ * @title: UberTextCache
+ * @short_description: Process-wide cache of pre-rendered label text.
+ *
+ * Axis labels are a small set of strings which are drawn over and over
+ * again each time a background is re-rendered.  Laying out each of them
+ * with Pango is far more expensive than the blit itself, so the text
+ * cache renders each (markup, font, scale) tuple once into an A8 mask and
+ * keeps it for the life of the process.  Drawing a cached label is a
+ * single cairo_mask_surface() using the current source of the context.
+ *
+ * The cache is only to be used from the GUI thread.  If it grows beyond
+ * a few hundred entries, such as after many autoscale changes, it is
+ * simply flushed and rebuilt on demand.
+ */
+
+typedef struct
+{
+	gchar                *markup; /* Pango markup of the text. */
+	PangoFontDescription *font;   /* Font the text is rendered with. */
+	gdouble               scale;  /* Device scale. */
+} TextKey;
+
+typedef struct
+{
+	TextKey  key;
+	UberText text;
+} TextEntry;
+
+static GHashTable  *entries      = NULL;
+static PangoLayout *layout       = NULL;
+static cairo_t     *measure_cr   = NULL;
+
+/**
+ * uber_text_cache_key_hash:
+ * @data: A TextKey.
+ *
+ * Hashes a TextKey for the cache hashtable.
+ *
+ * Returns: The hash of the key.
+ * Side effects: None.
+ */
+static guint
+uber_text_cache_key_hash (gconstpointer data) /* IN */
+{
+	const TextKey *key = data;
+
+	return g_str_hash(key->markup)
+	     ^ pango_font_description_hash(key->font)
+	     ^ (guint)(key->scale * 1000.);
+}
+
+/**
+ * uber_text_cache_key_equal:
+ * @a: A TextKey.
+ * @b: A TextKey.
+ *
+ * Compares two TextKeys for equality.
+ *
+ * Returns: %TRUE if the keys are equal; otherwise %FALSE.
+ * Side effects: None.
+ */
+static gboolean
+uber_text_cache_key_equal (gconstpointer a, /* IN */
+                           gconstpointer b) /* IN */
+{
+	const TextKey *ka = a;
+	const TextKey *kb = b;
+
+	return (ka->scale == kb->scale) &&
+	       (strcmp(ka->markup, kb->markup) == 0) &&
+	       pango_font_description_equal(ka->font, kb->font);
+}
+
+/**
+ * uber_text_cache_entry_free:
+ * @data: A TextEntry.
+ *
+ * Frees a cache entry and its surface.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_text_cache_entry_free (gpointer data) /* IN */
+{
+	TextEntry *entry = data;
+
+	g_free(entry->key.markup);
+	pango_font_description_free(entry->key.font);
+	cairo_surface_destroy(entry->text.surface);
+	g_slice_free(TextEntry, entry);
+}
+
+/**
+ * uber_text_cache_render:
+ * @entry: A TextEntry.
+ *
+ * Measures the text described by the entry key and renders it into a new
+ * A8 surface.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_text_cache_render (TextEntry *entry) /* IN */
+{
+	cairo_t *cr;
+	gint width;
+	gint height;
+
+	pango_layout_set_font_description(layout, entry->key.font);
+	pango_layout_set_markup(layout, entry->key.markup, -1);
+	pango_layout_get_pixel_size(layout, &width, &height);
+	entry->text.width = width;
+	entry->text.height = height;
+	entry->text.scale = entry->key.scale;
+	entry->text.surface =
+		cairo_image_surface_create(CAIRO_FORMAT_A8,
+		                           MAX(1, ceil(width * entry->key.scale)),
+		                           MAX(1, ceil(height * entry->key.scale)));
+	cr = cairo_create(entry->text.surface);
+	cairo_scale(cr, entry->key.scale, entry->key.scale);
+	pango_cairo_update_layout(cr, layout);
+	pango_cairo_show_layout(cr, layout);
+	cairo_destroy(cr);
+}
+
+/**
+ * uber_text_cache_lookup:
+ * @markup: Pango markup for the text.
+ * @font: The font to render the text with.
+ * @scale: The device scale to render for, usually 1.
+ *
+ * Retrieves the pre-rendered text for @markup, rendering it if this is the
+ * first time it has been requested.
+ *
+ * Returns: An #UberText owned by the cache.  It is valid until the next
+ *   call to uber_text_cache_lookup() or uber_text_cache_clear().
+ * Side effects: The text is rendered and cached on first use.
+ */
+const UberText*
+uber_text_cache_lookup (const gchar                *markup, /* IN */
+                        const PangoFontDescription *font,   /* IN */
+                        gdouble                     scale)  /* IN */
+{
+	cairo_surface_t *surface;
+	TextEntry *entry;
+	TextKey key;
+
+	g_return_val_if_fail(markup != NULL, NULL);
+	g_return_val_if_fail(font != NULL, NULL);
+	g_return_val_if_fail(scale > 0., NULL);
+
+	if (G_UNLIKELY(!entries)) {
+		entries = g_hash_table_new_full(uber_text_cache_key_hash,
+		                                uber_text_cache_key_equal,
+		                                NULL,
+		                                uber_text_cache_entry_free);
+		surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+		measure_cr = cairo_create(surface);
+		cairo_surface_destroy(surface);
+		layout = pango_cairo_create_layout(measure_cr);
+	}
+	key.markup = (gchar *)markup;
+	key.font = (PangoFontDescription *)font;
+	key.scale = scale;
+	if ((entry = g_hash_table_lookup(entries, &key))) {
+		return &entry->text;
+	}
+	if (g_hash_table_size(entries) >= MAX_ENTRIES) {
+		g_hash_table_remove_all(entries);
+	}
+	entry = g_slice_new0(TextEntry);
+	entry->key.markup = g_strdup(markup);
+	entry->key.font = pango_font_description_copy(font);
+	entry->key.scale = scale;
+	uber_text_cache_render(entry);
+	g_hash_table_insert(entries, &entry->key, entry);
+	return &entry->text;
+}
+
+/**
+ * uber_text_cache_show:
+ * @cr: A #cairo_t.
+ * @text: An #UberText from uber_text_cache_lookup().
+ * @x: The left edge of the text.
+ * @y: The top edge of the text.
+ *
+ * Draws @text at @x,@y using the current source of @cr, just as
+ * pango_cairo_show_layout() would.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_text_cache_show (cairo_t        *cr,   /* IN */
+                      const UberText *text, /* IN */
+                      gdouble         x,    /* IN */
+                      gdouble         y)    /* IN */
+{
+	g_return_if_fail(cr != NULL);
+	g_return_if_fail(text != NULL);
+
+	if (text->scale == 1.) {
+		cairo_mask_surface(cr, text->surface, x, y);
+		return;
+	}
+	cairo_save(cr);
+	cairo_translate(cr, x, y);
+	cairo_scale(cr, 1. / text->scale, 1. / text->scale);
+	cairo_mask_surface(cr, text->surface, 0, 0);
+	cairo_restore(cr);
+}
+
+/**
+ * uber_text_cache_clear:
+ *
+ * Releases all of the cached text, such as after a font or theme change.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_text_cache_clear (void)
+{
+	if (entries) {
+		g_hash_table_remove_all(entries);
+	}
+}
@@ -0,0 +1,56 @@
+/* uber-text-cache.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_TEXT_CACHE_H__
+#define __UBER_TEXT_CACHE_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _UberText UberText;
+
+/**
+ * UberText:
+ * @surface: An A8 image surface containing the rendered glyphs.
+ * @width: The width of the text in user space pixels.
+ * @height: The height of the text in user space pixels.
+ * @scale: The device scale @surface was rendered for.
+ *
+ * A pre-rendered run of text owned by the text cache.
+ */
+struct _UberText
+{
+	cairo_surface_t *surface;
+	gint             width;
+	gint             height;
+	gdouble          scale;
+};
+
+const UberText* uber_text_cache_lookup (const gchar                *markup,
+                                        const PangoFontDescription *font,
+                                        gdouble                     scale);
+void            uber_text_cache_show   (cairo_t                    *cr,
+                                        const UberText             *text,
+                                        gdouble                     x,
+                                        gdouble                     y);
+void            uber_text_cache_clear  (void);
+
+G_END_DECLS
+
+#endif /* __UBER_TEXT_CACHE_H__ */